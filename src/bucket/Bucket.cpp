@@ -22,18 +22,21 @@
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Thread.h"
 #include "util/TmpDir.h"
 #include "util/XDRStream.h"
 #include "xdrpp/message.h"
 #include <Tracy.hpp>
+#include <algorithm>
 #include <fmt/format.h>
 #include <future>
 
 namespace stellar
 {
 
-Bucket::Bucket(std::string const& filename, Hash const& hash)
-    : mFilename(filename), mHash(hash)
+Bucket::Bucket(std::string const& filename, Hash const& hash,
+               std::unique_ptr<BucketIndex const> index)
+    : mFilename(filename), mHash(hash), mIndex(std::move(index))
 {
     releaseAssert(filename.empty() || fs::exists(filename));
     if (!filename.empty())
@@ -66,6 +69,37 @@ Bucket::getSize() const
     return mSize;
 }
 
+bool
+Bucket::isIndexed() const
+{
+    return mFilename.empty() || mIndex;
+}
+
+std::optional<BucketEntry>
+Bucket::getBucketEntry(LedgerKey const& k) const
+{
+    if (mFilename.empty())
+    {
+        return std::nullopt;
+    }
+    if (!mIndex)
+    {
+        throw std::logic_error("bucket is not indexed");
+    }
+    if (!mIndex->mayContain(k))
+    {
+        return std::nullopt;
+    }
+
+    std::lock_guard<std::mutex> guard(mIndexStreamMutex);
+    if (!mIndexStream)
+    {
+        mIndexStream = std::make_unique<XDRInputFileStream>();
+        mIndexStream->open(mFilename);
+    }
+    return mIndex->lookup(*mIndexStream, k);
+}
+
 bool
 Bucket::containsBucketIdentity(BucketEntry const& id) const
 {
@@ -355,13 +389,12 @@ countNewEntryType(MergeCounters& mc, BucketEntry const& e)
 // shadows from then on in, so they all upgrade (and preserve lifecycle events).
 static void
 calculateMergeProtocolVersion(
-    MergeCounters& mc, uint32_t maxProtocolVersion,
-    BucketInputIterator const& oi, BucketInputIterator const& ni,
+    MergeCounters& mc, uint32_t maxProtocolVersion, uint32_t oldVersion,
+    uint32_t newVersion,
     std::vector<BucketInputIterator> const& shadowIterators,
     uint32& protocolVersion, bool& keepShadowedLifecycleEntries)
 {
-    protocolVersion = std::max(oi.getMetadata().ledgerVersion,
-                               ni.getMetadata().ledgerVersion);
+    protocolVersion = std::max(oldVersion, newVersion);
 
     // Starting with FIRST_PROTOCOL_SHADOWS_REMOVED,
     // protocol version is determined as a max of curr, snap, and any shadow of
@@ -591,13 +624,232 @@ mergeCasesWithEqualKeys(MergeCounters& mc, BucketInputIterator& oi,
     ++ni;
 }
 
+static void
+mergeRange(BucketManager& bucketManager, MergeCounters& mc,
+           BucketInputIterator& oi, BucketInputIterator& ni,
+           BucketOutputIterator& out,
+           std::vector<BucketInputIterator>& shadowIterators,
+           uint32_t protocolVersion, bool keepShadowedLifecycleEntries)
+{
+    BucketEntryIdCmp cmp;
+    size_t iter = 0;
+
+    while (oi || ni)
+    {
+        // Check if the merge should be stopped every few entries
+        if (++iter >= 1000)
+        {
+            iter = 0;
+            if (bucketManager.isShutdown())
+            {
+                // Stop merging, as BucketManager is now shutdown
+                // This is safe as temp file has not been adopted yet,
+                // so it will be removed with the tmp dir
+                throw std::runtime_error(
+                    "Incomplete bucket merge due to BucketManager shutdown");
+            }
+        }
+
+        if (!mergeCasesWithDefaultAcceptance(cmp, mc, oi, ni, out,
+                                             shadowIterators, protocolVersion,
+                                             keepShadowedLifecycleEntries))
+        {
+            mergeCasesWithEqualKeys(mc, oi, ni, out, shadowIterators,
+                                    protocolVersion,
+                                    keepShadowedLifecycleEntries);
+        }
+    }
+}
+
+// A record of a bucket file, and its offset in the file.
+// Samples per key range when splitting a merge, enough that ranges come out
+// roughly even.
+static size_t const MERGE_SAMPLES_PER_RANGE = 64;
+
+struct BucketSample
+{
+    size_t mPos;
+    BucketEntry mEntry;
+};
+
+// Decodes roughly `n` records of a bucket, evenly spaced by file offset, and
+// skips over the rest without decoding them. The first non-META record is
+// always sampled, and the METAENTRY never is; its ledger version goes to
+// `ledgerVersion` (0 if there is none, as with BucketInputIterator).
+static std::vector<BucketSample>
+sampleBucket(std::shared_ptr<Bucket> const& bucket, size_t n,
+             uint32_t& ledgerVersion)
+{
+    ZoneScoped;
+    std::vector<BucketSample> samples;
+    ledgerVersion = 0;
+    if (bucket->getFilename().empty())
+    {
+        return samples;
+    }
+
+    XDRInputFileStream in;
+    in.open(bucket->getFilename());
+    size_t const step = std::max<size_t>(1, bucket->getSize() / n);
+    size_t nextSample = 0;
+    BucketEntry be;
+    while (true)
+    {
+        size_t pos = in.pos();
+        if (pos >= nextSample)
+        {
+            if (!in.readOne(be))
+            {
+                break;
+            }
+            if (be.type() == METAENTRY)
+            {
+                ledgerVersion = be.metaEntry().ledgerVersion;
+            }
+            else
+            {
+                samples.emplace_back(BucketSample{pos, be});
+                nextSample = pos + step;
+            }
+        }
+        else if (!in.skipOne())
+        {
+            break;
+        }
+    }
+    return samples;
+}
+
+// Offset of the first record of `bucket` whose key is not less than `bound`
+// (or the end of the file, if there is none). The samples narrow the search
+// down to the records between two samples.
+static size_t
+findRangeStart(std::shared_ptr<Bucket> const& bucket,
+               std::vector<BucketSample> const& samples,
+               BucketEntry const& bound)
+{
+    BucketEntryIdCmp cmp;
+    auto it = std::lower_bound(samples.begin(), samples.end(), bound,
+                               [&](BucketSample const& s, BucketEntry const& e) {
+                                   return cmp(s.mEntry, e);
+                               });
+    if (it == samples.begin())
+    {
+        return samples.empty() ? bucket->getSize() : it->mPos;
+    }
+
+    XDRInputFileStream in;
+    in.open(bucket->getFilename());
+    in.seek(std::prev(it)->mPos);
+    BucketEntry be;
+    while (true)
+    {
+        size_t pos = in.pos();
+        if (!in.readOne(be))
+        {
+            return bucket->getSize();
+        }
+        if (!cmp(be, bound))
+        {
+            return pos;
+        }
+    }
+}
+
+// Splits a shadow-free merge into up to `numRanges` disjoint key ranges, with
+// boundaries taken from samples of both inputs, and merges the ranges in
+// parallel, each into its own (unhashed) output file. The range files are then
+// copied in key order onto `out`, which hashes them as it goes; since the
+// merge of a key range only depends on the entries in that range, the final
+// file is byte-identical to a serial merge.
+static void
+mergeInRanges(BucketManager& bucketManager, MergeCounters& mc,
+              std::shared_ptr<Bucket> const& oldBucket,
+              std::vector<BucketSample> const& oldSamples,
+              std::shared_ptr<Bucket> const& newBucket,
+              std::vector<BucketSample> const& newSamples,
+              BucketOutputIterator& out, BucketMetadata const& meta,
+              bool keepDeadEntries, bool keepShadowedLifecycleEntries,
+              uint32_t numRanges, asio::io_context& ctx)
+{
+    ZoneScoped;
+    BucketEntryIdCmp cmp;
+    std::vector<BucketEntry> all;
+    all.reserve(oldSamples.size() + newSamples.size());
+    for (auto const& s : oldSamples)
+    {
+        all.emplace_back(s.mEntry);
+    }
+    for (auto const& s : newSamples)
+    {
+        all.emplace_back(s.mEntry);
+    }
+    std::sort(all.begin(), all.end(), cmp);
+
+    std::vector<BucketEntry> bounds;
+    for (uint32_t i = 1; i < numRanges && !all.empty(); ++i)
+    {
+        auto const& b = all.at(i * all.size() / numRanges);
+        if (bounds.empty() || cmp(bounds.back(), b))
+        {
+            bounds.emplace_back(b);
+        }
+    }
+
+    auto firstRecord = [](std::shared_ptr<Bucket> const& bucket,
+                          std::vector<BucketSample> const& samples) {
+        return samples.empty() ? bucket->getSize() : samples.front().mPos;
+    };
+    std::vector<size_t> oldStarts{firstRecord(oldBucket, oldSamples)};
+    std::vector<size_t> newStarts{firstRecord(newBucket, newSamples)};
+    for (auto const& b : bounds)
+    {
+        oldStarts.emplace_back(findRangeStart(oldBucket, oldSamples, b));
+        newStarts.emplace_back(findRangeStart(newBucket, newSamples, b));
+    }
+    oldStarts.emplace_back(oldBucket->getSize());
+    newStarts.emplace_back(newBucket->getSize());
+
+    size_t const n = bounds.size() + 1;
+    CLOG_DEBUG(Bucket, "Merging {} with {} in {} key ranges",
+               hexAbbrev(oldBucket->getHash()), hexAbbrev(newBucket->getHash()),
+               n);
+
+    std::vector<MergeCounters> rangeCounters(n);
+    std::vector<std::unique_ptr<BucketOutputIterator>> rangeOuts;
+    for (size_t i = 0; i < n; ++i)
+    {
+        rangeOuts.emplace_back(std::make_unique<BucketOutputIterator>(
+            bucketManager.getTmpDir(), keepDeadEntries, meta, rangeCounters[i],
+            ctx, /*doFsync=*/false, /*isRange=*/true));
+    }
+
+    // Ranges beyond the process-wide helper budget run on this thread.
+    parallelFor(n, n - 1, [&](size_t i) {
+        ZoneNamedN(rangeZone, "Merge key range", true);
+        BucketInputIterator oi(oldBucket);
+        BucketInputIterator ni(newBucket);
+        oi.restrictToRange(oldStarts[i], oldStarts[i + 1]);
+        ni.restrictToRange(newStarts[i], newStarts[i + 1]);
+        std::vector<BucketInputIterator> noShadows;
+        mergeRange(bucketManager, rangeCounters[i], oi, ni, *rangeOuts[i],
+                   noShadows, meta.ledgerVersion, keepShadowedLifecycleEntries);
+    });
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        out.appendRange(*rangeOuts[i]);
+        mc += rangeCounters[i];
+    }
+}
+
 std::shared_ptr<Bucket>
 Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
               std::shared_ptr<Bucket> const& oldBucket,
               std::shared_ptr<Bucket> const& newBucket,
               std::vector<std::shared_ptr<Bucket>> const& shadows,
               bool keepDeadEntries, bool countMergeEvents,
-              asio::io_context& ctx, bool doFsync)
+              asio::io_context& ctx, bool doFsync, uint32_t numRanges)
 {
     ZoneScoped;
     // This is the key operation in the scheme: merging two (read-only)
@@ -608,15 +860,40 @@ Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
     releaseAssert(newBucket);
 
     MergeCounters mc;
-    BucketInputIterator oi(oldBucket);
-    BucketInputIterator ni(newBucket);
     std::vector<BucketInputIterator> shadowIterators(shadows.begin(),
                                                      shadows.end());
 
+    // Shadows would have to be split along with the inputs; merges that
+    // still use them are small enough to run serially anyway.
+    bool const ranged = numRanges > 1 && shadowIterators.empty();
+
+    // The ranged merge opens its own iterators per range, and reads the
+    // input versions while sampling; only the serial merge needs these.
+    std::optional<BucketInputIterator> oi;
+    std::optional<BucketInputIterator> ni;
+    std::vector<BucketSample> oldSamples;
+    std::vector<BucketSample> newSamples;
+    uint32_t oldVersion;
+    uint32_t newVersion;
+    if (ranged)
+    {
+        // Enough samples per range that ranges come out roughly even.
+        size_t const numSamples = numRanges * MERGE_SAMPLES_PER_RANGE;
+        oldSamples = sampleBucket(oldBucket, numSamples, oldVersion);
+        newSamples = sampleBucket(newBucket, numSamples, newVersion);
+    }
+    else
+    {
+        oi.emplace(oldBucket);
+        ni.emplace(newBucket);
+        oldVersion = oi->getMetadata().ledgerVersion;
+        newVersion = ni->getMetadata().ledgerVersion;
+    }
+
     uint32_t protocolVersion;
     bool keepShadowedLifecycleEntries;
-    calculateMergeProtocolVersion(mc, maxProtocolVersion, oi, ni,
-                                  shadowIterators, protocolVersion,
+    calculateMergeProtocolVersion(mc, maxProtocolVersion, oldVersion,
+                                  newVersion, shadowIterators, protocolVersion,
                                   keepShadowedLifecycleEntries);
 
     auto timer = bucketManager.getMergeTimer().TimeScope();
@@ -625,34 +902,18 @@ Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
     BucketOutputIterator out(bucketManager.getTmpDir(), keepDeadEntries, meta,
                              mc, ctx, doFsync);
 
-    BucketEntryIdCmp cmp;
-    size_t iter = 0;
-
-    while (oi || ni)
+    if (ranged)
     {
-        // Check if the merge should be stopped every few entries
-        if (++iter >= 1000)
-        {
-            iter = 0;
-            if (bucketManager.isShutdown())
-            {
-                // Stop merging, as BucketManager is now shutdown
-                // This is safe as temp file has not been adopted yet,
-                // so it will be removed with the tmp dir
-                throw std::runtime_error(
-                    "Incomplete bucket merge due to BucketManager shutdown");
-            }
-        }
-
-        if (!mergeCasesWithDefaultAcceptance(cmp, mc, oi, ni, out,
-                                             shadowIterators, protocolVersion,
-                                             keepShadowedLifecycleEntries))
-        {
-            mergeCasesWithEqualKeys(mc, oi, ni, out, shadowIterators,
-                                    protocolVersion,
-                                    keepShadowedLifecycleEntries);
-        }
+        mergeInRanges(bucketManager, mc, oldBucket, oldSamples, newBucket,
+                      newSamples, out, meta, keepDeadEntries,
+                      keepShadowedLifecycleEntries, numRanges, ctx);
     }
+    else
+    {
+        mergeRange(bucketManager, mc, *oi, *ni, out, shadowIterators,
+                   protocolVersion, keepShadowedLifecycleEntries);
+    }
+
     if (countMergeEvents)
     {
         bucketManager.incrMergeCounters(mc);
@@ -4,11 +4,14 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "bucket/BucketIndex.h"
 #include "bucket/LedgerCmp.h"
 #include "crypto/Hex.h"
 #include "overlay/StellarXDR.h"
 #include "util/NonCopyable.h"
 #include "util/XDRStream.h"
+#include <mutex>
+#include <optional>
 #include <string>
 
 namespace stellar
@@ -37,6 +40,12 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     std::string const mFilename;
     Hash const mHash;
     size_t mSize{0};
+    std::unique_ptr<BucketIndex const> const mIndex;
+
+    // Kept open across getBucketEntry calls, so point lookups don't reopen
+    // the bucket file each time. Opened on first use.
+    mutable std::mutex mIndexStreamMutex;
+    mutable std::unique_ptr<XDRInputFileStream> mIndexStream;
 
   public:
     // Create an empty bucket. The empty bucket has hash '000000...' and its
@@ -46,12 +55,21 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     // Construct a bucket with a given filename and hash. Asserts that the file
     // exists, but does not check that the hash is the bucket's hash. Caller
     // needs to ensure that.
-    Bucket(std::string const& filename, Hash const& hash);
+    Bucket(std::string const& filename, Hash const& hash,
+           std::unique_ptr<BucketIndex const> index = nullptr);
 
     Hash const& getHash() const;
     std::string const& getFilename() const;
     size_t getSize() const;
 
+    // Whether getBucketEntry can be used. The empty bucket counts as indexed.
+    bool isIndexed() const;
+
+    // The entry (live, init or dead) for k in this bucket, if any. Reads the
+    // bucket file, using the index to scan at most one page. Throws if the
+    // bucket is not indexed. Thread-safe.
+    std::optional<BucketEntry> getBucketEntry(LedgerKey const& k) const;
+
     // Returns true if a BucketEntry that is key-wise identical to the given
     // BucketEntry exists in the bucket. For testing.
     bool containsBucketIdentity(BucketEntry const& id) const;
@@ -100,13 +118,17 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     // `maxProtocolVersion` bounds this (for error checking) and should usually
     // be the protocol of the ledger header at which the merge is starting. An
     // exception will be thrown if any provided bucket versions exceed it.
+    //
+    // With `numRanges` > 1, a merge without shadows is split into up to that
+    // many key ranges which are merged in parallel. The output is identical
+    // to a serial merge.
     static std::shared_ptr<Bucket>
     merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
           std::shared_ptr<Bucket> const& oldBucket,
           std::shared_ptr<Bucket> const& newBucket,
           std::vector<std::shared_ptr<Bucket>> const& shadows,
           bool keepDeadEntries, bool countMergeEvents, asio::io_context& ctx,
-          bool doFsync);
+          bool doFsync, uint32_t numRanges = 1);
 
     static uint32_t getBucketVersion(std::shared_ptr<Bucket> const& bucket);
 };
@@ -0,0 +1,148 @@
+#include "bucket/BucketIndex.h"
+#include "bucket/LedgerCmp.h"
+#include "ledger/LedgerHashUtils.h"
+#include "util/GlobalChecks.h"
+#include "util/XDRStream.h"
+#include "util/types.h"
+#include <Tracy.hpp>
+
+#include <algorithm>
+
+namespace stellar
+{
+
+namespace
+{
+LedgerKey
+getBucketLedgerKey(BucketEntry const& be)
+{
+    switch (be.type())
+    {
+    case LIVEENTRY:
+    case INITENTRY:
+        return LedgerEntryKey(be.liveEntry());
+    case DEADENTRY:
+        return be.deadEntry();
+    default:
+        throw std::runtime_error("no ledger key for bucket entry type");
+    }
+}
+
+// Second hash for double hashing, derived from the first.
+size_t
+remix(size_t h)
+{
+    uint64_t x = h;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x | 1);
+}
+}
+
+std::unique_ptr<BucketIndex const>
+BucketIndex::build(std::string const& filename)
+{
+    ZoneScoped;
+    std::unique_ptr<BucketIndex> index(new BucketIndex());
+
+    XDRInputFileStream in;
+    in.open(filename);
+
+    std::vector<size_t> keyHashes;
+    BucketEntry be;
+    size_t pos = in.pos();
+    while (in.readOne(be))
+    {
+        if (be.type() != METAENTRY)
+        {
+            auto k = getBucketLedgerKey(be);
+            if (keyHashes.size() % PAGE_SIZE == 0)
+            {
+                index->mPages.emplace_back(k, pos);
+            }
+            keyHashes.emplace_back(std::hash<LedgerKey>()(k));
+        }
+        pos = in.pos();
+    }
+
+    size_t numBits = std::max<size_t>(64, keyHashes.size() * BLOOM_BITS_PER_KEY);
+    index->mBloomBits.resize((numBits + 63) / 64, 0);
+    for (auto h : keyHashes)
+    {
+        index->addToBloomFilter(h);
+    }
+    return index;
+}
+
+void
+BucketIndex::addToBloomFilter(size_t keyHash)
+{
+    size_t numBits = mBloomBits.size() * 64;
+    size_t step = remix(keyHash);
+    for (size_t i = 0; i < BLOOM_NUM_HASHES; ++i)
+    {
+        size_t bit = (keyHash + i * step) % numBits;
+        mBloomBits[bit / 64] |= (uint64_t(1) << (bit % 64));
+    }
+}
+
+bool
+BucketIndex::mayContain(LedgerKey const& k) const
+{
+    size_t keyHash = std::hash<LedgerKey>()(k);
+    size_t numBits = mBloomBits.size() * 64;
+    size_t step = remix(keyHash);
+    for (size_t i = 0; i < BLOOM_NUM_HASHES; ++i)
+    {
+        size_t bit = (keyHash + i * step) % numBits;
+        if (!(mBloomBits[bit / 64] & (uint64_t(1) << (bit % 64))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<BucketEntry>
+BucketIndex::lookup(XDRInputFileStream& in, LedgerKey const& k) const
+{
+    ZoneScoped;
+    if (!mayContain(k))
+    {
+        return std::nullopt;
+    }
+
+    LedgerEntryIdCmp cmp;
+
+    // the last page whose first key is <= k
+    auto page = std::upper_bound(
+        mPages.begin(), mPages.end(), k,
+        [&cmp](LedgerKey const& key, std::pair<LedgerKey, size_t> const& p) {
+            return cmp(key, p.first);
+        });
+    if (page == mPages.begin())
+    {
+        return std::nullopt;
+    }
+    --page;
+
+    in.seek(page->second);
+
+    BucketEntry be;
+    for (size_t i = 0; i < PAGE_SIZE && in.readOne(be); ++i)
+    {
+        auto entryKey = getBucketLedgerKey(be);
+        if (cmp(entryKey, k))
+        {
+            continue;
+        }
+        if (cmp(k, entryKey))
+        {
+            break;
+        }
+        return std::make_optional(be);
+    }
+    return std::nullopt;
+}
+}
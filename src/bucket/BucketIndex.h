@@ -0,0 +1,61 @@
+#pragma once
+
+#include "util/NonCopyable.h"
+#include "util/XDRStream.h"
+#include "xdr/Stellar-ledger.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+/**
+ * Sparse index over a bucket file, for point lookups by LedgerKey.
+ *
+ * Records the key and file offset of every PAGE_SIZE-th entry, and adds
+ * every key to a bloom filter. A lookup that gets past the filter seeks to
+ * the one page that could hold the key, and reads at most PAGE_SIZE
+ * entries.
+ */
+class BucketIndex : public NonMovableOrCopyable
+{
+  public:
+    static constexpr size_t PAGE_SIZE = 16;
+    static constexpr size_t BLOOM_BITS_PER_KEY = 10;
+    static constexpr size_t BLOOM_NUM_HASHES = 7;
+
+    // Scans the complete, sorted bucket file at filename.
+    static std::unique_ptr<BucketIndex const>
+    build(std::string const& filename);
+
+    // False means k is certainly not in the bucket.
+    bool mayContain(LedgerKey const& k) const;
+
+    // The entry for k, if any. in must be open on a file with the same
+    // contents the index was built from (the bucket may have been renamed
+    // since); lookup seeks it to the page that could hold k.
+    std::optional<BucketEntry> lookup(XDRInputFileStream& in,
+                                      LedgerKey const& k) const;
+
+    size_t
+    numPages() const
+    {
+        return mPages.size();
+    }
+
+  private:
+    BucketIndex() = default;
+
+    // first key of each page, and its offset in the file
+    std::vector<std::pair<LedgerKey, size_t>> mPages;
+
+    std::vector<uint64_t> mBloomBits;
+
+    void addToBloomFilter(size_t keyHash);
+};
+
+}
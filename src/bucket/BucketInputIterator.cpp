@@ -4,6 +4,7 @@
 
 #include "bucket/BucketInputIterator.h"
 #include "bucket/Bucket.h"
+#include "util/GlobalChecks.h"
 #include <Tracy.hpp>
 
 namespace stellar
@@ -16,6 +17,11 @@ void
 BucketInputIterator::loadEntry()
 {
     ZoneScoped;
+    if (mEndPos && mIn.pos() >= *mEndPos)
+    {
+        mEntryPtr = nullptr;
+        return;
+    }
     if (mIn.readOne(mEntry))
     {
         mEntryPtr = &mEntry;
@@ -106,6 +112,20 @@ BucketInputIterator::BucketInputIterator(std::shared_ptr<Bucket const> bucket)
     }
 }
 
+void
+BucketInputIterator::restrictToRange(size_t startPos, size_t endPos)
+{
+    releaseAssert(startPos <= endPos);
+    releaseAssert(endPos <= size());
+    mEndPos = endPos;
+    if (mBucket->getFilename().empty())
+    {
+        return;
+    }
+    mIn.seek(startPos);
+    loadEntry();
+}
+
 BucketInputIterator::~BucketInputIterator()
 {
     mIn.close();
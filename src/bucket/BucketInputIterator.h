@@ -9,6 +9,7 @@
 #include "xdr/Stellar-ledger.h"
 
 #include <memory>
+#include <optional>
 
 namespace stellar
 {
@@ -24,11 +25,12 @@ class BucketInputIterator
     // pointer. If
     // non-null, it points to mEntry.
     BucketEntry const* mEntryPtr{nullptr};
-    XDRInputFileStream mIn;
+    XDRMappedInputFileStream mIn;
     BucketEntry mEntry;
     bool mSeenMetadata{false};
     bool mSeenOtherEntries{false};
     BucketMetadata mMetadata;
+    std::optional<size_t> mEndPos;
     void loadEntry();
 
   public:
@@ -54,5 +56,11 @@ class BucketInputIterator
 
     size_t pos();
     size_t size() const;
+
+    // Restricts the iterator to the records in the byte range
+    // [startPos, endPos) of the bucket file, and moves it to startPos. Both
+    // offsets must lie on record boundaries after the METAENTRY, if any. Used
+    // to merge a bucket in independent key ranges.
+    void restrictToRange(size_t startPos, size_t endPos);
 };
 }
@@ -369,6 +369,38 @@ BucketList::getHash() const
     return hsh.finish();
 }
 
+bool
+BucketList::getLedgerEntry(LedgerKey const& k,
+                           std::shared_ptr<LedgerEntry const>& out) const
+{
+    ZoneScoped;
+    for (auto const& lev : mLevels)
+    {
+        for (auto const& b : {lev.getCurr(), lev.getSnap()})
+        {
+            if (!b->isIndexed())
+            {
+                return false;
+            }
+            auto be = b->getBucketEntry(k);
+            if (be)
+            {
+                if (be->type() == DEADENTRY)
+                {
+                    out = nullptr;
+                }
+                else
+                {
+                    out = std::make_shared<LedgerEntry const>(be->liveEntry());
+                }
+                return true;
+            }
+        }
+    }
+    out = nullptr;
+    return true;
+}
+
 // levelShouldSpill is the set of boundaries at which each level should spill,
 // it's not-entirely obvious which numbers these are by inspection, so we list
 // the first 3 values it's true on each level here for reference:
@@ -402,6 +402,13 @@ class BucketList
     // of the concatenation of the hashes of the `curr` and `snap` buckets.
     Hash getHash() const;
 
+    // Look up the newest version of `k`, probing `curr` then `snap` of each
+    // level from youngest to oldest. Sets `out` to the entry, or to nullptr if
+    // the newest version is a tombstone or there is none. Returns false, and
+    // leaves `out` alone, if a bucket that had to be probed is not indexed.
+    bool getLedgerEntry(LedgerKey const& k,
+                        std::shared_ptr<LedgerEntry const>& out) const;
+
     // Restart any merges that might be running on background worker threads,
     // merging buckets between levels. This needs to be called after forcing a
     // BucketList to adopt a new state, either at application restart or when
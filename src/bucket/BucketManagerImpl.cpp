@@ -366,6 +366,15 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
 {
     ZoneScoped;
     releaseAssertOrThrow(mApp.getConfig().MODE_ENABLES_BUCKETLIST);
+
+    // Indexing scans the whole file, so do it before taking the lock. It is
+    // wasted if the bucket turns out to be redundant, but that's rare.
+    std::unique_ptr<BucketIndex const> index;
+    if (mApp.getConfig().EXPERIMENTAL_BUCKET_INDEX_READS)
+    {
+        index = BucketIndex::build(filename);
+    }
+
     std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
 
     if (mergeKey)
@@ -416,7 +425,7 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
             }
         }
 
-        b = std::make_shared<Bucket>(canonicalName, hash);
+        b = std::make_shared<Bucket>(canonicalName, hash, std::move(index));
         {
             mSharedBuckets.emplace(hash, b);
             mSharedBucketsSize.set_count(mSharedBuckets.size());
@@ -474,7 +483,14 @@ BucketManagerImpl::getBucketByHash(uint256 const& hash)
                    "BucketManager::getBucketByHash({}) found no bucket, making "
                    "new one",
                    binToHex(hash));
-        auto p = std::make_shared<Bucket>(canonicalName, hash);
+        // Only reached for buckets already on disk, mostly at startup.
+        std::unique_ptr<BucketIndex const> index;
+        if (mApp.getConfig().EXPERIMENTAL_BUCKET_INDEX_READS)
+        {
+            index = BucketIndex::build(canonicalName);
+        }
+        auto p =
+            std::make_shared<Bucket>(canonicalName, hash, std::move(index));
         mSharedBuckets.emplace(hash, p);
         mSharedBucketsSize.set_count(mSharedBuckets.size());
         return p;
@@ -8,6 +8,9 @@
 #include "crypto/Random.h"
 #include "util/GlobalChecks.h"
 #include <Tracy.hpp>
+#include <fmt/format.h>
+#include <fstream>
+#include <vector>
 
 namespace stellar
 {
@@ -39,12 +42,14 @@ BucketOutputIterator::BucketOutputIterator(std::string const& tmpDir,
                                            bool keepDeadEntries,
                                            BucketMetadata const& meta,
                                            MergeCounters& mc,
-                                           asio::io_context& ctx, bool doFsync)
+                                           asio::io_context& ctx, bool doFsync,
+                                           bool isRange)
     : mFilename(randomBucketName(tmpDir))
     , mOut(ctx, doFsync)
     , mBuf(nullptr)
     , mKeepDeadEntries(keepDeadEntries)
     , mMeta(meta)
+    , mIsRange(isRange)
     , mMergeCounters(mc)
 {
     ZoneScoped;
@@ -53,8 +58,13 @@ BucketOutputIterator::BucketOutputIterator(std::string const& tmpDir,
     // Will throw if unable to open the file
     mOut.open(mFilename);
 
-    if (meta.ledgerVersion >=
-        Bucket::FIRST_PROTOCOL_SUPPORTING_INITENTRY_AND_METAENTRY)
+    if (mIsRange)
+    {
+        // The final output carries the METAENTRY.
+        mPutMeta = true;
+    }
+    else if (meta.ledgerVersion >=
+             Bucket::FIRST_PROTOCOL_SUPPORTING_INITENTRY_AND_METAENTRY)
     {
         BucketEntry bme;
         bme.type(METAENTRY);
@@ -96,7 +106,7 @@ BucketOutputIterator::put(BucketEntry const& e)
         if (mCmp(*mBuf, e))
         {
             ++mMergeCounters.mOutputIteratorActualWrites;
-            mOut.writeOne(*mBuf, &mHasher, &mBytesPut);
+            mOut.writeOne(*mBuf, mIsRange ? nullptr : &mHasher, &mBytesPut);
             mObjectsPut++;
         }
     }
@@ -110,11 +120,70 @@ BucketOutputIterator::put(BucketEntry const& e)
     *mBuf = e;
 }
 
+void
+BucketOutputIterator::appendRange(BucketOutputIterator& range)
+{
+    ZoneScoped;
+    releaseAssert(range.mIsRange);
+    releaseAssert(!mIsRange);
+    if (range.mBuf)
+    {
+        range.mOut.writeOne(*range.mBuf, nullptr, &range.mBytesPut);
+        range.mObjectsPut++;
+        range.mBuf.reset();
+    }
+    range.mOut.close();
+    if (range.mObjectsPut == 0)
+    {
+        std::remove(range.mFilename.c_str());
+        return;
+    }
+
+    // Flush our own buffered entry (at least the METAENTRY) first.
+    if (mBuf)
+    {
+        mOut.writeOne(*mBuf, &mHasher, &mBytesPut);
+        mObjectsPut++;
+        mBuf.reset();
+    }
+
+    std::ifstream in(range.mFilename, std::ifstream::binary);
+    if (!in)
+    {
+        throw std::runtime_error(
+            fmt::format("failed to open merge range {}", range.mFilename));
+    }
+    std::vector<char> buf(1 << 20);
+    size_t copied = 0;
+    while (in)
+    {
+        in.read(buf.data(), buf.size());
+        size_t n = static_cast<size_t>(in.gcount());
+        if (n == 0)
+        {
+            break;
+        }
+        mOut.writeBytes(buf.data(), n);
+        mHasher.add(ByteSlice(buf.data(), n));
+        copied += n;
+    }
+    in.close();
+    if (copied != range.mBytesPut)
+    {
+        throw std::runtime_error(
+            fmt::format("short read of merge range {}", range.mFilename));
+    }
+    mBytesPut += copied;
+    mObjectsPut += range.mObjectsPut;
+    std::remove(range.mFilename.c_str());
+}
+
 std::shared_ptr<Bucket>
 BucketOutputIterator::getBucket(BucketManager& bucketManager,
                                 MergeKey* mergeKey)
 {
     ZoneScoped;
+    releaseAssert(!mIsRange);
     if (mBuf)
     {
         mOut.writeOne(*mBuf, &mHasher, &mBytesPut);
@@ -33,6 +33,7 @@ class BucketOutputIterator
     bool mKeepDeadEntries{true};
     BucketMetadata mMeta;
     bool mPutMeta{false};
+    bool mIsRange{false};
     MergeCounters& mMergeCounters;
 
   public:
@@ -43,12 +44,25 @@ class BucketOutputIterator
     // version new enough that it should _write_ the metadata to the stream in
     // the form of a METAENTRY; but that's not a thing the caller gets to decide
     // (or forget to do), it's handled automatically.
+    //
+    // The exception is an iterator constructed with isRange set, which writes
+    // one key range of a partitioned merge: it writes no METAENTRY and does
+    // not hash, and is finished by appending it to the final output with
+    // appendRange rather than by getBucket.
     BucketOutputIterator(std::string const& tmpDir, bool keepDeadEntries,
                          BucketMetadata const& meta, MergeCounters& mc,
-                         asio::io_context& ctx, bool doFsync);
+                         asio::io_context& ctx, bool doFsync,
+                         bool isRange = false);
 
     void put(BucketEntry const& e);
 
+    // Copies the records of a range iterator, whose keys must all follow the
+    // keys put here so far, verbatim onto the end of this output, hashing them
+    // on the way. The range's file is deleted afterwards. Appending the ranges
+    // of a merge in key order gives a byte-identical file, and so the same
+    // hash, as a serial merge.
+    void appendRange(BucketOutputIterator& range);
+
     std::shared_ptr<Bucket> getBucket(BucketManager& bucketManager,
                                       MergeKey* mergeKey = nullptr);
 };
@@ -361,11 +361,19 @@ FutureBucket::startMerge(Application& app, uint32_t maxProtocolVersion,
                 ZoneNamedN(mergeZone, "Merge task", true);
                 ZoneValueV(mergeZone, static_cast<int64_t>(level));
 
+                // Splitting small merges costs more in thread and file
+                // overhead than it saves.
+                uint32_t numRanges =
+                    curr->getSize() + snap->getSize() >=
+                            FutureBucket::MIN_BYTES_FOR_RANGED_MERGE
+                        ? app.getConfig().BUCKET_MERGE_RANGES
+                        : 1;
+
                 auto res = Bucket::merge(
                     bm, maxProtocolVersion, curr, snap, shadows,
                     BucketList::keepDeadEntries(level), countMergeEvents,
                     app.getClock().getIOContext(),
-                    !app.getConfig().DISABLE_XDR_FSYNC);
+                    !app.getConfig().DISABLE_XDR_FSYNC, numRanges);
 
                 if (res)
                 {
@@ -82,6 +82,10 @@ class FutureBucket
     void setLiveOutput(std::shared_ptr<Bucket> b);
 
   public:
+    // Merges with fewer input bytes than this always run serially, whatever
+    // BUCKET_MERGE_RANGES says.
+    static constexpr size_t MIN_BYTES_FOR_RANGED_MERGE = 64 * 1024 * 1024;
+
     FutureBucket(Application& app, std::shared_ptr<Bucket> const& curr,
                  std::shared_ptr<Bucket> const& snap,
                  std::vector<std::shared_ptr<Bucket>> const& shadows,
@@ -24,9 +24,11 @@
 #include "test/test.h"
 #include "util/Math.h"
 #include "util/Timer.h"
+#include "util/UnorderedMap.h"
 #include "xdrpp/autocheck.h"
 
 #include <deque>
+#include <optional>
 #include <sstream>
 
 using namespace stellar;
@@ -168,6 +170,92 @@ TEST_CASE("bucket list", "[bucket][bucketlist]")
     }
 }
 
+TEST_CASE("bucket list point lookups", "[bucket][bucketlist][bucketindex]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.EXPERIMENTAL_BUCKET_INDEX_READS = true;
+    for_versions_with_differing_bucket_logic(cfg, [&](Config const& cfg) {
+        Application::pointer app = createTestApplication(clock, cfg);
+        BucketList bl;
+
+        // newest version of every key ever added, nullopt if deleted
+        UnorderedMap<LedgerKey, std::optional<LedgerEntry>> model;
+        std::vector<LedgerKey> liveKeys;
+
+        for (uint32_t i = 1;
+             !app->getClock().getIOContext().stopped() && i < 70; ++i)
+        {
+            app->getClock().crank(false);
+
+            auto live = LedgerTestUtils::generateValidLedgerEntries(8);
+            std::vector<LedgerKey> dead;
+            while (dead.size() < 2 && !liveKeys.empty())
+            {
+                dead.emplace_back(liveKeys.back());
+                liveKeys.pop_back();
+            }
+            if (!liveKeys.empty())
+            {
+                // update an existing entry in place
+                auto updated = LedgerTestUtils::generateValidLedgerEntry(3);
+                updated.data = model.at(liveKeys.front())->data;
+                updated.lastModifiedLedgerSeq = i;
+                live.emplace_back(updated);
+            }
+
+            bl.addBatch(*app, i, getAppLedgerVersion(app), {}, live, dead);
+
+            for (auto const& e : live)
+            {
+                auto k = LedgerEntryKey(e);
+                if (!model.count(k))
+                {
+                    liveKeys.emplace_back(k);
+                }
+                model[k] = e;
+            }
+            for (auto const& k : dead)
+            {
+                model[k] = std::nullopt;
+            }
+        }
+
+        for (uint32_t j = 0; j < BucketList::kNumLevels; ++j)
+        {
+            REQUIRE(bl.getLevel(j).getCurr()->isIndexed());
+            REQUIRE(bl.getLevel(j).getSnap()->isIndexed());
+        }
+
+        for (auto const& [k, expected] : model)
+        {
+            std::shared_ptr<LedgerEntry const> found;
+            REQUIRE(bl.getLedgerEntry(k, found));
+            if (expected)
+            {
+                REQUIRE(found);
+                REQUIRE(*found == *expected);
+            }
+            else
+            {
+                REQUIRE(!found);
+            }
+        }
+
+        for (auto const& k :
+             LedgerTestUtils::generateValidLedgerKeysNoSpeedexConfig(20))
+        {
+            if (!model.count(k))
+            {
+                std::shared_ptr<LedgerEntry const> found =
+                    std::make_shared<LedgerEntry const>();
+                REQUIRE(bl.getLedgerEntry(k, found));
+                REQUIRE(!found);
+            }
+        }
+    });
+}
+
 TEST_CASE("bucket list shadowing pre/post proto 12", "[bucket][bucketlist]")
 {
     VirtualClock clock;
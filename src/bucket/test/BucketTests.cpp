@@ -26,6 +26,7 @@
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/Timer.h"
+#include "util/UnorderedSet.h"
 
 using namespace stellar;
 
@@ -317,6 +318,88 @@ TEST_CASE("merging bucket entries", "[bucket]")
     });
 }
 
+TEST_CASE("merges in key ranges match serial merges", "[bucket][rangedmerge]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig();
+    for_versions_with_differing_bucket_logic(cfg, [&](Config const& cfg) {
+        Application::pointer app = createTestApplication(clock, cfg);
+        auto& bm = app->getBucketManager();
+        auto vers = getAppLedgerVersion(app);
+
+        auto live = LedgerTestUtils::generateValidLedgerEntries(1000);
+        std::vector<LedgerEntry> updated, created;
+        std::vector<LedgerKey> dead;
+        for (auto const& e : live)
+        {
+            if (rand_flip())
+            {
+                dead.emplace_back(LedgerEntryKey(e));
+            }
+            else if (rand_flip())
+            {
+                auto u = LedgerTestUtils::generateValidLedgerEntry(5);
+                u.data = e.data;
+                u.lastModifiedLedgerSeq = e.lastModifiedLedgerSeq + 1;
+                updated.emplace_back(u);
+            }
+        }
+        UnorderedSet<LedgerKey> seen;
+        for (auto const& e : live)
+        {
+            seen.emplace(LedgerEntryKey(e));
+        }
+        for (auto const& e : LedgerTestUtils::generateValidLedgerEntries(300))
+        {
+            if (seen.emplace(LedgerEntryKey(e)).second)
+            {
+                created.emplace_back(e);
+            }
+        }
+
+        auto bOld = Bucket::fresh(bm, vers, {}, live, {},
+                                  /*countMergeEvents=*/false,
+                                  clock.getIOContext(), /*doFsync=*/true);
+        auto bNew = Bucket::fresh(bm, vers, created, updated, dead,
+                                  /*countMergeEvents=*/false,
+                                  clock.getIOContext(), /*doFsync=*/true);
+        auto bEmpty = std::make_shared<Bucket>();
+
+        auto check = [&](std::shared_ptr<Bucket> const& oldBucket,
+                         std::shared_ptr<Bucket> const& newBucket,
+                         bool keepDeadEntries) {
+            auto serial = Bucket::merge(
+                bm, vers, oldBucket, newBucket, /*shadows=*/{}, keepDeadEntries,
+                /*countMergeEvents=*/false, clock.getIOContext(),
+                /*doFsync=*/true);
+            for (uint32_t numRanges : {2, 3, 7, 64})
+            {
+                auto ranged = Bucket::merge(
+                    bm, vers, oldBucket, newBucket, /*shadows=*/{},
+                    keepDeadEntries, /*countMergeEvents=*/false,
+                    clock.getIOContext(), /*doFsync=*/true, numRanges);
+                REQUIRE(ranged->getHash() == serial->getHash());
+                REQUIRE(ranged->getSize() == serial->getSize());
+            }
+        };
+
+        SECTION("keeping dead entries")
+        {
+            check(bOld, bNew, true);
+        }
+        SECTION("dropping dead entries")
+        {
+            check(bOld, bNew, false);
+        }
+        SECTION("with an empty input")
+        {
+            check(bOld, bEmpty, true);
+            check(bEmpty, bNew, true);
+            check(bEmpty, bEmpty, true);
+        }
+    });
+}
+
 static LedgerEntry
 generateAccount()
 {
@@ -62,7 +62,7 @@ bool Database::gDriversRegistered = false;
 
 // smallest schema version supported
 static unsigned long const MIN_SCHEMA_VERSION = 13;
-static unsigned long const SCHEMA_VERSION = 16;
+static unsigned long const SCHEMA_VERSION = 17;
 
 // These should always match our compiled version precisely, since we are
 // using a bundled version to get access to carray(). But in case someone
@@ -215,6 +215,9 @@ Database::applySchemaUpgrade(unsigned long vers)
     case 16:
         mApp.getPersistentState().setRebuildForType(LIQUIDITY_POOL);
         break;
+    case 17:
+        mApp.getPersistentState().setRebuildForType(SPEEDEX_CONFIG);
+        break;
     default:
         throw std::runtime_error("Unknown DB schema version");
     }
@@ -1,13 +1,13 @@
 #include "herder/AccountCommutativityRequirements.h"
 #include "transactions/TransactionUtils.h"
+#include "ledger/LedgerTxnHeader.h"
 #include "ledger/TrustLineWrapper.h"
+#include "util/Logging.h"
 #include "util/types.h"
 
 namespace stellar
 {
 
-// TODO cache balances and trustline checks?
-
 // is a+b within limits
 bool
 satisfyNumericLimits(int64_t a, int64_t b)
@@ -76,6 +76,31 @@ AccountCommutativityRequirements::checkCanAddAssetRequirement(
 	return true;
 }
 
+AccountCommutativityRequirements::AssetLedgerState const&
+AccountCommutativityRequirements::getLedgerState(
+	LedgerTxnHeader& header, AbstractLedgerTxn& ltx, Asset const& asset)
+{
+	auto seq = header.current().ledgerSeq;
+	if (seq != mLedgerStateSeq) {
+		mLedgerState.clear();
+		mLedgerStateSeq = seq;
+	}
+
+	auto iter = mLedgerState.find(asset);
+	if (iter != mLedgerState.end()) {
+		return iter->second;
+	}
+
+	AssetLedgerState state {
+		.mUsable = checkTrustLine(ltx, asset) && isCommutativeTxEnabledAsset(ltx, asset),
+		.mAvailableBalance = 0
+	};
+	if (state.mUsable) {
+		state.mAvailableBalance = getAvailableBalance(header, ltx, mSourceAccount, asset);
+	}
+	return mLedgerState.emplace(asset, state).first->second;
+}
+
 void 
 AccountCommutativityRequirements::setCachedAccountHasSufficientBalanceCheck(bool res)
 {
@@ -140,20 +165,21 @@ bool
 AccountCommutativityRequirements::checkAvailableBalanceSufficesForNewRequirement(
 	LedgerTxnHeader& header, AbstractLedgerTxn& ltx, Asset asset, int64_t amount)
 {
-	if (!checkCanAddAssetRequirement(ltx, asset, amount)) {
+	auto const& state = getLedgerState(header, ltx, asset);
+	if (!state.mUsable) {
 		return false;
 	}
-	auto& currentRequirement = getRequirement(asset);
-
-	auto currentBalance = getAvailableBalance(header, ltx, mSourceAccount, asset);
 
+	auto const& currentRequirement = getRequirement(asset);
 	if (!currentRequirement) {
 		return false;
 	}
 
-	//std::printf("curBal %lld curReq %lld amount %lld", currentBalance, *currentRequirement, amount);
+	if (!satisfyNumericLimits(amount, *currentRequirement)) {
+		return false;
+	}
 
-	if (amount + *currentRequirement <= currentBalance) {
+	if (amount + *currentRequirement <= state.mAvailableBalance) {
 		return true;
 	}
 	return false;
@@ -177,18 +203,15 @@ AccountCommutativityRequirements::cleanZeroedEntries()
 
 bool 
 AccountCommutativityRequirements::checkAccountHasSufficientBalance(AbstractLedgerTxn& ltx, LedgerTxnHeader& header) {
-	if (mCacheValid)
+	if (mCacheValid && mLedgerStateSeq == header.current().ledgerSeq)
 	{
-		std::printf("result cached: %d\n", mCheckAccountResult);
+		CLOG_TRACE(Herder, "result cached: {}", mCheckAccountResult);
 		return mCheckAccountResult;
 	}
 
 	for (auto const& [asset, amount] : mRequiredAssets) {
-		if (!isCommutativeTxEnabledAsset(ltx, asset)) {
-			setCachedAccountHasSufficientBalanceCheck(false);
-			return false;
-		}
-		if (!checkTrustLine(ltx, asset)) {
+		auto const& state = getLedgerState(header, ltx, asset);
+		if (!state.mUsable) {
 			setCachedAccountHasSufficientBalanceCheck(false);
 			return false;
 		}
@@ -196,12 +219,10 @@ AccountCommutativityRequirements::checkAccountHasSufficientBalance(AbstractLedge
 			setCachedAccountHasSufficientBalanceCheck(false);
 			return false;
 		}
-		std::printf("Asset: %s Requirement: %ld Current Balance %ld\n", 
-			assetToString(asset).c_str(), 
-			*amount, 
-			getAvailableBalance(header, ltx, mSourceAccount, asset));
+		CLOG_TRACE(Herder, "Asset: {} Requirement: {} Current Balance {}",
+			assetToString(asset), *amount, state.mAvailableBalance);
 
-		if (*amount > getAvailableBalance(header, ltx, mSourceAccount, asset)) {
+		if (*amount > state.mAvailableBalance) {
 			setCachedAccountHasSufficientBalanceCheck(false);
 			return false;
 		}
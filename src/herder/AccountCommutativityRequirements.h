@@ -32,6 +32,24 @@ class AccountCommutativityRequirements {
 	bool mCheckAccountResult = false;
 	bool mCacheValid = false;
 
+	// Ledger state behind each required asset, as of mLedgerStateSeq.
+	// Queue requirements live across many submissions, so this saves
+	// reloading the account, trustline and issuer on every one.  Nothing
+	// changes the ledger between closes, so the whole cache is dropped
+	// (and lazily reloaded) when the ledger sequence number moves on,
+	// rather than rebased from the entries the close changed.
+	struct AssetLedgerState {
+		// trustline and asset both allow commutative txs
+		bool mUsable;
+		int64_t mAvailableBalance;
+	};
+
+	UnorderedMap<Asset, AssetLedgerState> mLedgerState;
+	uint32_t mLedgerStateSeq = 0;
+
+	AssetLedgerState const& getLedgerState(
+		LedgerTxnHeader& header, AbstractLedgerTxn& ltx, Asset const& asset);
+
 	void setCachedAccountHasSufficientBalanceCheck(bool res);
 	void invalidateCachedCheck();
 
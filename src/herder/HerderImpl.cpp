@@ -24,6 +24,7 @@
 #include "overlay/OverlayManager.h"
 #include "scp/LocalNode.h"
 #include "scp/Slot.h"
+#include "transactions/SignatureVerificationBatch.h"
 #include "transactions/TransactionUtils.h"
 #include "util/Logging.h"
 #include "util/StatusManager.h"
@@ -949,7 +950,21 @@ HerderImpl::recvTxSet(Hash const& hash, const TxSetFrame& t)
 {
     ZoneScoped;
     auto txset = std::make_shared<TxSetFrame>(t);
-    return mPendingEnvelopes.recvTxSet(hash, txset);
+    if (!mPendingEnvelopes.recvTxSet(hash, txset))
+    {
+        return false;
+    }
+
+    // The tx set will be validated on this thread once its envelopes are
+    // processed.  Start verifying its signatures on the worker threads now,
+    // so that validation mostly finds them in the verify cache.
+    {
+        LedgerTxn ltx(mApp.getLedgerTxnRoot());
+        SignatureVerificationBatch signatures;
+        signatures.addTransactions(txset->mTransactions, ltx);
+        signatures.verifyInBackground(mApp);
+    }
+    return true;
 }
 
 void
@@ -136,24 +136,26 @@ TxSetCommutativityRequirements::tryReplaceTransaction(TransactionFrameBasePtr ne
 	}
 
 	auto newReqs = newTx -> getCommutativityRequirements(ltx);
-	auto oldReqs = oldTx -> getCommutativityRequirements(ltx);
 
 	if (!newReqs) {
 		// newTx failed some validation check
 		return false;
 	}
-	if (!oldReqs) {
-		throw std::runtime_error("bad tx got into queue!");
-	}
+
+	// oldTx was validated when it entered the queue, so there's no need
+	// to reload anything to recompute its requirements.
+	auto oldReqs = oldTx -> getCommutativityRequirementsUnconditional();
 
 	LedgerTxnHeader header = ltx.loadHeader();
 
 	// newreqs includes negative oldReqs, which includes the old fee requirement
-	for (auto const& [acct, oldAcctReqs] : oldReqs -> getRequirements())
+	for (auto const& [acct, oldAcctReqs] : oldReqs.getRequirements())
 	{
 		for (auto const& [asset, amount] : oldAcctReqs.getRequiredAssets())
 		{
-			//oldAcctReqs should be always valid, so never nullopt
+			if (!amount) {
+				throw std::runtime_error("bad tx got into queue!");
+			}
 			newReqs->addAssetRequirement(acct, asset, -*amount);
 		}
 	}
@@ -208,9 +210,29 @@ TxSetCommutativityRequirements::tryCleanAccountEntry(AccountID account)
 
 }
 
+// Doesn't add an entry for an account without requirements, so calls for
+// different accounts can run concurrently.
 bool 
 TxSetCommutativityRequirements::checkAccountHasSufficientBalance(AccountID account, AbstractLedgerTxn& ltx, LedgerTxnHeader& header) {
-	return getRequirements(account).checkAccountHasSufficientBalance(ltx, header);
+	auto iter = mAccountRequirements.find(account);
+	if (iter == mAccountRequirements.end())
+	{
+		return true;
+	}
+	return iter -> second.checkAccountHasSufficientBalance(ltx, header);
+}
+
+void
+TxSetCommutativityRequirements::merge(TxSetCommutativityRequirements const& other)
+{
+	for (auto const& [acct, otherReqs] : other.mAccountRequirements)
+	{
+		auto& reqs = getRequirements(acct);
+		for (auto const& [asset, amount] : otherReqs.getRequiredAssets())
+		{
+			reqs.addAssetRequirement(asset, amount);
+		}
+	}
 }
 
 #ifdef BUILD_TESTS
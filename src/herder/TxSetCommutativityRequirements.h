@@ -44,6 +44,10 @@ public:
 
 	bool checkAccountHasSufficientBalance(AccountID account, AbstractLedgerTxn& ltx, LedgerTxnHeader& header);
 
+	// adds the requirements of other to these, as if other's txs had been
+	// added here
+	void merge(TxSetCommutativityRequirements const& other);
+
 #ifdef BUILD_TESTS
 	std::optional<int64_t> getReq(AccountID account, Asset asset);
 #endif
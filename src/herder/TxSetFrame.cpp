@@ -14,19 +14,24 @@
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "ledger/ShardLedgerTxnParent.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Thread.h"
 #include "util/XDRCereal.h"
 #include "util/XDROperators.h"
 #include "xdrpp/marshal.h"
 
 #include <Tracy.hpp>
 #include <algorithm>
+#include <atomic>
 #include <list>
+#include <mutex>
 #include <numeric>
+#include <thread>
 
 namespace stellar
 {
@@ -311,110 +316,160 @@ TxSetFrame::checkOrTrim(Application& app,
 
     auto accountTxMap = buildAccountTxQueues();
 
+    // Each account's queue is checked on its own, so queues are split into
+    // shards and checked concurrently, each shard in its own LedgerTxn over
+    // ltx. Only the trimming, which changes the tx set, is serial, and it
+    // visits the queues in the same order as a serial check would.
+    std::vector<AccountTransactionQueue*> queues;
+    queues.reserve(accountTxMap.size());
     for (auto& kv : accountTxMap)
     {
+        queues.emplace_back(&kv.second);
+    }
+
+    size_t numShards = app.getConfig().TX_SET_VALIDATION_SHARDS;
+    if (numShards == 0)
+    {
+        numShards = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numShards = std::max<size_t>(1, std::min(numShards, queues.size()));
+
+    // Returns how many txs at the front of queue are valid; the txs after
+    // the first invalid one are invalid too. Adds the requirements of the
+    // valid ones to shardReqs.
+    auto checkQueue = [&](AccountTransactionQueue const& queue,
+                          AbstractLedgerTxn& shardLtx,
+                          TxSetCommutativityRequirements& shardReqs) {
         int64_t lastSeq = 0;
         bool foundNoncommutative = false;
-        auto iter = kv.second.begin();
-        while (iter != kv.second.end())
+        for (size_t i = 0; i < queue.size(); ++i)
         {
-            auto tx = *iter;
-            if (!tx->checkValid(ltx, lastSeq, lowerBoundCloseTimeOffset,
+            auto const& tx = queue[i];
+            if (!tx->checkValid(shardLtx, lastSeq, lowerBoundCloseTimeOffset,
                                 upperBoundCloseTimeOffset))
             {
-                if (justCheck)
-                {
-                    CLOG_DEBUG(
-                        Herder,
-                        "Got bad txSet: {} tx invalid lastSeq:{} tx: {} "
-                        "result: {}",
-                        hexAbbrev(mPreviousLedgerHash), lastSeq,
-                        xdr_to_string(tx->getEnvelope(), "TransactionEnvelope"),
-                        tx->getResultCode());
-                    return false;
-                }
-                while (iter != kv.second.end()) {
-                    trimmed.emplace_back(*iter);
-                    removeTx(*iter);
-                    iter = kv.second.erase(iter);
-                }
-                continue;
+                CLOG_DEBUG(
+                    Herder,
+                    "Got bad txSet: {} tx invalid lastSeq:{} tx: {} "
+                    "result: {}",
+                    hexAbbrev(mPreviousLedgerHash), lastSeq,
+                    xdr_to_string(tx->getEnvelope(), "TransactionEnvelope"),
+                    tx->getResultCode());
+                return i;
             }
-            else
+            if (tx->isCommutativeTransaction() && foundNoncommutative)
+            {
+                CLOG_DEBUG(Herder, "Cannot follow noncommutative tx by "
+                                   "commutative tx in one block");
+                return i;
+            }
+            if (!tx->isCommutativeTransaction())
             {
+                foundNoncommutative = true;
+            }
 
-                if (tx -> isCommutativeTransaction() && foundNoncommutative) 
-                {
-                    
-                    if (justCheck) 
-                    {
-                        CLOG_DEBUG(
-                            Herder,
-                            "Cannot follow noncommutative tx by commutative tx in one block");
-                        return false;
-                    }
-                    while(iter != kv.second.end())
-                    {
-                        trimmed.emplace_back(*iter);
-                        removeTx(*iter);
-                        iter = kv.second.erase(iter);
-                    }
-                    continue;
-                }
+            lastSeq = tx->getSeqNum();
 
-                if (!tx -> isCommutativeTransaction()) {
-                    foundNoncommutative = true;
-                }
+            if (!shardReqs.validateAndAddTransaction(tx, shardLtx))
+            {
+                CLOG_DEBUG(Herder,
+                           "Invalid TxSet: commutativity check failed");
+                return i;
+            }
+        }
+        return queue.size();
+    };
+
+    std::mutex ltxMutex;
+    std::vector<size_t> numValid(queues.size());
+    std::vector<TxSetCommutativityRequirements> shardReqs(numShards);
+    std::atomic<bool> foundInvalid{false};
+    parallelFor(numShards, numShards - 1, [&](size_t s) {
+        ZoneNamedN(shardZone, "checkTxSetShard", true);
+        ShardLedgerTxnParent parent(ltx, ltxMutex);
+        LedgerTxn shardLtx(parent);
+        for (size_t q = s; q < queues.size(); q += numShards)
+        {
+            if (justCheck && foundInvalid)
+            {
+                return;
+            }
+            numValid[q] = checkQueue(*queues[q], shardLtx, shardReqs[s]);
+            if (numValid[q] < queues[q]->size())
+            {
+                foundInvalid = true;
+            }
+        }
+    });
 
-                lastSeq = tx->getSeqNum();
+    if (justCheck && foundInvalid)
+    {
+        return false;
+    }
 
-                auto res = reqs.validateAndAddTransaction(tx, ltx);
+    for (auto const& r : shardReqs)
+    {
+        reqs.merge(r);
+    }
 
+    for (size_t q = 0; q < queues.size(); ++q)
+    {
+        auto& queue = *queues[q];
+        auto firstInvalid = queue.begin() + numValid[q];
+        for (auto iter = firstInvalid; iter != queue.end(); ++iter)
+        {
+            trimmed.emplace_back(*iter);
+            removeTx(*iter);
+        }
+        queue.erase(firstInvalid, queue.end());
+    }
 
-                //Comparison:
-                /*int64_t& accFee = accountFeeMap[tx->getFeeSourceID()];
-                if (INT64_MAX - accFee < tx->getFeeBid())
-                {
-                    accFee = INT64_MAX;
-                }
-                else
-                {
-                    accFee += tx->getFeeBid();
-                } */
+    CLOG_TRACE(Herder, "Begin TxSetFrame validity checks");
 
-                if (res) {
-                    ++iter;
-                } else {
-                    if (justCheck) {
-                        CLOG_DEBUG(
-                            Herder,
-                            "Invalid TxSet: commutativity check failed");
-                        return false;
-                    }
-                    while (iter != kv.second.end())
-                    {
-                        trimmed.emplace_back(*iter);
-                        removeTx(*iter);
-                        iter = kv.second.erase(iter);
-                    }
-                    continue;
+    // reqs and ltx don't change during this pass, so each account's
+    // balance only needs to be checked once, however many txs touch it,
+    // and accounts can be checked concurrently.
+    std::vector<AccountID> accounts;
+    UnorderedMap<AccountID, size_t> accountIndices;
+    for (auto const* queue : queues)
+    {
+        for (auto const& tx : *queue)
+        {
+            for (auto const& acct : tx->getRelevantAccounts())
+            {
+                if (accountIndices.emplace(acct, accounts.size()).second)
+                {
+                    accounts.emplace_back(acct);
                 }
             }
         }
     }
 
-    auto header = ltx.loadHeader();
-
-    std::printf("Begin TxSetFrame validity checks\n");
+    std::vector<uint8_t> sufficientBalance(accounts.size());
+    parallelFor(numShards, numShards - 1, [&](size_t s) {
+        ZoneNamedN(shardZone, "checkTxSetBalancesShard", true);
+        ShardLedgerTxnParent parent(ltx, ltxMutex);
+        LedgerTxn shardLtx(parent);
+        auto header = shardLtx.loadHeader();
+        for (size_t a = s; a < accounts.size(); a += numShards)
+        {
+            sufficientBalance[a] = reqs.checkAccountHasSufficientBalance(
+                accounts[a], shardLtx, header);
+        }
+    });
+    auto hasSufficientBalance = [&](AccountID const& acct) {
+        return sufficientBalance[accountIndices.at(acct)] != 0;
+    };
 
-    for (auto& [_, accountTxs] : accountTxMap)
+    for (auto* queue : queues)
     {
+        auto& accountTxs = *queue;
         auto iter = accountTxs.begin();
         while (iter != accountTxs.end()) {
 
             auto relevantAccounts = (*iter)->getRelevantAccounts();
             for (auto acct : relevantAccounts) {
-                if (!reqs.checkAccountHasSufficientBalance(acct, ltx, header)) {
+                if (!hasSufficientBalance(acct)) {
                     if (justCheck) {
                         CLOG_DEBUG(
                             Herder,
@@ -3,6 +3,7 @@
 #include "herder/HerderImpl.h"
 #include "herder/LedgerCloseData.h"
 #include "herder/TxSetFrame.h"
+#include "crypto/SecretKey.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "test/TestAccount.h"
@@ -74,6 +75,43 @@ TEST_CASE("fee calculation test", "[txset][commutativity]")
 
 }
 
+TEST_CASE("requirements pick up new balances after ledger close", "[txset][commutativity]")
+{
+    TxSetCommutativityRequirements reqs;
+
+    Config cfg(getTestConfig());
+    cfg.LEDGER_PROTOCOL_VERSION = 17;
+    cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = 100;
+
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+    const int64_t minBalance0 = app->getLedgerManager().getLastMinBalance(0);
+    auto baseTxFee = app -> getLedgerManager().getLastTxFee();
+
+    auto paymentSource = root.create("src", 10000 + minBalance0 + 10 * baseTxFee);
+    auto paymentReceiver = root.create("dest", 10000 + minBalance0);
+
+    auto tx1 = paymentSource.commutativeTx({payment(paymentReceiver, 8000)});
+    auto tx2 = paymentSource.commutativeTx({payment(paymentReceiver, 8000)});
+
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE(reqs.tryAddTransaction(tx1, ltx));
+        REQUIRE(!reqs.tryAddTransaction(tx2, ltx));
+    }
+
+    root.pay(paymentSource, 10000);
+    auto lcl = app->getLedgerManager().getLastClosedLedgerNum();
+    closeLedgerOn(*app, lcl + 1, 1, 1, 2020);
+
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE(reqs.tryAddTransaction(tx2, ltx));
+    }
+}
+
 TEST_CASE("commutative payment tx set", "[txset][commutativity]")
 {
 	Config cfg(getTestConfig());
@@ -474,3 +512,81 @@ TEST_CASE("asset issuance limits", "[herder][txset][commutativity]")
     	}
     }
 }
+
+TEST_CASE("parallel tx set validation trims like serial validation", "[txset][commutativity]")
+{
+    const size_t numSources = 12;
+
+    // Returns the full hashes of the trimmed txs, in order, and the contents
+    // hash of what is left.
+    auto trimWithShards = [&](uint32_t numShards) {
+        Config cfg(getTestConfig());
+        cfg.LEDGER_PROTOCOL_VERSION = 17;
+        cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = 100;
+        cfg.TX_SET_VALIDATION_SHARDS = numShards;
+
+        VirtualClock clock;
+        Application::pointer app = createTestApplication(clock, cfg);
+
+        auto root = TestAccount::createRoot(*app);
+        const int64_t minBalance0 =
+            app->getLedgerManager().getLastMinBalance(0);
+        auto baseTxFee = app->getLedgerManager().getLastTxFee();
+
+        auto paymentReceiver = root.create("dest", 10000 + minBalance0);
+
+        TxSetFramePtr txSet = std::make_shared<TxSetFrame>(
+            app->getLedgerManager().getLastClosedLedgerHeader().hash);
+
+        for (size_t i = 0; i < numSources; i++)
+        {
+            auto source = root.create(fmt::format("src{}", i),
+                                      10000 + minBalance0 + 10 * baseTxFee);
+            for (size_t j = 0; j < 3; j++)
+            {
+                txSet->add(
+                    source.commutativeTx({payment(paymentReceiver, 100)}));
+            }
+            switch (i)
+            {
+            case 0:
+                // bad seq num
+                txSet->add(source.commutativeTx(
+                    {payment(paymentReceiver, 100)},
+                    source.getLastSequenceNumber() + 10));
+                break;
+            case 1:
+                // overspends
+                txSet->add(
+                    source.commutativeTx({payment(paymentReceiver, 20000)}));
+                break;
+            case 2:
+                // commutative after noncommutative
+                txSet->add(source.tx({payment(paymentReceiver, 100)}));
+                txSet->add(
+                    source.commutativeTx({payment(paymentReceiver, 100)}));
+                break;
+            default:
+                break;
+            }
+        }
+        txSet->sortForHash();
+        REQUIRE(!txSet->checkValid(*app, 0, 0));
+
+        std::vector<Hash> trimmed;
+        for (auto const& tx : txSet->trimInvalid(*app, 0, 0))
+        {
+            trimmed.emplace_back(tx->getFullHash());
+        }
+        REQUIRE(txSet->checkValid(*app, 0, 0));
+        return std::make_pair(trimmed, txSet->getContentsHash());
+    };
+
+    auto serial = trimWithShards(1);
+    auto parallel = trimWithShards(4);
+
+    // src0's bad tx, all of src1's txs, and src2's last one
+    REQUIRE(serial.first.size() == 1 + 4 + 1);
+    REQUIRE(parallel.first == serial.first);
+    REQUIRE(parallel.second == serial.second);
+}
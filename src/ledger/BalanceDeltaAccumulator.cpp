@@ -0,0 +1,61 @@
+#include "ledger/BalanceDeltaAccumulator.h"
+
+#include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTxnEntry.h"
+#include "ledger/LedgerTxnHeader.h"
+#include "ledger/TrustLineWrapper.h"
+#include "transactions/TransactionUtils.h"
+#include "util/XDROperators.h"
+
+#include <Tracy.hpp>
+
+#include <stdexcept>
+
+namespace stellar {
+
+void
+BalanceDeltaAccumulator::addDelta(AccountID const& account, Asset const& asset, int64_t delta)
+{
+    if (delta == 0) {
+        return;
+    }
+    auto& total = mDeltas[std::make_pair(account, asset)];
+    if (__builtin_add_overflow(total, delta, &total)) {
+        throw std::runtime_error("balance delta overflow");
+    }
+}
+
+void
+BalanceDeltaAccumulator::apply(AbstractLedgerTxn& ltx)
+{
+    ZoneScoped;
+    auto header = ltx.loadHeader();
+
+    for (auto const& [key, delta] : mDeltas) {
+        auto const& [accountID, asset] = key;
+        if (delta == 0) {
+            continue;
+        }
+
+        if (asset.type() == ASSET_TYPE_NATIVE) {
+            auto account = loadAccount(ltx, accountID);
+            if (!account) {
+                throw std::runtime_error("failed to find account");
+            }
+            if (!addBalance(header, account, delta)) {
+                throw std::runtime_error("fail to add xlm balance");
+            }
+        } else {
+            auto trustLine = loadTrustLine(ltx, accountID, asset);
+            if (!trustLine) {
+                throw std::runtime_error("failed to find trustline");
+            }
+            if (!trustLine.addBalance(header, delta)) {
+                throw std::runtime_error("failed to add nonxlm balance");
+            }
+        }
+    }
+    mDeltas.clear();
+}
+
+} /* stellar */
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "xdr/Stellar-ledger-entries.h"
+
+#include <cstdint>
+#include <map>
+#include <utility>
+
+namespace stellar {
+
+class AbstractLedgerTxn;
+
+/*
+ Collects balance changes as signed deltas keyed by (account, asset),
+ and writes each touched account or trustline once, in apply().
+
+ For batches of commuting balance changes, where only the final balances
+ matter, this replaces a load and store per change with one per entry.
+ Entries are written in key order, so the result is deterministic, and
+ entries whose deltas cancel out are not touched at all.
+
+ Only net deltas are checked.  Limits, liabilities and reserves apply to
+ each entry's final balance, not to the balances in between, so a credit
+ that would overflow a trustline limit on its own, or a debit that would
+ overdraw it, succeeds when the other changes to the same entry bring the
+ total back in bounds.  Applying the same changes one at a time, in some
+ order, could fail where apply() does not.  This is what makes the changes
+ commute; callers must only batch changes that may be reordered (speedex
+ fills, and the merge of ParallelCommutativeApply shards).
+*/
+class BalanceDeltaAccumulator
+{
+    std::map<std::pair<AccountID, Asset>, int64_t> mDeltas;
+
+public:
+
+    void addDelta(AccountID const& account, Asset const& asset, int64_t delta);
+
+    // Throws if a balance can't absorb its delta (e.g. a missing trustline,
+    // or a limit or liability violation).  Clears the accumulated deltas.
+    void apply(AbstractLedgerTxn& ltx);
+
+    bool empty() const {
+        return mDeltas.empty();
+    }
+
+    // number of distinct (account, asset) keys
+    size_t size() const {
+        return mDeltas.size();
+    }
+};
+
+} /* stellar */
@@ -3,77 +3,341 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "ledger/InMemoryLedgerTxnRoot.h"
+#include "crypto/KeyUtils.h"
+#include "crypto/SecretKey.h"
+#include "database/Database.h"
 #include "ledger/LedgerRange.h"
 #include "ledger/LedgerTxn.h"
+#include "util/GlobalChecks.h"
 #include "util/XDROperators.h"
 #include "util/types.h"
 #include "xdr/Stellar-ledger-entries.h"
 #include "xdrpp/marshal.h"
+#include <Tracy.hpp>
 #include <algorithm>
 
 namespace stellar
 {
 
-InMemoryLedgerTxnRoot::InMemoryLedgerTxnRoot(
+static AssetPair
+offerAssetPair(OfferEntry const& oe)
+{
+    return AssetPair{oe.buying, oe.selling};
+}
+
+static OfferDescriptor
+offerDescriptor(OfferEntry const& oe)
+{
+    return OfferDescriptor{oe.price, oe.offerID};
+}
+
+InMemoryLedgerTxnRoot::InMemoryLedgerTxnRoot(Database& db
 #ifdef BEST_OFFER_DEBUGGING
-    bool bestOfferDebuggingEnabled
+                                             ,
+                                             bool bestOfferDebuggingEnabled
 #endif
-    )
-    : mHeader(std::make_unique<LedgerHeader>())
+                                             )
+    : mDatabase(db)
+    , mHeader(std::make_unique<LedgerHeader>())
 #ifdef BEST_OFFER_DEBUGGING
     , mBestOfferDebuggingEnabled(bestOfferDebuggingEnabled)
 #endif
 {
 }
 
+InMemoryLedgerTxnRoot::~InMemoryLedgerTxnRoot()
+{
+}
+
+void
+InMemoryLedgerTxnRoot::throwIfChild() const
+{
+    if (mChild)
+    {
+        throw std::runtime_error("InMemoryLedgerTxnRoot has child");
+    }
+}
+
+std::shared_ptr<LedgerEntry const>
+InMemoryLedgerTxnRoot::getEntry(LedgerKey const& key) const
+{
+    auto typeIter = mEntries.find(key.type());
+    if (typeIter != mEntries.end())
+    {
+        auto iter = typeIter->second.find(key);
+        if (iter != typeIter->second.end())
+        {
+            return iter->second;
+        }
+    }
+    if (key.type() == SPEEDEX_CONFIG)
+    {
+        // Like LedgerTxnRoot, act as though a default speedex config exists
+        // from genesis on.
+        LedgerEntry out;
+        out.data.type(SPEEDEX_CONFIG);
+        return std::make_shared<LedgerEntry const>(out);
+    }
+    return nullptr;
+}
+
+void
+InMemoryLedgerTxnRoot::putEntry(LedgerEntry const& entry)
+{
+    auto key = LedgerEntryKey(entry);
+    auto ptr = std::make_shared<LedgerEntry const>(entry);
+    auto& byKey = mEntries[key.type()];
+    auto iter = byKey.find(key);
+    if (iter != byKey.end())
+    {
+        if (key.type() == OFFER)
+        {
+            eraseEntry(key);
+        }
+        else
+        {
+            iter->second = ptr;
+            return;
+        }
+    }
+    byKey.emplace(key, ptr);
+    if (key.type() == OFFER)
+    {
+        auto const& oe = entry.data.offer();
+        mOrderBooks[offerAssetPair(oe)].emplace(offerDescriptor(oe), ptr);
+    }
+}
+
+bool
+InMemoryLedgerTxnRoot::eraseEntry(LedgerKey const& key) const
+{
+    auto typeIter = mEntries.find(key.type());
+    if (typeIter == mEntries.end())
+    {
+        return false;
+    }
+    auto iter = typeIter->second.find(key);
+    if (iter == typeIter->second.end())
+    {
+        return false;
+    }
+    if (key.type() == OFFER)
+    {
+        auto const& oe = iter->second->data.offer();
+        auto bookIter = mOrderBooks.find(offerAssetPair(oe));
+        releaseAssert(bookIter != mOrderBooks.end());
+        bookIter->second.erase(offerDescriptor(oe));
+        if (bookIter->second.empty())
+        {
+            mOrderBooks.erase(bookIter);
+        }
+    }
+    typeIter->second.erase(iter);
+    return true;
+}
+
+void
+InMemoryLedgerTxnRoot::dropType(LedgerEntryType let)
+{
+    throwIfChild();
+    mEntries.erase(let);
+    if (let == OFFER)
+    {
+        mOrderBooks.clear();
+    }
+}
+
+InMemoryLedgerTxnRoot::OrderBook const*
+InMemoryLedgerTxnRoot::getOrderBook(Asset const& buying,
+                                    Asset const& selling) const
+{
+    auto iter = mOrderBooks.find(AssetPair{buying, selling});
+    return iter == mOrderBooks.end() ? nullptr : &iter->second;
+}
+
 void
 InMemoryLedgerTxnRoot::addChild(AbstractLedgerTxn& child)
 {
+    if (mChild)
+    {
+        throw std::runtime_error("InMemoryLedgerTxnRoot already has child");
+    }
+    mTransaction = std::make_unique<soci::transaction>(mDatabase.getSession());
+    mChild = &child;
 }
 
 void
 InMemoryLedgerTxnRoot::commitChild(EntryIterator iter,
                                    LedgerTxnConsistency cons)
 {
-    throw std::runtime_error("committing to stub InMemoryLedgerTxnRoot");
+    ZoneScoped;
+    auto childHeader = std::make_unique<LedgerHeader>(mChild->getHeader());
+    try
+    {
+        for (; (bool)iter; ++iter)
+        {
+            // As in LedgerTxnRoot, only LEDGER_ENTRY is stored at the root.
+            if (iter.key().type() != InternalLedgerEntryType::LEDGER_ENTRY)
+            {
+                continue;
+            }
+            if (iter.entryExists())
+            {
+                putEntry(iter.entry().ledgerEntry());
+            }
+            else if (!eraseEntry(iter.key().ledgerKey()) &&
+                     cons == LedgerTxnConsistency::EXACT)
+            {
+                throw std::runtime_error("Could not delete missing entry "
+                                         "from InMemoryLedgerTxnRoot");
+            }
+        }
+        mDatabase.clearPreparedStatementCache();
+        mTransaction->commit();
+    }
+    catch (std::exception& e)
+    {
+        printErrorAndAbort(
+            "fatal error during commit to InMemoryLedgerTxnRoot: ", e.what());
+    }
+    catch (...)
+    {
+        printErrorAndAbort(
+            "unknown fatal error during commit to InMemoryLedgerTxnRoot");
+    }
+
+    mTransaction.reset();
+    mHeader.swap(childHeader);
+    mChild = nullptr;
 }
 
 void
 InMemoryLedgerTxnRoot::rollbackChild()
 {
+    try
+    {
+        mTransaction->rollback();
+        mTransaction.reset();
+    }
+    catch (std::exception& e)
+    {
+        printErrorAndAbort(
+            "fatal error when rolling back child of InMemoryLedgerTxnRoot: ",
+            e.what());
+    }
+    catch (...)
+    {
+        printErrorAndAbort("unknown fatal error when rolling back child of "
+                           "InMemoryLedgerTxnRoot");
+    }
+    mChild = nullptr;
 }
 
 UnorderedMap<LedgerKey, LedgerEntry>
 InMemoryLedgerTxnRoot::getAllOffers()
 {
-    return UnorderedMap<LedgerKey, LedgerEntry>();
+    ZoneScoped;
+    UnorderedMap<LedgerKey, LedgerEntry> res;
+    auto typeIter = mEntries.find(OFFER);
+    if (typeIter != mEntries.end())
+    {
+        res.reserve(typeIter->second.size());
+        for (auto const& kv : typeIter->second)
+        {
+            res.emplace(kv.first, *kv.second);
+        }
+    }
+    return res;
 }
 
 std::shared_ptr<LedgerEntry const>
 InMemoryLedgerTxnRoot::getBestOffer(Asset const& buying, Asset const& selling)
 {
-    return nullptr;
+    auto book = getOrderBook(buying, selling);
+    if (!book)
+    {
+        return nullptr;
+    }
+    return book->begin()->second;
 }
 
 std::shared_ptr<LedgerEntry const>
 InMemoryLedgerTxnRoot::getBestOffer(Asset const& buying, Asset const& selling,
                                     OfferDescriptor const& worseThan)
 {
-    return nullptr;
+    auto book = getOrderBook(buying, selling);
+    if (!book)
+    {
+        return nullptr;
+    }
+    // The first offer that worseThan is better than.
+    auto iter = book->upper_bound(worseThan);
+    return iter == book->end() ? nullptr : iter->second;
 }
 
 UnorderedMap<LedgerKey, LedgerEntry>
 InMemoryLedgerTxnRoot::getOffersByAccountAndAsset(AccountID const& account,
                                                   Asset const& asset)
 {
-    return UnorderedMap<LedgerKey, LedgerEntry>();
+    ZoneScoped;
+    if (asset.type() == ASSET_TYPE_NATIVE)
+    {
+        throw std::runtime_error("Invalid asset type");
+    }
+    // This is only needed when authorization is revoked, so a scan will do.
+    UnorderedMap<LedgerKey, LedgerEntry> res;
+    auto typeIter = mEntries.find(OFFER);
+    if (typeIter != mEntries.end())
+    {
+        for (auto const& kv : typeIter->second)
+        {
+            auto const& oe = kv.second->data.offer();
+            if (oe.sellerID == account &&
+                (oe.selling == asset || oe.buying == asset))
+            {
+                res.emplace(kv.first, *kv.second);
+            }
+        }
+    }
+    return res;
 }
 
 UnorderedMap<LedgerKey, LedgerEntry>
 InMemoryLedgerTxnRoot::getPoolShareTrustLinesByAccountAndAsset(
     AccountID const& account, Asset const& asset)
 {
-    return UnorderedMap<LedgerKey, LedgerEntry>();
+    ZoneScoped;
+    // Also only needed when authorization is revoked.
+    UnorderedMap<LedgerKey, LedgerEntry> res;
+    auto typeIter = mEntries.find(TRUSTLINE);
+    if (typeIter == mEntries.end())
+    {
+        return res;
+    }
+    for (auto const& kv : typeIter->second)
+    {
+        auto const& tl = kv.second->data.trustLine();
+        if (!(tl.accountID == account) ||
+            tl.asset.type() != ASSET_TYPE_POOL_SHARE)
+        {
+            continue;
+        }
+        LedgerKey poolKey(LIQUIDITY_POOL);
+        poolKey.liquidityPool().liquidityPoolID =
+            tl.asset.liquidityPoolID();
+        auto pool = getEntry(poolKey);
+        if (!pool)
+        {
+            continue;
+        }
+        auto const& params =
+            pool->data.liquidityPool().body.constantProduct().params;
+        if (params.assetA == asset || params.assetB == asset)
+        {
+            res.emplace(kv.first, *kv.second);
+        }
+    }
+    return res;
 }
 
 LedgerHeader const&
@@ -86,91 +350,172 @@ std::vector<InflationWinner>
 InMemoryLedgerTxnRoot::getInflationWinners(size_t maxWinners,
                                            int64_t minBalance)
 {
-    return std::vector<InflationWinner>();
+    ZoneScoped;
+    // Mirrors the SQL in LedgerTxnRoot: only accounts with at least 100 XLM
+    // vote, winners are ordered by votes and then by strkey, both descending.
+    UnorderedMap<AccountID, int64_t> votes;
+    auto typeIter = mEntries.find(ACCOUNT);
+    if (typeIter != mEntries.end())
+    {
+        for (auto const& kv : typeIter->second)
+        {
+            auto const& ae = kv.second->data.account();
+            if (ae.inflationDest && ae.balance >= 1000000000)
+            {
+                votes[*ae.inflationDest] += ae.balance;
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, InflationWinner>> sorted;
+    sorted.reserve(votes.size());
+    for (auto const& kv : votes)
+    {
+        sorted.emplace_back(KeyUtils::toStrKey(kv.first),
+                            InflationWinner{kv.first, kv.second});
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) {
+        if (a.second.votes != b.second.votes)
+        {
+            return a.second.votes > b.second.votes;
+        }
+        return a.first > b.first;
+    });
+
+    std::vector<InflationWinner> winners;
+    for (auto const& w : sorted)
+    {
+        if (winners.size() >= maxWinners || w.second.votes < minBalance)
+        {
+            break;
+        }
+        winners.emplace_back(w.second);
+    }
+    return winners;
 }
 
 std::shared_ptr<InternalLedgerEntry const>
 InMemoryLedgerTxnRoot::getNewestVersion(InternalLedgerKey const& key) const
 {
-    return nullptr;
+    if (key.type() != InternalLedgerEntryType::LEDGER_ENTRY)
+    {
+        return nullptr;
+    }
+    auto entry = getEntry(key.ledgerKey());
+    return entry ? std::make_shared<InternalLedgerEntry const>(*entry)
+                 : nullptr;
 }
 
 uint64_t
 InMemoryLedgerTxnRoot::countObjects(LedgerEntryType let) const
 {
-    return 0;
+    throwIfChild();
+    auto typeIter = mEntries.find(let);
+    return typeIter == mEntries.end() ? 0 : typeIter->second.size();
 }
 
 uint64_t
 InMemoryLedgerTxnRoot::countObjects(LedgerEntryType let,
                                     LedgerRange const& ledgers) const
 {
-    return 0;
+    throwIfChild();
+    auto typeIter = mEntries.find(let);
+    if (typeIter == mEntries.end())
+    {
+        return 0;
+    }
+    return std::count_if(
+        typeIter->second.begin(), typeIter->second.end(), [&](auto const& kv) {
+            auto lastModified = kv.second->lastModifiedLedgerSeq;
+            return lastModified >= ledgers.mFirst &&
+                   lastModified < ledgers.limit();
+        });
 }
 
 void
 InMemoryLedgerTxnRoot::deleteObjectsModifiedOnOrAfterLedger(
     uint32_t ledger) const
 {
+    throwIfChild();
+    std::vector<LedgerKey> toErase;
+    for (auto const& byType : mEntries)
+    {
+        for (auto const& kv : byType.second)
+        {
+            if (kv.second->lastModifiedLedgerSeq >= ledger)
+            {
+                toErase.emplace_back(kv.first);
+            }
+        }
+    }
+    for (auto const& key : toErase)
+    {
+        eraseEntry(key);
+    }
 }
 
 void
 InMemoryLedgerTxnRoot::dropAccounts()
 {
+    dropType(ACCOUNT);
 }
 
 void
 InMemoryLedgerTxnRoot::dropData()
 {
+    dropType(DATA);
 }
 
 void
 InMemoryLedgerTxnRoot::dropOffers()
 {
+    dropType(OFFER);
 }
 
 void
 InMemoryLedgerTxnRoot::dropTrustLines()
 {
+    dropType(TRUSTLINE);
 }
 
 void
 InMemoryLedgerTxnRoot::dropClaimableBalances()
 {
+    dropType(CLAIMABLE_BALANCE);
 }
 
 void
 InMemoryLedgerTxnRoot::dropLiquidityPools()
 {
+    dropType(LIQUIDITY_POOL);
 }
 
 void
 InMemoryLedgerTxnRoot::dropSpeedexConfigs()
 {
+    dropType(SPEEDEX_CONFIG);
 }
 
 double
 InMemoryLedgerTxnRoot::getPrefetchHitRate() const
 {
-    return 0.0;
+    // Every entry is resident, so every load is a hit.
+    return 1.0;
 }
 
 uint32_t
 InMemoryLedgerTxnRoot::prefetch(UnorderedSet<LedgerKey> const& keys)
 {
-    return 0;
+    // Nothing to load; report the keys as prefetched, as LedgerTxnRoot does
+    // for keys it loads.
+    return static_cast<uint32_t>(keys.size());
 }
 
 std::shared_ptr<const LedgerEntry>
-InMemoryLedgerTxnRoot::loadSnapshotEntry(LedgerKey const& key) const {
-
-    if (key.type() == SPEEDEX_CONFIG)
-    {
-        LedgerEntry out;
-        out.data.type(SPEEDEX_CONFIG);
-        return std::make_shared<const LedgerEntry>(out);
-    }
-    return nullptr;
+InMemoryLedgerTxnRoot::loadSnapshotEntry(LedgerKey const& key) const
+{
+    // The root only ever holds committed state, which is the snapshot.
+    return getEntry(key);
 }
 
 #ifdef BUILD_TESTS
@@ -194,6 +539,22 @@ InMemoryLedgerTxnRoot::getBestOfferSlow(Asset const& buying,
                                         OfferDescriptor const* worseThan,
                                         std::unordered_set<int64_t>& exclude)
 {
+    auto book = getOrderBook(buying, selling);
+    if (!book)
+    {
+        return nullptr;
+    }
+    for (auto const& kv : *book)
+    {
+        if (worseThan && !isBetterOffer(*worseThan, *kv.second))
+        {
+            continue;
+        }
+        if (exclude.find(kv.first.offerID) == exclude.end())
+        {
+            return kv.second;
+        }
+    }
     return nullptr;
 }
 #endif
@@ -4,39 +4,78 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "ledger/AssetPair.h"
 #include "ledger/InternalLedgerEntry.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnImpl.h"
 #include "util/UnorderedMap.h"
 #include "xdr/Stellar-ledger-entries.h"
 #include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
-// This is a stub helper class that pretends to implements a "root"
-// AbstractLedgerTxnParent like LedgerTxnRoot but returns empty/null values for
-// any query made of it, and throws if anyone ever tries to commit to it.
+// InMemoryLedgerTxnRoot is a "root" AbstractLedgerTxnParent, like
+// LedgerTxnRoot, that keeps the whole ledger state in memory rather than in
+// SQL. Entries are hash-indexed per LedgerEntryType, and offers are also kept
+// in one sorted order book per asset pair, so best-offer queries never scan.
 //
-// This is used to anchor a live-but-never-committed LedgerTxn when doing
-// strictly-in-memory fast history replay.
+// It still opens a SQL transaction for each child, and commits it along with
+// the child, so that the tables it does not hold (history, SCP state,
+// persistent state) stay transactionally consistent with the ledger state.
+//
+// It is used for MODE_USES_IN_MEMORY_LEDGER: catchup and replay apply
+// buckets and ledgers into it through ordinary LedgerTxns, and never touch
+// the ledger-entry tables.
 
 namespace stellar
 {
 
+class Database;
+
 class InMemoryLedgerTxnRoot : public AbstractLedgerTxnParent
 {
+    typedef std::map<OfferDescriptor, std::shared_ptr<LedgerEntry const>,
+                     IsBetterOfferComparator>
+        OrderBook;
+
+    Database& mDatabase;
     std::unique_ptr<LedgerHeader> mHeader;
 
+    // deleteObjectsModifiedOnOrAfterLedger is const in the interface, as it
+    // only issues SQL in LedgerTxnRoot, so these are mutable.
+    mutable std::map<LedgerEntryType,
+                     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>>
+        mEntries;
+    // Offers by (buying, selling), best first.
+    mutable UnorderedMap<AssetPair, OrderBook, AssetPairHash> mOrderBooks;
+
+    std::unique_ptr<soci::transaction> mTransaction;
+    AbstractLedgerTxn* mChild{nullptr};
+
 #ifdef BEST_OFFER_DEBUGGING
     bool const mBestOfferDebuggingEnabled;
 #endif
 
+    void throwIfChild() const;
+
+    std::shared_ptr<LedgerEntry const> getEntry(LedgerKey const& key) const;
+    void putEntry(LedgerEntry const& entry);
+    // Returns false if there was no such entry.
+    bool eraseEntry(LedgerKey const& key) const;
+    void dropType(LedgerEntryType let);
+
+    OrderBook const* getOrderBook(Asset const& buying,
+                                  Asset const& selling) const;
+
   public:
-    InMemoryLedgerTxnRoot(
+    InMemoryLedgerTxnRoot(Database& db
 #ifdef BEST_OFFER_DEBUGGING
-        bool bestOfferDebuggingEnabled
+                          ,
+                          bool bestOfferDebuggingEnabled
 #endif
     );
+    ~InMemoryLedgerTxnRoot();
     void addChild(AbstractLedgerTxn& child) override;
     void commitChild(EntryIterator iter, LedgerTxnConsistency cons) override;
     void rollbackChild() override;
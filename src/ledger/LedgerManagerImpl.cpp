@@ -22,6 +22,7 @@
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "ledger/ParallelCommutativeApply.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "main/ErrorMessages.h"
@@ -134,6 +135,7 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
           app.getMetrics().NewCounter({"ledger", "age", "current-seconds"}))
     , mMetaStreamWriteTime(
           app.getMetrics().NewTimer({"ledger", "metastream", "write"}))
+    , mSpeedexMetrics(app)
     , mLastClose(mApp.getClock().now())
     , mCatchupDuration(
           app.getMetrics().NewTimer({"ledger", "catchup", "duration"}))
@@ -143,6 +145,22 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
     setupLedgerCloseMetaStream();
 }
 
+LedgerManagerImpl::~LedgerManagerImpl()
+{
+    if (mPendingMetaWrite.valid())
+    {
+        try
+        {
+            waitForPendingMetaWrite();
+        }
+        catch (std::exception& e)
+        {
+            CLOG_ERROR(Ledger, "Failed to write ledger close meta: {}",
+                       e.what());
+        }
+    }
+}
+
 void
 LedgerManagerImpl::moveToSynced()
 {
@@ -269,6 +287,16 @@ LedgerManagerImpl::loadLastKnownLedger(
         CLOG_INFO(Ledger, "Last closed ledger (LCL) hash is {}", lastLedger);
         Hash lastLedgerHash = hexToBin256(lastLedger);
 
+        string lastWrittenMeta = mApp.getPersistentState().getState(
+            PersistentState::kLastWrittenMeta);
+        if (!lastWrittenMeta.empty())
+        {
+            CLOG_INFO(Ledger,
+                      "Meta was written to the previous meta stream up to "
+                      "ledger {}",
+                      lastWrittenMeta);
+        }
+
         if (mApp.getConfig().MODE_STORES_HISTORY_LEDGERHEADERS)
         {
             auto currentLedger =
@@ -523,20 +551,59 @@ LedgerManagerImpl::syncMetrics()
     mApp.syncOwnMetrics();
 }
 
+void
+LedgerManagerImpl::writeMeta(LedgerCloseMeta const& meta,
+                             XDROutputFileStream* stream,
+                             XDROutputFileStream* debugStream)
+{
+    auto streamWrite = mMetaStreamWriteTime.TimeScope();
+    if (stream)
+    {
+        stream->writeOne(meta);
+        stream->flush();
+    }
+    if (debugStream)
+    {
+        debugStream->writeOne(meta);
+    }
+}
+
+void
+LedgerManagerImpl::waitForPendingMetaWrite()
+{
+    if (mPendingMetaWrite.valid())
+    {
+        // get() rethrows anything the write threw, and leaves the future
+        // invalid either way.
+        mLastWrittenMetaLedger = mPendingMetaWrite.get();
+    }
+}
+
 void
 LedgerManagerImpl::emitNextMeta()
 {
     releaseAssert(mNextMetaToEmit);
     releaseAssert(mMetaStream || mMetaDebugStream);
-    auto streamWrite = mMetaStreamWriteTime.TimeScope();
-    if (mMetaStream)
+    waitForPendingMetaWrite();
+    if (mApp.getConfig().EXPERIMENTAL_ASYNC_META_WRITES)
     {
-        mMetaStream->writeOne(*mNextMetaToEmit);
-        mMetaStream->flush();
+        // The streams are only replaced after waitForPendingMetaWrite, so the
+        // writer can hold on to them.
+        std::shared_ptr<LedgerCloseMeta const> meta =
+            std::move(mNextMetaToEmit);
+        mPendingMetaWrite = std::async(
+            std::launch::async,
+            [this, meta, stream = mMetaStream.get(),
+             debugStream = mMetaDebugStream.get()]() {
+                writeMeta(*meta, stream, debugStream);
+                return meta->v0().ledgerHeader.header.ledgerSeq;
+            });
     }
-    if (mMetaDebugStream)
+    else
     {
-        mMetaDebugStream->writeOne(*mNextMetaToEmit);
+        writeMeta(*mNextMetaToEmit, mMetaStream.get(), mMetaDebugStream.get());
+        mLastWrittenMetaLedger =
+            mNextMetaToEmit->v0().ledgerHeader.header.ledgerSeq;
     }
     mNextMetaToEmit.reset();
 }
@@ -765,6 +832,22 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     auto& hm = mApp.getHistoryManager();
     hm.maybeQueueHistoryCheckpoint();
 
+    // Meta emitted so far may still be on the writer thread. It must reach
+    // the stream before this ledger commits: a crash after the commit would
+    // otherwise lose it for good, since a restarted node resumes after the
+    // LCL. With EXPERIMENTAL_PRECAUTION_DELAY_META the write in flight is the
+    // previous ledger's, and it has overlapped all of this ledger's apply.
+    if (mApp.getConfig().EXPERIMENTAL_ASYNC_META_WRITES)
+    {
+        waitForPendingMetaWrite();
+        if (mLastWrittenMetaLedger != 0)
+        {
+            mApp.getPersistentState().setState(
+                PersistentState::kLastWrittenMeta,
+                std::to_string(mLastWrittenMetaLedger));
+        }
+    }
+
     // step 2
     ltx.commit();
 
@@ -900,6 +983,10 @@ LedgerManagerImpl::maybeResetLedgerCloseMetaDebugStream(uint32_t ledgerSeq)
 {
     if (mApp.getConfig().METADATA_DEBUG_LEDGERS != 0)
     {
+        // The debug stream may be handed off below, so it must not have a
+        // write in flight.
+        waitForPendingMetaWrite();
+
         if (mMetaDebugStream)
         {
             if (!FlushAndRotateMetaDebugWork::isDebugSegmentBoundary(ledgerSeq))
@@ -1088,7 +1175,15 @@ LedgerManagerImpl::applyTransaction(
                tx->getSeqNum(),
                mApp.getConfig().toShortString(tx->getSourceID()));
     tx->apply(mApp, ltx, tm);
+    recordTransaction(tx, tm, ltx, txResultSet, ledgerCloseMeta, index);
+}
 
+void
+LedgerManagerImpl::recordTransaction(
+    TransactionFrameBasePtr& tx, TransactionMeta const& tm,
+    AbstractLedgerTxn& ltx, TransactionResultSet& txResultSet,
+    std::unique_ptr<LedgerCloseMeta> const& ledgerCloseMeta, int& index)
+{
     TransactionResultPair results;
     results.transactionHash = tx->getContentsHash();
     results.result = tx->getResult();
@@ -1125,6 +1220,38 @@ LedgerManagerImpl::applyTransaction(
     }
 }
 
+void
+LedgerManagerImpl::applyCommutativeTransactions(
+    std::vector<TransactionFrameBasePtr>& commutativeTxs,
+    AbstractLedgerTxn& ltx, TransactionResultSet& txResultSet,
+    std::unique_ptr<LedgerCloseMeta> const& ledgerCloseMeta, int& index)
+{
+    ZoneScoped;
+    auto numShards = mApp.getConfig().COMMUTATIVE_APPLY_SHARDS;
+    if (numShards > 1 && commutativeTxs.size() > 1)
+    {
+        ParallelCommutativeApply parallelApply(mApp, ltx, numShards);
+        std::vector<TransactionMeta> metas;
+        if (parallelApply.apply(commutativeTxs, metas))
+        {
+            for (size_t i = 0; i < commutativeTxs.size(); ++i)
+            {
+                recordTransaction(commutativeTxs[i], metas[i], ltx,
+                                  txResultSet, ledgerCloseMeta, index);
+            }
+            return;
+        }
+        CLOG_INFO(Tx, "Shards of ledger {} conflict, applying commutative "
+                      "txs serially",
+                  ltx.loadHeader().current().ledgerSeq);
+    }
+
+    for (auto& tx : commutativeTxs)
+    {
+        applyTransaction(tx, ltx, txResultSet, ledgerCloseMeta, index);
+    }
+}
+
 void
 LedgerManagerImpl::applyTransactions(
     std::vector<TransactionFrameBasePtr>& commutativeTxs,
@@ -1160,11 +1287,15 @@ LedgerManagerImpl::applyTransactions(
 
     prefetchTransactionData(commutativeTxs);
 
-    for (auto tx : commutativeTxs) {
-        applyTransaction(tx, ltx, txResultSet, ledgerCloseMeta, index);
-    }
+    applyCommutativeTransactions(commutativeTxs, ltx, txResultSet,
+                                 ledgerCloseMeta, index);
 
-    auto speedexRes = runSpeedex(ltx);
+    // Clearing loads run through the root like any others, so the prefetch
+    // hit rate logged below covers them too.
+    SpeedexBatchMetrics speedexMetrics;
+    auto speedexRes = runSpeedex(
+        ltx, mApp.getConfig().PREFETCH_BATCH_SIZE > 0, &speedexMetrics);
+    mSpeedexMetrics.record(speedexMetrics);
 
     prefetchTransactionData(noncommutativeTxs);
 
@@ -8,10 +8,12 @@
 #include "history/HistoryManager.h"
 #include "ledger/LedgerManager.h"
 #include "main/PersistentState.h"
+#include "speedex/SpeedexMetrics.h"
 #include "transactions/TransactionFrame.h"
 #include "util/XDRStream.h"
 #include "xdr/Stellar-ledger.h"
 #include <filesystem>
+#include <future>
 #include <string>
 
 /*
@@ -56,6 +58,7 @@ class LedgerManagerImpl : public LedgerManager
     medida::Buckets& mLedgerAgeClosed;
     medida::Counter& mLedgerAge;
     medida::Timer& mMetaStreamWriteTime;
+    SpeedexMetrics mSpeedexMetrics;
     VirtualClock::time_point mLastClose;
 
     std::unique_ptr<VirtualClock::time_point> mStartCatchup;
@@ -63,6 +66,12 @@ class LedgerManagerImpl : public LedgerManager
 
     std::unique_ptr<LedgerCloseMeta> mNextMetaToEmit;
 
+    // With EXPERIMENTAL_ASYNC_META_WRITES, the write of the last emitted
+    // meta, running on its own thread. Yields the ledger it wrote. At most
+    // one write is in flight; anything touching the meta streams waits first.
+    std::future<uint32_t> mPendingMetaWrite;
+    uint32_t mLastWrittenMetaLedger{0};
+
     void
     processFeesSeqNums(std::vector<TransactionFrameBasePtr>& txs,
                        AbstractLedgerTxn& ltxOuter, int64_t baseFee,
@@ -76,6 +85,22 @@ class LedgerManagerImpl : public LedgerManager
                      std::unique_ptr<LedgerCloseMeta> const& ledgerCloseMeta,
                      int& index);
 
+    // Records the result and meta of an applied tx in txResultSet, in
+    // ledgerCloseMeta and in the txhistory table.
+    void
+    recordTransaction(TransactionFrameBasePtr& tx, TransactionMeta const& tm,
+                      AbstractLedgerTxn& ltx,
+                      TransactionResultSet& txResultSet,
+                      std::unique_ptr<LedgerCloseMeta> const& ledgerCloseMeta,
+                      int& index);
+
+    // Applies the commutative phase with ParallelCommutativeApply when
+    // COMMUTATIVE_APPLY_SHARDS allows it, and serially otherwise.
+    void applyCommutativeTransactions(
+        std::vector<TransactionFrameBasePtr>& commutativeTxs,
+        AbstractLedgerTxn& ltx, TransactionResultSet& txResultSet,
+        std::unique_ptr<LedgerCloseMeta> const& ledgerCloseMeta, int& index);
+
     void
     applyTransactions(std::vector<TransactionFrameBasePtr>& commutativeTxs,
                       std::vector<TransactionFrameBasePtr>& noncommutativeTxs,
@@ -93,6 +118,9 @@ class LedgerManagerImpl : public LedgerManager
     void setState(State s);
 
     void emitNextMeta();
+    void writeMeta(LedgerCloseMeta const& meta, XDROutputFileStream* stream,
+                   XDROutputFileStream* debugStream);
+    void waitForPendingMetaWrite();
 
   protected:
     virtual void transferLedgerEntriesToBucketList(AbstractLedgerTxn& ltx,
@@ -106,6 +134,7 @@ class LedgerManagerImpl : public LedgerManager
 
   public:
     LedgerManagerImpl(Application& app);
+    ~LedgerManagerImpl();
 
     void moveToSynced() override;
     State getState() const override;
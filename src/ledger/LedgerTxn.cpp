@@ -3,6 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "ledger/LedgerTxn.h"
+#include "bucket/BucketList.h"
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
 #include "crypto/SecretKey.h"
@@ -2597,6 +2598,8 @@ LedgerTxnRoot::Impl::tableFromLedgerEntryType(LedgerEntryType let)
         return "claimablebalance";
     case LIQUIDITY_POOL:
         return "liquiditypool";
+    case SPEEDEX_CONFIG:
+        return "speedexconfig";
     default:
         throw std::runtime_error("Unknown ledger entry type");
     }
@@ -2750,6 +2753,17 @@ LedgerTxnRoot::Impl::prefetch(UnorderedSet<LedgerKey> const& keys)
 
     for (auto const& key : keys)
     {
+        if (mBucketList && !mEntryCache.exists(key, false))
+        {
+            std::shared_ptr<LedgerEntry const> entry;
+            if (loadFromBucketList(key, entry))
+            {
+                putInEntryCache(key, entry, LoadType::PREFETCH);
+                ++total;
+                continue;
+            }
+        }
+
         switch (key.type())
         {
         case ACCOUNT:
@@ -2829,6 +2843,30 @@ LedgerTxnRoot::getPrefetchHitRate() const
     return mImpl->getPrefetchHitRate();
 }
 
+void
+LedgerTxnRoot::setBucketListForReads(BucketList const* bucketList)
+{
+    mImpl->setBucketListForReads(bucketList);
+}
+
+void
+LedgerTxnRoot::Impl::setBucketListForReads(BucketList const* bucketList)
+{
+    mBucketList = bucketList;
+}
+
+bool
+LedgerTxnRoot::Impl::loadFromBucketList(
+    LedgerKey const& key, std::shared_ptr<LedgerEntry const>& entry) const
+{
+    // The SQL table is authoritative for the speedex config
+    if (!mBucketList || key.type() == SPEEDEX_CONFIG)
+    {
+        return false;
+    }
+    return mBucketList->getLedgerEntry(key, entry);
+}
+
 double
 LedgerTxnRoot::Impl::getPrefetchHitRate() const
 {
@@ -3291,6 +3329,13 @@ LedgerTxnRoot::Impl::getNewestVersion(InternalLedgerKey const& gkey) const
     std::shared_ptr<LedgerEntry const> entry;
     try
     {
+        if (loadFromBucketList(key, entry))
+        {
+            putInEntryCache(key, entry, LoadType::IMMEDIATE);
+            return entry ? std::make_shared<InternalLedgerEntry const>(*entry)
+                         : nullptr;
+        }
+
         switch (key.type())
         {
         case ACCOUNT:
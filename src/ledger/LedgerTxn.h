@@ -219,6 +219,7 @@ enum class LedgerTxnConsistency
     EXTRA_DELETES
 };
 
+class BucketList;
 class Database;
 struct InflationVotes;
 struct LedgerEntry;
@@ -845,6 +846,11 @@ class LedgerTxnRoot : public AbstractLedgerTxnParent
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
     double getPrefetchHitRate() const override;
 
+    // Serve point loads and prefetches from bucketList's indexes, falling
+    // back to SQL while any bucket is unindexed. Pass nullptr to stop.
+    // bucketList must outlive this.
+    void setBucketListForReads(BucketList const* bucketList);
+
 #ifdef BEST_OFFER_DEBUGGING
     bool bestOfferDebuggingEnabled() const override;
 
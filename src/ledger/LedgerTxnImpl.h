@@ -761,6 +761,7 @@ class LedgerTxnRoot::Impl
     mutable uint64_t mPrefetchMisses{0};
 
     size_t mBulkLoadBatchSize;
+    BucketList const* mBucketList{nullptr};
     std::unique_ptr<soci::transaction> mTransaction;
     AbstractLedgerTxn* mChild;
 
@@ -772,6 +773,11 @@ class LedgerTxnRoot::Impl
 
     void throwIfChild() const;
 
+    // Returns false if the bucket list can't answer for key, in which case
+    // entry is left alone.
+    bool loadFromBucketList(LedgerKey const& key,
+                            std::shared_ptr<LedgerEntry const>& entry) const;
+
     std::shared_ptr<LedgerEntry const> loadAccount(LedgerKey const& key) const;
     std::shared_ptr<LedgerEntry const> loadData(LedgerKey const& key) const;
     std::shared_ptr<LedgerEntry const> loadOffer(LedgerKey const& key) const;
@@ -990,6 +996,8 @@ class LedgerTxnRoot::Impl
 
     double getPrefetchHitRate() const;
 
+    void setBucketListForReads(BucketList const* bucketList);
+
 #ifdef BEST_OFFER_DEBUGGING
     bool bestOfferDebuggingEnabled() const;
 
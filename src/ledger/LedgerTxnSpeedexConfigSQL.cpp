@@ -1,10 +1,17 @@
+#include "database/Database.h"
+#include "database/DatabaseTypeSpecificOperation.h"
 #include "ledger/LedgerTxnImpl.h"
 #include "ledger/NonSociRelatedException.h"
+#include "util/GlobalChecks.h"
 #include "util/types.h"
 
 namespace stellar
 {
 
+// There is only ever one speedex config, so the table has at most one row,
+// keyed by this id.
+static int const SPEEDEX_CONFIG_ID = 0;
+
 static void
 throwIfNotSpeedexConfig(LedgerEntryType type)
 {
@@ -14,49 +21,51 @@ throwIfNotSpeedexConfig(LedgerEntryType type)
     }
 }
 
-LedgerEntry getDefaultSpeedexConfig() {
+static LedgerEntry
+getDefaultSpeedexConfig()
+{
     LedgerEntry entry;
     entry.data.type(SPEEDEX_CONFIG);
-    //TODO mock out default config
     return entry;
 }
 
-static LedgerEntry currentSpeedexConfig = getDefaultSpeedexConfig();
-
-std::shared_ptr<LedgerEntry const>
-LedgerTxnRoot::Impl::loadSpeedexConfig(LedgerKey const& key) const
-{
-    throwIfNotSpeedexConfig(key.type());   
-    return std::make_shared<LedgerEntry const>(currentSpeedexConfig);
-}
-
-class BulkLoadSpeedexConfigOperation
-    : public DatabaseTypeSpecificOperation<std::vector<LedgerEntry>>
+// Until a config is stored, loads act as though the default config exists
+// from genesis on.
+static std::shared_ptr<LedgerEntry const>
+loadStoredSpeedexConfig(Database& db)
 {
-    Database& mDb;
-
-  public:
-    BulkLoadSpeedexConfigOperation(Database& db,
-                                   UnorderedSet<LedgerKey> const& keys)
-        : mDb(db)
+    std::string speedexConfigEntryStr;
+
+    std::string sql = "SELECT ledgerentry "
+                      "FROM speedexconfig "
+                      "WHERE configid = :id";
+    auto prep = db.getPreparedStatement(sql);
+    auto& st = prep.statement();
+    st.exchange(soci::into(speedexConfigEntryStr));
+    st.exchange(soci::use(SPEEDEX_CONFIG_ID));
+    st.define_and_bind();
     {
+        auto timer = db.getSelectTimer("speedexconfig");
+        st.execute(true);
     }
-
-    std::vector<LedgerEntry>
-    doSqliteSpecificOperation(soci::sqlite3_session_backend* sq) override
+    if (!st.got_data())
     {
-        return {currentSpeedexConfig};
+        return std::make_shared<LedgerEntry const>(getDefaultSpeedexConfig());
     }
 
-#ifdef USE_POSTGRES
-    std::vector<LedgerEntry>
-    doPostgresSpecificOperation(soci::postgresql_session_backend* pg) override
-    {
+    LedgerEntry le;
+    fromOpaqueBase64(le, speedexConfigEntryStr);
+    throwIfNotSpeedexConfig(le.data.type());
 
-        return {currentSpeedexConfig};
-    }
-#endif
-};
+    return std::make_shared<LedgerEntry const>(std::move(le));
+}
+
+std::shared_ptr<LedgerEntry const>
+LedgerTxnRoot::Impl::loadSpeedexConfig(LedgerKey const& key) const
+{
+    throwIfNotSpeedexConfig(key.type());
+    return loadStoredSpeedexConfig(mDatabase);
+}
 
 UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
 LedgerTxnRoot::Impl::bulkLoadSpeedexConfig(
@@ -64,9 +73,12 @@ LedgerTxnRoot::Impl::bulkLoadSpeedexConfig(
 {
     if (!keys.empty())
     {
-        BulkLoadSpeedexConfigOperation op(mDatabase, keys);
-        return populateLoadedEntries(
-            keys, mDatabase.doDatabaseTypeSpecificOperation(op));
+        for (auto const& k : keys)
+        {
+            throwIfNotSpeedexConfig(k.type());
+        }
+        return populateLoadedEntries(keys,
+                                     {*loadStoredSpeedexConfig(mDatabase)});
     }
     else
     {
@@ -78,30 +90,46 @@ class BulkDeleteSpeedexConfigOperation
     : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDb;
-    LedgerTxnConsistency mCons;
 
   public:
-    BulkDeleteSpeedexConfigOperation(Database& db, LedgerTxnConsistency cons,
+    BulkDeleteSpeedexConfigOperation(Database& db,
                                      std::vector<EntryIterator> const& entries)
-        : mDb(db), mCons(cons)
+        : mDb(db)
     {
+        for (auto const& e : entries)
+        {
+            releaseAssert(!e.entryExists());
+            throwIfNotSpeedexConfig(e.key().ledgerKey().type());
+        }
     }
 
     void
     doSociGenericOperation()
     {
-
+        // No affected-rows check: deleting the default config, which was
+        // never stored, deletes nothing.
+        std::string sql = "DELETE FROM speedexconfig WHERE configid = :id";
+        auto prep = mDb.getPreparedStatement(sql);
+        auto& st = prep.statement();
+        st.exchange(soci::use(SPEEDEX_CONFIG_ID));
+        st.define_and_bind();
+        {
+            auto timer = mDb.getDeleteTimer("speedexconfig");
+            st.execute(true);
+        }
     }
 
     void
     doSqliteSpecificOperation(soci::sqlite3_session_backend* sq) override
     {
+        doSociGenericOperation();
     }
 
 #ifdef USE_POSTGRES
     void
     doPostgresSpecificOperation(soci::postgresql_session_backend* pg) override
     {
+        doSociGenericOperation();
     }
 #endif
 };
@@ -110,41 +138,73 @@ void
 LedgerTxnRoot::Impl::bulkDeleteSpeedexConfig (
     std::vector<EntryIterator> const& entries, LedgerTxnConsistency cons)
 {
-    BulkDeleteSpeedexConfigOperation op(mDatabase, cons, entries);
-    mDatabase.doDatabaseTypeSpecificOperation(op);
-    if (entries.size() > 0) {
-        currentSpeedexConfig = getDefaultSpeedexConfig();
+    if (entries.empty())
+    {
+        return;
     }
+    BulkDeleteSpeedexConfigOperation op(mDatabase, entries);
+    mDatabase.doDatabaseTypeSpecificOperation(op);
 }
 
 class BulkUpsertSpeedexConfigOperation
     : public DatabaseTypeSpecificOperation<void>
 {
     Database& mDb;
+    std::string mSpeedexConfigEntry;
+    int32_t mLastModified;
 
   public:
     BulkUpsertSpeedexConfigOperation(
         Database& Db, std::vector<EntryIterator> const& entryIter)
         : mDb(Db)
     {
+        releaseAssert(entryIter.size() == 1);
+        auto const& e = entryIter.front();
+        releaseAssert(e.entryExists());
+        auto const& entry = e.entry().ledgerEntry();
+        throwIfNotSpeedexConfig(entry.data.type());
+        mSpeedexConfigEntry = toOpaqueBase64(entry);
+        mLastModified = unsignedToSigned(entry.lastModifiedLedgerSeq);
     }
 
     void
     doSociGenericOperation()
     {
-
+        std::string sql = "INSERT INTO speedexconfig "
+                          "(configid, ledgerentry, lastmodified) "
+                          "VALUES "
+                          "( :id, :v1, :v2 ) "
+                          "ON CONFLICT (configid) DO UPDATE SET "
+                          "ledgerentry = excluded.ledgerentry, "
+                          "lastmodified = excluded.lastmodified";
+
+        auto prep = mDb.getPreparedStatement(sql);
+        soci::statement& st = prep.statement();
+        st.exchange(soci::use(SPEEDEX_CONFIG_ID));
+        st.exchange(soci::use(mSpeedexConfigEntry));
+        st.exchange(soci::use(mLastModified));
+        st.define_and_bind();
+        {
+            auto timer = mDb.getUpsertTimer("speedexconfig");
+            st.execute(true);
+        }
+        if (st.get_affected_rows() != 1)
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
     }
 
     void
     doSqliteSpecificOperation(soci::sqlite3_session_backend* sq) override
     {
+        doSociGenericOperation();
     }
 
 #ifdef USE_POSTGRES
     void
     doPostgresSpecificOperation(soci::postgresql_session_backend* pg) override
     {
-
+        doSociGenericOperation();
     }
 #endif
 };
@@ -153,21 +213,25 @@ void
 LedgerTxnRoot::Impl::bulkUpsertSpeedexConfig(
     std::vector<EntryIterator> const& entries)
 {
+    if (entries.empty())
+    {
+        return;
+    }
     BulkUpsertSpeedexConfigOperation op(mDatabase, entries);
     mDatabase.doDatabaseTypeSpecificOperation(op);
-    for (auto const& entry : entries) {
-        currentSpeedexConfig = entry.entry().ledgerEntry();
-    }
 }
 
 void
 LedgerTxnRoot::Impl::dropSpeedexConfigs()
 {
     throwIfChild();
-    //TODO do something, right now no-op
-    //no op
-    currentSpeedexConfig = getDefaultSpeedexConfig();
     clearAllCaches();
+
+    mDatabase.getSession() << "DROP TABLE IF EXISTS speedexconfig;";
+    mDatabase.getSession() << "CREATE TABLE speedexconfig ("
+                           << "configid     INT PRIMARY KEY, "
+                           << "ledgerentry  TEXT NOT NULL, "
+                           << "lastmodified INT NOT NULL);";
 }
 
-} /* namespace stellar */
\ No newline at end of file
+} /* namespace stellar */
@@ -0,0 +1,248 @@
+// Copyright 2021 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/ParallelCommutativeApply.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTxnEntry.h"
+#include "ledger/ShardLedgerTxnParent.h"
+#include "main/Application.h"
+#include "speedex/IOCOrderbookManager.h"
+#include "util/GlobalChecks.h"
+#include "util/Thread.h"
+#include "util/UnorderedMap.h"
+#include "util/UnorderedSet.h"
+#include "util/XDROperators.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include <Tracy.hpp>
+#include <algorithm>
+#include <mutex>
+
+namespace stellar
+{
+
+namespace
+{
+
+struct Shard
+{
+    // Indices into the tx set, in tx set order.
+    std::vector<size_t> txs;
+    LedgerTxnDelta delta;
+    IOCOrderbookManager offers;
+};
+
+// Every account whose account entry or trustlines tx may load or change.
+void
+insertTouchedAccounts(TransactionFrameBase const& tx,
+                      UnorderedSet<AccountID>& accounts)
+{
+    accounts.emplace(tx.getSourceID());
+    accounts.emplace(tx.getFeeSourceID());
+    for (auto const& acct : tx.getRelevantAccounts())
+    {
+        accounts.emplace(acct);
+    }
+
+    UnorderedSet<LedgerKey> keys;
+    tx.insertKeysForTxApply(keys);
+    for (auto const& key : keys)
+    {
+        switch (key.type())
+        {
+        case ACCOUNT:
+            accounts.emplace(key.account().accountID);
+            break;
+        case TRUSTLINE:
+            accounts.emplace(key.trustLine().accountID);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+size_t
+findRoot(std::vector<size_t>& parents, size_t i)
+{
+    while (parents[i] != i)
+    {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+// Returns false if two shards changed the same entry, or the header. Shards
+// touch disjoint sets of accounts, so this only guards against entries the
+// partition doesn't know about.
+bool
+mergeShards(std::vector<Shard>& shards, AbstractLedgerTxn& ltxOuter)
+{
+    ZoneScoped;
+    UnorderedMap<InternalLedgerKey, size_t> owners;
+    for (size_t s = 0; s < shards.size(); ++s)
+    {
+        auto const& delta = shards[s].delta;
+        if (!(delta.header.current == delta.header.previous))
+        {
+            return false;
+        }
+        for (auto const& kv : delta.entry)
+        {
+            auto const& current = kv.second.current;
+            auto const& previous = kv.second.previous;
+            if (current && previous && *current == *previous)
+            {
+                // loaded, but left as is
+                continue;
+            }
+            if (!owners.emplace(kv.first, s).second)
+            {
+                return false;
+            }
+        }
+    }
+
+    LedgerTxn ltx(ltxOuter);
+    for (auto const& kv : owners)
+    {
+        auto const& change = shards[kv.second].delta.entry.at(kv.first);
+        if (!change.current)
+        {
+            ltx.erase(kv.first);
+        }
+        else if (!change.previous)
+        {
+            ltx.create(*change.current);
+        }
+        else
+        {
+            ltx.load(kv.first).currentGeneralized() = *change.current;
+        }
+    }
+
+    for (auto& shard : shards)
+    {
+        ltx.getSpeedexIOCOffers().commitChild(shard.offers);
+    }
+    ltx.commit();
+    return true;
+}
+}
+
+ParallelCommutativeApply::ParallelCommutativeApply(Application& app,
+                                                   AbstractLedgerTxn& ltx,
+                                                   uint32_t numShards)
+    : mApp(app), mLtx(ltx), mNumShards(numShards)
+{
+    releaseAssert(mNumShards > 0);
+}
+
+std::vector<std::vector<size_t>>
+ParallelCommutativeApply::partition(
+    std::vector<TransactionFrameBasePtr> const& txs, uint32_t numShards)
+{
+    ZoneScoped;
+    // Union the txs that touch a common account, each account being joined
+    // to the first tx that touched it.
+    std::vector<size_t> parents(txs.size());
+    UnorderedMap<AccountID, size_t> firstTx;
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        parents[i] = i;
+        UnorderedSet<AccountID> accounts;
+        insertTouchedAccounts(*txs[i], accounts);
+        for (auto const& acct : accounts)
+        {
+            auto res = firstTx.emplace(acct, i);
+            if (!res.second)
+            {
+                auto a = findRoot(parents, i);
+                auto b = findRoot(parents, res.first->second);
+                // the lower index is the root, so roots don't depend on
+                // hash map iteration order
+                parents[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+
+    std::vector<size_t> groupSizes(txs.size(), 0);
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        ++groupSizes[findRoot(parents, i)];
+    }
+
+    // Groups go, in order of their first tx, to the shard with the fewest
+    // txs so far (the lowest one on ties).
+    std::vector<size_t> shardLoads(numShards, 0);
+    std::vector<size_t> shardOfGroup(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        if (findRoot(parents, i) == i)
+        {
+            auto best = std::min_element(shardLoads.begin(), shardLoads.end());
+            shardOfGroup[i] = best - shardLoads.begin();
+            *best += groupSizes[i];
+        }
+    }
+
+    std::vector<std::vector<size_t>> shards(numShards);
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        shards[shardOfGroup[findRoot(parents, i)]].emplace_back(i);
+    }
+    return shards;
+}
+
+bool
+ParallelCommutativeApply::apply(std::vector<TransactionFrameBasePtr> const& txs,
+                                std::vector<TransactionMeta>& metas)
+{
+    ZoneScoped;
+    std::vector<Shard> shards(mNumShards);
+    auto partitioned = partition(txs, mNumShards);
+    for (size_t s = 0; s < shards.size(); ++s)
+    {
+        shards[s].txs = std::move(partitioned[s]);
+    }
+
+    std::vector<TransactionFrameBase::ApplyState> initialStates;
+    initialStates.reserve(txs.size());
+    for (auto const& tx : txs)
+    {
+        initialStates.emplace_back(tx->saveApplyState());
+    }
+    metas.assign(txs.size(), TransactionMeta(2));
+
+    std::mutex outerMutex;
+    parallelFor(shards.size(), shards.size() - 1, [&](size_t s) {
+        ZoneNamedN(shardZone, "applyCommutativeShard", true);
+        auto& shard = shards[s];
+        ShardLedgerTxnParent parent(mLtx, outerMutex);
+        LedgerTxn ltx(parent);
+        for (auto i : shard.txs)
+        {
+            txs[i]->apply(mApp, ltx, metas[i]);
+        }
+        shard.offers.commitChild(ltx.getSpeedexIOCOffers());
+        shard.delta = ltx.getDelta();
+    });
+
+    if (mergeShards(shards, mLtx))
+    {
+        return true;
+    }
+
+    mApp.getMetrics()
+        .NewMeter({"ledger", "commutative-apply", "serial-fallback"}, "ledger")
+        .Mark();
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        txs[i]->restoreApplyState(initialStates[i]);
+    }
+    metas.clear();
+    return false;
+}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// Copyright 2021 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionFrameBase.h"
+#include "xdr/Stellar-ledger.h"
+#include <cstdint>
+#include <vector>
+
+// ParallelCommutativeApply applies the commutative phase of a ledger on
+// several threads.
+//
+// Transactions are grouped by the accounts they touch: their source, fee and
+// operation source accounts, and the accounts (or trustlines) they pay. Two
+// transactions touching a common account always end up in the same group, and
+// each group goes whole to one shard. Each shard is applied, in tx set order,
+// in its own LedgerTxn that reads the phase's starting state from the outer
+// LedgerTxn and collects its own speedex IOC offers.
+//
+// Since no two shards touch the same account or trustline, every transaction
+// sees the same entries as in a serial apply, so its result and meta do not
+// depend on the number of shards. In particular a credit that runs into a
+// trustline limit is checked against the same credits, in the same order.
+//
+// The shards' changes are then copied into the outer LedgerTxn and their IOC
+// offers moved into the outer IOCOrderbookManager. If two shards changed the
+// same entry anyway, nothing is merged and the caller applies the phase
+// serially instead.
+
+namespace stellar
+{
+
+class AbstractLedgerTxn;
+class Application;
+
+class ParallelCommutativeApply
+{
+    Application& mApp;
+    AbstractLedgerTxn& mLtx;
+    uint32_t const mNumShards;
+
+  public:
+    ParallelCommutativeApply(Application& app, AbstractLedgerTxn& ltx,
+                             uint32_t numShards);
+
+    // Applies txs, setting metas[i] to the meta of txs[i]. Returns false if
+    // the shards could not be merged, in which case ltx and the apply state
+    // of txs are as they were before the call, and metas is empty.
+    bool apply(std::vector<TransactionFrameBasePtr> const& txs,
+               std::vector<TransactionMeta>& metas);
+
+    // Splits txs into numShards shards of tx indices, each in tx set order.
+    // Depends only on txs and numShards, so every node shards a tx set alike.
+    static std::vector<std::vector<size_t>>
+    partition(std::vector<TransactionFrameBasePtr> const& txs,
+              uint32_t numShards);
+};
+}
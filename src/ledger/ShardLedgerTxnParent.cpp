@@ -0,0 +1,213 @@
+// Copyright 2021 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/ShardLedgerTxnParent.h"
+#include <stdexcept>
+#include <string>
+
+namespace stellar
+{
+
+ShardLedgerTxnParent::ShardLedgerTxnParent(AbstractLedgerTxn& outer,
+                                           std::mutex& outerMutex)
+    : mOuter(outer), mOuterMutex(outerMutex), mHeader(outer.getHeader())
+{
+}
+
+void
+ShardLedgerTxnParent::throwUnsupported(char const* method)
+{
+    throw std::runtime_error(std::string("called ") + method +
+                             " on ShardLedgerTxnParent");
+}
+
+void
+ShardLedgerTxnParent::addChild(AbstractLedgerTxn& child)
+{
+    if (mChild)
+    {
+        throw std::runtime_error("ShardLedgerTxnParent already has child");
+    }
+    mChild = &child;
+}
+
+void
+ShardLedgerTxnParent::commitChild(EntryIterator iter,
+                                  LedgerTxnConsistency cons)
+{
+    throw std::logic_error("shard LedgerTxns can't be committed");
+}
+
+void
+ShardLedgerTxnParent::rollbackChild()
+{
+    mChild = nullptr;
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+ShardLedgerTxnParent::getAllOffers()
+{
+    std::lock_guard<std::mutex> lock(mOuterMutex);
+    return mOuter.getAllOffers();
+}
+
+std::shared_ptr<LedgerEntry const>
+ShardLedgerTxnParent::getBestOffer(Asset const& buying, Asset const& selling)
+{
+    std::lock_guard<std::mutex> lock(mOuterMutex);
+    return mOuter.getBestOffer(buying, selling);
+}
+
+std::shared_ptr<LedgerEntry const>
+ShardLedgerTxnParent::getBestOffer(Asset const& buying, Asset const& selling,
+                                   OfferDescriptor const& worseThan)
+{
+    std::lock_guard<std::mutex> lock(mOuterMutex);
+    return mOuter.getBestOffer(buying, selling, worseThan);
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+ShardLedgerTxnParent::getOffersByAccountAndAsset(AccountID const& account,
+                                                 Asset const& asset)
+{
+    std::lock_guard<std::mutex> lock(mOuterMutex);
+    return mOuter.getOffersByAccountAndAsset(account, asset);
+}
+
+UnorderedMap<LedgerKey, LedgerEntry>
+ShardLedgerTxnParent::getPoolShareTrustLinesByAccountAndAsset(
+    AccountID const& account, Asset const& asset)
+{
+    std::lock_guard<std::mutex> lock(mOuterMutex);
+    return mOuter.getPoolShareTrustLinesByAccountAndAsset(account, asset);
+}
+
+LedgerHeader const&
+ShardLedgerTxnParent::getHeader() const
+{
+    return mHeader;
+}
+
+std::vector<InflationWinner>
+ShardLedgerTxnParent::getInflationWinners(size_t maxWinners,
+                                          int64_t minBalance)
+{
+    std::lock_guard<std::mutex> lock(mOuterMutex);
+    return mOuter.getInflationWinners(maxWinners, minBalance);
+}
+
+std::shared_ptr<InternalLedgerEntry const>
+ShardLedgerTxnParent::getNewestVersion(InternalLedgerKey const& key) const
+{
+    std::lock_guard<std::mutex> lock(mOuterMutex);
+    return mOuter.getNewestVersion(key);
+}
+
+std::shared_ptr<const LedgerEntry>
+ShardLedgerTxnParent::loadSnapshotEntry(LedgerKey const& key) const
+{
+    std::lock_guard<std::mutex> lock(mOuterMutex);
+    return mOuter.loadSnapshotEntry(key);
+}
+
+uint64_t
+ShardLedgerTxnParent::countObjects(LedgerEntryType let) const
+{
+    throwUnsupported("countObjects");
+}
+
+uint64_t
+ShardLedgerTxnParent::countObjects(LedgerEntryType let,
+                                   LedgerRange const& ledgers) const
+{
+    throwUnsupported("countObjects");
+}
+
+void
+ShardLedgerTxnParent::deleteObjectsModifiedOnOrAfterLedger(
+    uint32_t ledger) const
+{
+    throwUnsupported("deleteObjectsModifiedOnOrAfterLedger");
+}
+
+void
+ShardLedgerTxnParent::dropAccounts()
+{
+    throwUnsupported("dropAccounts");
+}
+
+void
+ShardLedgerTxnParent::dropData()
+{
+    throwUnsupported("dropData");
+}
+
+void
+ShardLedgerTxnParent::dropOffers()
+{
+    throwUnsupported("dropOffers");
+}
+
+void
+ShardLedgerTxnParent::dropTrustLines()
+{
+    throwUnsupported("dropTrustLines");
+}
+
+void
+ShardLedgerTxnParent::dropClaimableBalances()
+{
+    throwUnsupported("dropClaimableBalances");
+}
+
+void
+ShardLedgerTxnParent::dropLiquidityPools()
+{
+    throwUnsupported("dropLiquidityPools");
+}
+
+void
+ShardLedgerTxnParent::dropSpeedexConfigs()
+{
+    throwUnsupported("dropSpeedexConfigs");
+}
+
+double
+ShardLedgerTxnParent::getPrefetchHitRate() const
+{
+    throwUnsupported("getPrefetchHitRate");
+}
+
+uint32_t
+ShardLedgerTxnParent::prefetch(UnorderedSet<LedgerKey> const& keys)
+{
+    throwUnsupported("prefetch");
+}
+
+#ifdef BUILD_TESTS
+void
+ShardLedgerTxnParent::resetForFuzzer()
+{
+    abort();
+}
+#endif // BUILD_TESTS
+
+#ifdef BEST_OFFER_DEBUGGING
+bool
+ShardLedgerTxnParent::bestOfferDebuggingEnabled() const
+{
+    return mOuter.bestOfferDebuggingEnabled();
+}
+
+std::shared_ptr<LedgerEntry const>
+ShardLedgerTxnParent::getBestOfferSlow(Asset const& buying,
+                                       Asset const& selling,
+                                       OfferDescriptor const* worseThan,
+                                       std::unordered_set<int64_t>& exclude)
+{
+    std::lock_guard<std::mutex> lock(mOuterMutex);
+    return mOuter.getBestOfferSlow(buying, selling, worseThan, exclude);
+}
+#endif
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+// Copyright 2021 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerTxn.h"
+#include <mutex>
+
+// ShardLedgerTxnParent lets several threads each open a LedgerTxn over the
+// same outer AbstractLedgerTxn, which allows only one child and is not
+// thread-safe. Every read goes to the outer LedgerTxn under a lock that all
+// of its shards share, so the outer LedgerTxn must not be written while any
+// shard is open.
+//
+// Shard LedgerTxns can't be committed: whoever opened them reads their
+// changes (e.g. with getDelta) and merges them into the outer LedgerTxn once
+// every shard is done, or just lets them roll back if they only read.
+
+namespace stellar
+{
+
+class ShardLedgerTxnParent : public AbstractLedgerTxnParent
+{
+    AbstractLedgerTxn& mOuter;
+    std::mutex& mOuterMutex;
+    LedgerHeader const mHeader;
+    AbstractLedgerTxn* mChild{nullptr};
+
+    [[noreturn]] static void throwUnsupported(char const* method);
+
+  public:
+    ShardLedgerTxnParent(AbstractLedgerTxn& outer, std::mutex& outerMutex);
+
+    void addChild(AbstractLedgerTxn& child) override;
+    void commitChild(EntryIterator iter, LedgerTxnConsistency cons) override;
+    void rollbackChild() override;
+
+    UnorderedMap<LedgerKey, LedgerEntry> getAllOffers() override;
+    std::shared_ptr<LedgerEntry const>
+    getBestOffer(Asset const& buying, Asset const& selling) override;
+    std::shared_ptr<LedgerEntry const>
+    getBestOffer(Asset const& buying, Asset const& selling,
+                 OfferDescriptor const& worseThan) override;
+    UnorderedMap<LedgerKey, LedgerEntry>
+    getOffersByAccountAndAsset(AccountID const& account,
+                               Asset const& asset) override;
+
+    UnorderedMap<LedgerKey, LedgerEntry>
+    getPoolShareTrustLinesByAccountAndAsset(AccountID const& account,
+                                            Asset const& asset) override;
+
+    LedgerHeader const& getHeader() const override;
+
+    std::vector<InflationWinner>
+    getInflationWinners(size_t maxWinners, int64_t minBalance) override;
+
+    std::shared_ptr<InternalLedgerEntry const>
+    getNewestVersion(InternalLedgerKey const& key) const override;
+
+    std::shared_ptr<const LedgerEntry>
+    loadSnapshotEntry(LedgerKey const& key) const override;
+
+    uint64_t countObjects(LedgerEntryType let) const override;
+    uint64_t countObjects(LedgerEntryType let,
+                          LedgerRange const& ledgers) const override;
+
+    void deleteObjectsModifiedOnOrAfterLedger(uint32_t ledger) const override;
+
+    void dropAccounts() override;
+    void dropData() override;
+    void dropOffers() override;
+    void dropTrustLines() override;
+    void dropClaimableBalances() override;
+    void dropLiquidityPools() override;
+    void dropSpeedexConfigs() override;
+    double getPrefetchHitRate() const override;
+    uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
+
+#ifdef BUILD_TESTS
+    void resetForFuzzer() override;
+#endif // BUILD_TESTS
+
+#ifdef BEST_OFFER_DEBUGGING
+    bool bestOfferDebuggingEnabled() const override;
+
+    std::shared_ptr<LedgerEntry const>
+    getBestOfferSlow(Asset const& buying, Asset const& selling,
+                     OfferDescriptor const* worseThan,
+                     std::unordered_set<int64_t>& exclude) override;
+#endif
+};
+}
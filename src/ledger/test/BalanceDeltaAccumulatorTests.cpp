@@ -0,0 +1,120 @@
+#include "ledger/BalanceDeltaAccumulator.h"
+#include "ledger/LedgerTxn.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+TEST_CASE("balance delta accumulator", "[ledger][balancedelta]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+
+    auto root = TestAccount::createRoot(*app);
+    auto minBalance = app->getLedgerManager().getLastMinBalance(2);
+
+    auto issuer = root.create("issuer", minBalance);
+    auto a1 = root.create("a1", minBalance + 1000);
+    auto a2 = root.create("a2", minBalance + 1000);
+
+    auto usd = issuer.asset("USD");
+    a1.changeTrust(usd, 1000);
+    a2.changeTrust(usd, 1000);
+    issuer.pay(a1, usd, 500);
+    issuer.pay(a2, usd, 500);
+
+    auto xlm1 = a1.getBalance();
+    auto xlm2 = a2.getBalance();
+
+    SECTION("deltas are netted per entry")
+    {
+        BalanceDeltaAccumulator balances;
+        balances.addDelta(a1, usd, -300);
+        balances.addDelta(a1, usd, 400);
+        balances.addDelta(a2, usd, 100);
+        balances.addDelta(a2, usd, -100);
+        balances.addDelta(a1, Asset{}, 50);
+        balances.addDelta(a2, Asset{}, -50);
+        REQUIRE(balances.size() == 3);
+
+        {
+            LedgerTxn ltx(app->getLedgerTxnRoot());
+            balances.apply(ltx);
+            ltx.commit();
+        }
+        REQUIRE(balances.empty());
+
+        REQUIRE(a1.getTrustlineBalance(usd) == 600);
+        REQUIRE(a2.getTrustlineBalance(usd) == 500);
+        REQUIRE(a1.getBalance() == xlm1 + 50);
+        REQUIRE(a2.getBalance() == xlm2 - 50);
+    }
+
+    SECTION("intermediate overdraft is fine if the net delta is")
+    {
+        BalanceDeltaAccumulator balances;
+        balances.addDelta(a1, usd, -700);
+        balances.addDelta(a1, usd, 300);
+
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        balances.apply(ltx);
+        ltx.commit();
+
+        REQUIRE(a1.getTrustlineBalance(usd) == 100);
+    }
+
+    SECTION("intermediate limit violation is fine if the net delta is")
+    {
+        // On its own, the credit would take a1 to 1300, over its limit of
+        // 1000; netted with the debit, a1 ends at 900.
+        BalanceDeltaAccumulator balances;
+        balances.addDelta(a1, usd, 800);
+        balances.addDelta(a1, usd, -400);
+
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        balances.apply(ltx);
+        ltx.commit();
+
+        REQUIRE(a1.getTrustlineBalance(usd) == 900);
+    }
+
+    SECTION("limit violation throws")
+    {
+        BalanceDeltaAccumulator balances;
+        balances.addDelta(a1, usd, 501);
+
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE_THROWS(balances.apply(ltx));
+    }
+
+    SECTION("net limit violation throws whatever the order of deltas")
+    {
+        BalanceDeltaAccumulator balances;
+        balances.addDelta(a1, usd, -400);
+        balances.addDelta(a1, usd, 901);
+
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE_THROWS(balances.apply(ltx));
+    }
+
+    SECTION("missing trustline throws")
+    {
+        BalanceDeltaAccumulator balances;
+        balances.addDelta(a1, issuer.asset("EUR"), 1);
+
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE_THROWS(balances.apply(ltx));
+    }
+
+    SECTION("overflow throws")
+    {
+        BalanceDeltaAccumulator balances;
+        balances.addDelta(a1, usd, INT64_MAX);
+        REQUIRE_THROWS(balances.addDelta(a1, usd, 1));
+    }
+}
@@ -12,8 +12,10 @@
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/ApplicationUtils.h"
+#include "main/PersistentState.h"
 #include "simulation/Simulation.h"
 #include "test/TestUtils.h"
+#include "test/TxTests.h"
 #include "test/test.h"
 #include "util/Logging.h"
 #include "work/WorkScheduler.h"
@@ -247,6 +249,7 @@ TEST_CASE("LedgerCloseMetaStream file descriptor - REPLAY_IN_MEMORY",
 #endif
 
     bool const delayMeta = GENERATE(true, false);
+    bool const asyncMeta = GENERATE(true, false);
 
     // Step 3: pass it to an application and have it catch up to the generated
     // history, streaming ledgerCloseMeta to the file descriptor.
@@ -258,6 +261,7 @@ TEST_CASE("LedgerCloseMetaStream file descriptor - REPLAY_IN_MEMORY",
         cfg.RUN_STANDALONE = true;
         cfg.setInMemoryMode();
         cfg.EXPERIMENTAL_PRECAUTION_DELAY_META = delayMeta;
+        cfg.EXPERIMENTAL_ASYNC_META_WRITES = asyncMeta;
         VirtualClock clock;
         auto app = createTestApplication(clock, cfg, /*newdb=*/false);
 
@@ -385,4 +389,100 @@ TEST_CASE("METADATA_DEBUG_LEDGERS works", "[metadebug]")
         clock.crank(false);
     }
     REQUIRE(gotToExpectedSize);
-}
\ No newline at end of file
+}
+
+TEST_CASE("EXPERIMENTAL_ASYNC_META_WRITES", "[ledgerclosemetastreamasync]")
+{
+    TmpDirManager tdm(std::string("streamtmp-") + binToHex(randomBytes(8)));
+    TmpDir td = tdm.tmpDir("streams");
+    std::string path = td.getName() + "/stream.xdr";
+
+    VirtualClock clock;
+    Config cfg = getTestConfig();
+    cfg.METADATA_OUTPUT_STREAM = path;
+    cfg.EXPERIMENTAL_ASYNC_META_WRITES = true;
+
+    std::vector<Hash> hashes;
+    {
+        auto app = createTestApplication(clock, cfg);
+        auto& lm = app->getLedgerManager();
+        for (int i = 0; i < 5; ++i)
+        {
+            txtest::closeLedgerOn(*app, lm.getLastClosedLedgerNum() + 1, 1, 1,
+                                  2021);
+            hashes.emplace_back(lm.getLastClosedLedgerHeader().hash);
+        }
+
+        // Each ledger's meta is written before it commits.
+        auto lastWritten = app->getPersistentState().getState(
+            PersistentState::kLastWrittenMeta);
+        REQUIRE(std::stoul(lastWritten) == lm.getLastClosedLedgerNum());
+    }
+
+    // Shutting down waits for the last write.
+    XDRInputFileStream stream;
+    stream.open(path);
+    LedgerCloseMeta lcm;
+    std::vector<Hash> streamed;
+    while (stream && stream.readOne(lcm))
+    {
+        streamed.emplace_back(lcm.v0().ledgerHeader.hash);
+    }
+    REQUIRE(streamed == hashes);
+}
+
+TEST_CASE("EXPERIMENTAL_ASYNC_META_WRITES across a restart",
+          "[ledgerclosemetastreamasync]")
+{
+    TmpDirManager tdm(std::string("streamtmp-") + binToHex(randomBytes(8)));
+    TmpDir td = tdm.tmpDir("streams");
+    std::string path = td.getName() + "/stream.xdr";
+
+    Config cfg = getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE);
+    cfg.METADATA_OUTPUT_STREAM = path;
+    cfg.EXPERIMENTAL_ASYNC_META_WRITES = true;
+
+    auto readStream = [&]() {
+        XDRInputFileStream stream;
+        stream.open(path);
+        LedgerCloseMeta lcm;
+        std::vector<Hash> streamed;
+        while (stream && stream.readOne(lcm))
+        {
+            streamed.emplace_back(lcm.v0().ledgerHeader.hash);
+        }
+        return streamed;
+    };
+
+    std::vector<Hash> hashes;
+    {
+        VirtualClock clock;
+        auto app = createTestApplication(clock, cfg);
+        auto& lm = app->getLedgerManager();
+        for (int i = 0; i < 5; ++i)
+        {
+            txtest::closeLedgerOn(*app, lm.getLastClosedLedgerNum() + 1, 1, 1,
+                                  2021);
+            hashes.emplace_back(lm.getLastClosedLedgerHeader().hash);
+
+            // What a crash right after this commit would leave behind: the
+            // stream must already hold every committed ledger's meta.
+            REQUIRE(readStream() == hashes);
+        }
+    }
+
+    // The restarted node resumes from the LCL, and the stream it left holds
+    // the meta of every ledger up to it.
+    auto streamed = readStream();
+    Config cfg2(cfg);
+    cfg2.FORCE_SCP = false;
+    VirtualClock clock2;
+    auto app2 = Application::create(clock2, cfg2, false);
+    app2->start();
+    auto& lm2 = app2->getLedgerManager();
+    REQUIRE(lm2.getLastClosedLedgerHeader().hash == streamed.back());
+    REQUIRE(std::stoul(app2->getPersistentState().getState(
+                PersistentState::kLastWrittenMeta)) ==
+            lm2.getLastClosedLedgerNum());
+    REQUIRE(streamed == hashes);
+}
@@ -2,8 +2,13 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "bucket/BucketList.h"
+#include "bucket/BucketManager.h"
+#include "ledger/InMemoryLedgerTxnRoot.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerRange.h"
 #include "ledger/LedgerTxnHeader.h"
 #include "ledger/NonSociRelatedException.h"
 #include "ledger/test/LedgerTestUtils.h"
@@ -4011,3 +4016,212 @@ TEST_CASE("LedgerTxn loadPoolShareTrustLinesByAccountAndAsset", "[ledgertxn]")
         }
     }
 }
+
+TEST_CASE("InMemoryLedgerTxnRoot", "[ledgertxn][inmemory]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    InMemoryLedgerTxnRoot root(app->getDatabase()
+#ifdef BEST_OFFER_DEBUGGING
+                                   ,
+                               app->getConfig().BEST_OFFER_DEBUGGING_ENABLED
+#endif
+    );
+    {
+        LedgerTxn ltx(root);
+        ltx.loadHeader().current() =
+            app->getLedgerManager().getLastClosedLedgerHeader().header;
+        ltx.commit();
+    }
+
+    auto native = txtest::makeNativeAsset();
+    auto usd = txtest::makeAsset(SecretKey::pseudoRandomForTesting(), "USD");
+    auto seller = PubKeyUtils::pseudoRandomForTesting();
+
+    auto makeOffer = [&](int64_t offerID, Asset const& buying,
+                         Asset const& selling, Price const& price) {
+        LedgerEntry le;
+        le.data.type(OFFER);
+        auto& oe = le.data.offer();
+        oe = LedgerTestUtils::generateValidOfferEntry();
+        oe.sellerID = seller;
+        oe.offerID = offerID;
+        oe.buying = buying;
+        oe.selling = selling;
+        oe.price = price;
+        return le;
+    };
+    auto offerKey = [&](int64_t offerID) {
+        LedgerKey key(OFFER);
+        key.offer().sellerID = seller;
+        key.offer().offerID = offerID;
+        return key;
+    };
+    auto bestID = [&](OfferDescriptor const* worseThan) -> int64_t {
+        auto best = worseThan ? root.getBestOffer(usd, native, *worseThan)
+                              : root.getBestOffer(usd, native);
+        return best ? best->data.offer().offerID : 0;
+    };
+
+    {
+        LedgerTxn ltx(root);
+        ltx.create(makeOffer(1, usd, native, Price{3, 2}));
+        ltx.create(makeOffer(2, usd, native, Price{1, 1}));
+        ltx.create(makeOffer(5, usd, native, Price{1, 1}));
+        ltx.create(makeOffer(3, native, usd, Price{1, 1}));
+        ltx.commit();
+    }
+    REQUIRE(root.countObjects(OFFER) == 4);
+    REQUIRE(root.countObjects(ACCOUNT) == 0);
+
+    SECTION("best offers come out in price then offerID order")
+    {
+        REQUIRE(bestID(nullptr) == 2);
+        OfferDescriptor d2{Price{1, 1}, 2};
+        OfferDescriptor d5{Price{1, 1}, 5};
+        OfferDescriptor d1{Price{3, 2}, 1};
+        REQUIRE(bestID(&d2) == 5);
+        REQUIRE(bestID(&d5) == 1);
+        REQUIRE(bestID(&d1) == 0);
+        REQUIRE(root.getBestOffer(native, usd)->data.offer().offerID == 3);
+    }
+
+    SECTION("updates and erasures reach the order book")
+    {
+        {
+            LedgerTxn ltx(root);
+            auto offer = ltx.load(offerKey(1));
+            offer.current().data.offer().price = Price{1, 2};
+            ltx.erase(offerKey(2));
+            ltx.commit();
+        }
+        REQUIRE(root.countObjects(OFFER) == 3);
+        REQUIRE(bestID(nullptr) == 1);
+        OfferDescriptor d1{Price{1, 2}, 1};
+        REQUIRE(bestID(&d1) == 5);
+        REQUIRE(root.getAllOffers().size() == 3);
+        REQUIRE(root.getOffersByAccountAndAsset(seller, usd).size() == 3);
+        REQUIRE(root.getOffersByAccountAndAsset(
+                        PubKeyUtils::pseudoRandomForTesting(), usd)
+                    .empty());
+    }
+
+    SECTION("rolled back children change nothing")
+    {
+        {
+            LedgerTxn ltx(root);
+            ltx.erase(offerKey(2));
+            ltx.create(makeOffer(7, usd, native, Price{1, 3}));
+        }
+        REQUIRE(root.countObjects(OFFER) == 4);
+        REQUIRE(bestID(nullptr) == 2);
+        REQUIRE(!root.getNewestVersion(offerKey(7)));
+    }
+
+    SECTION("entries modified on or after a ledger can be deleted")
+    {
+        auto lcl = root.getHeader().ledgerSeq;
+        {
+            LedgerTxn ltx(root);
+            ltx.loadHeader().current().ledgerSeq = lcl + 1;
+            ltx.create(makeOffer(7, usd, native, Price{1, 3}));
+            ltx.commit();
+        }
+        REQUIRE(bestID(nullptr) == 7);
+        REQUIRE(root.countObjects(OFFER, LedgerRange(lcl + 1, 1)) == 1);
+        root.deleteObjectsModifiedOnOrAfterLedger(lcl + 1);
+        REQUIRE(root.countObjects(OFFER) == 4);
+        REQUIRE(bestID(nullptr) == 2);
+    }
+}
+
+TEST_CASE("LedgerTxnRoot loads from the BucketList", "[ledgertxn][bucketindex]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.EXPERIMENTAL_BUCKET_INDEX_READS = true;
+    auto app = createTestApplication(clock, cfg);
+
+    auto root = txtest::getRoot(app->getNetworkID());
+    auto minBalance = app->getLedgerManager().getLastMinBalance(0);
+    SequenceNumber rootSeq;
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        rootSeq = txtest::loadAccount(ltx, root.getPublicKey())
+                      .current()
+                      .data.account()
+                      .seqNum;
+    }
+
+    std::vector<TransactionFrameBasePtr> txs;
+    std::vector<LedgerKey> keys{accountKey(root.getPublicKey())};
+    for (int i = 0; i < 5; ++i)
+    {
+        auto sk = txtest::getAccount(fmt::format("a{}", i));
+        txs.emplace_back(txtest::transactionFromOperations(
+            *app, root, ++rootSeq,
+            {txtest::createAccount(sk.getPublicKey(), minBalance + i)}));
+        keys.emplace_back(accountKey(sk.getPublicKey()));
+    }
+    auto lcl = app->getLedgerManager().getLastClosedLedgerNum();
+    txtest::closeLedgerOn(*app, lcl + 1, 1, 1, 2020, txs);
+
+    // live entries are in the buckets, and so are the missing ones: every
+    // bucket is indexed, so the BucketList can tell they don't exist
+    auto const& bl = app->getBucketManager().getBucketList();
+    for (auto const& key : keys)
+    {
+        std::shared_ptr<LedgerEntry const> entry;
+        REQUIRE(bl.getLedgerEntry(key, entry));
+        REQUIRE(entry);
+    }
+    for (int i = 0; i < 5; ++i)
+    {
+        auto key = accountKey(
+            txtest::getAccount(fmt::format("missing{}", i))
+                .getPublicKey());
+        std::shared_ptr<LedgerEntry const> entry;
+        REQUIRE(bl.getLedgerEntry(key, entry));
+        REQUIRE(!entry);
+        keys.emplace_back(key);
+    }
+    // only ever loaded from SQL, which is authoritative for it
+    keys.emplace_back(LedgerKey(SPEEDEX_CONFIG));
+
+    auto makeRoot = [&]() {
+        return std::make_unique<LedgerTxnRoot>(
+            app->getDatabase(), 100, 10
+#ifdef BEST_OFFER_DEBUGGING
+            ,
+            app->getConfig().BEST_OFFER_DEBUGGING_ENABLED
+#endif
+        );
+    };
+    auto sqlRoot = makeRoot();
+    auto bucketRoot = makeRoot();
+    bucketRoot->setBucketListForReads(&bl);
+
+    auto requireSameAsSql = [&]() {
+        for (auto const& key : keys)
+        {
+            auto fromBuckets = bucketRoot->getNewestVersion(key);
+            auto fromSql = sqlRoot->getNewestVersion(key);
+            REQUIRE(!fromBuckets == !fromSql);
+            if (fromSql)
+            {
+                REQUIRE(*fromBuckets == *fromSql);
+            }
+        }
+    };
+
+    SECTION("getNewestVersion")
+    {
+        requireSameAsSql();
+    }
+    SECTION("prefetch")
+    {
+        UnorderedSet<LedgerKey> keySet(keys.begin(), keys.end());
+        REQUIRE(bucketRoot->prefetch(keySet) == sqlRoot->prefetch(keySet));
+        requireSameAsSql();
+    }
+}
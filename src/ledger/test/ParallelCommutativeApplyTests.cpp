@@ -0,0 +1,240 @@
+// Copyright 2021 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerManager.h"
+#include "ledger/ParallelCommutativeApply.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include <algorithm>
+#include <functional>
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+namespace
+{
+struct CommutativePhaseOutcome
+{
+    std::vector<TransactionResultPair> results;
+    std::vector<int64_t> balances;
+    Hash txSetResultHash;
+    // shards the txs were split into, and how often apply fell back to serial
+    std::vector<std::vector<size_t>> shards;
+    int64_t serialFallbacks;
+};
+
+using MakeTxs = std::function<std::vector<TransactionFrameBasePtr>(
+    Application&, TestAccount& root, std::vector<TestAccount>& accounts)>;
+using GetBalance = std::function<int64_t(TestAccount const&)>;
+
+// Closes one ledger of the commutative txs made by makeTxs, recording the
+// balances of the accounts it created.
+CommutativePhaseOutcome
+closeCommutativeLedger(Config cfg, MakeTxs const& makeTxs,
+                       GetBalance const& getBalance)
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+    std::vector<TestAccount> accounts;
+    auto txs = makeTxs(*app, root, accounts);
+
+    CommutativePhaseOutcome outcome;
+    outcome.shards =
+        ParallelCommutativeApply::partition(txs, cfg.COMMUTATIVE_APPLY_SHARDS);
+
+    auto lcl = app->getLedgerManager().getLastClosedLedgerNum();
+    auto resultMeta = closeLedgerOn(*app, lcl + 1, 1, 1, 2020, txs);
+
+    for (auto const& rm : resultMeta)
+    {
+        outcome.results.emplace_back(rm.first);
+    }
+    for (auto const& account : accounts)
+    {
+        outcome.balances.emplace_back(getBalance(account));
+    }
+    outcome.txSetResultHash = app->getLedgerManager()
+                                  .getLastClosedLedgerHeader()
+                                  .header.txSetResultHash;
+    outcome.serialFallbacks =
+        app->getMetrics()
+            .NewMeter({"ledger", "commutative-apply", "serial-fallback"},
+                      "ledger")
+            .count();
+    return outcome;
+}
+
+size_t
+countUsedShards(std::vector<std::vector<size_t>> const& shards)
+{
+    return std::count_if(shards.begin(), shards.end(),
+                         [](auto const& shard) { return !shard.empty(); });
+}
+
+size_t
+shardOf(std::vector<std::vector<size_t>> const& shards, size_t tx)
+{
+    for (size_t s = 0; s < shards.size(); ++s)
+    {
+        if (std::find(shards[s].begin(), shards[s].end(), tx) !=
+            shards[s].end())
+        {
+            return s;
+        }
+    }
+    throw std::runtime_error("tx not in any shard");
+}
+
+int64_t
+nativeBalance(TestAccount const& account)
+{
+    return account.getBalance();
+}
+}
+
+TEST_CASE("parallel commutative apply matches serial apply",
+          "[ledger][commutativity]")
+{
+    uint32_t const numShards = 4;
+
+    Config cfg(getTestConfig());
+    cfg.LEDGER_PROTOCOL_VERSION = 17;
+    cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = 100;
+
+    SECTION("independent payments")
+    {
+        // Accounts pay each other in pairs, so there are several groups of
+        // txs for the shards.
+        size_t const numAccounts = 16;
+        MakeTxs makeTxs = [&](Application& app, TestAccount& root,
+                              std::vector<TestAccount>& accounts) {
+            auto minBalance = app.getLedgerManager().getLastMinBalance(0);
+            auto fee = app.getLedgerManager().getLastTxFee();
+            for (size_t i = 0; i < numAccounts; ++i)
+            {
+                accounts.emplace_back(root.create(
+                    "a" + std::to_string(i), minBalance + 10000 + 10 * fee));
+            }
+
+            std::vector<TransactionFrameBasePtr> txs;
+            for (size_t i = 0; i < numAccounts; i += 2)
+            {
+                auto& a = accounts[i];
+                auto& b = accounts[i + 1];
+                txs.emplace_back(
+                    a.commutativeTx({payment(b, 100 + i), payment(b, 50)}));
+                txs.emplace_back(a.commutativeTx({payment(b, 7)}));
+                txs.emplace_back(b.commutativeTx({payment(a, 30 + i)}));
+            }
+            return txs;
+        };
+
+        cfg.COMMUTATIVE_APPLY_SHARDS = 1;
+        auto serial = closeCommutativeLedger(cfg, makeTxs, nativeBalance);
+
+        cfg.COMMUTATIVE_APPLY_SHARDS = numShards;
+        auto parallel = closeCommutativeLedger(cfg, makeTxs, nativeBalance);
+
+        // The test is only meaningful if the txs span several shards, and
+        // apply did not fall back to serial.
+        REQUIRE(countUsedShards(parallel.shards) == numShards);
+        REQUIRE(parallel.serialFallbacks == 0);
+
+        REQUIRE(serial.results.size() == 3 * numAccounts / 2);
+        for (auto const& res : serial.results)
+        {
+            REQUIRE(res.result.result.code() == txSUCCESS);
+        }
+        REQUIRE(parallel.results == serial.results);
+        REQUIRE(parallel.balances == serial.balances);
+        REQUIRE(parallel.txSetResultHash == serial.txSetResultHash);
+    }
+
+    SECTION("credits to a trustline near its limit")
+    {
+        // Two senders each pay the receiver 100 USD, of which its trustline
+        // only has room for 150: whichever comes second is LINE_FULL. Other
+        // accounts pay each other in pairs, to fill the other shards.
+        size_t const numPairs = 3;
+        Asset usd;
+        MakeTxs makeTxs = [&](Application& app, TestAccount& root,
+                              std::vector<TestAccount>& accounts) {
+            auto minBalance = app.getLedgerManager().getLastMinBalance(2);
+            auto fee = app.getLedgerManager().getLastTxFee();
+            auto issuer = root.create("issuer", minBalance);
+            usd = makeAsset(issuer, "USD");
+
+            auto receiver = root.create("receiver", minBalance + 10 * fee);
+            receiver.changeTrust(usd, 150);
+            accounts.emplace_back(receiver);
+            for (auto const& name : {"sender0", "sender1"})
+            {
+                auto sender = root.create(name, minBalance + 10 * fee);
+                sender.changeTrust(usd, 1000);
+                issuer.pay(sender, usd, 100);
+                accounts.emplace_back(sender);
+            }
+            for (size_t i = 0; i < 2 * numPairs; ++i)
+            {
+                accounts.emplace_back(root.create(
+                    "a" + std::to_string(i), minBalance + 10000 + 10 * fee));
+            }
+
+            std::vector<TransactionFrameBasePtr> txs;
+            txs.emplace_back(
+                accounts[1].commutativeTx({payment(receiver, usd, 100)}));
+            txs.emplace_back(
+                accounts[2].commutativeTx({payment(receiver, usd, 100)}));
+            for (size_t i = 3; i < accounts.size(); i += 2)
+            {
+                txs.emplace_back(
+                    accounts[i].commutativeTx({payment(accounts[i + 1], 10)}));
+            }
+            return txs;
+        };
+        // USD balance where there is a trustline, native balance otherwise
+        GetBalance usdBalance = [&](TestAccount const& account) {
+            return account.hasTrustLine(usd) ? account.getTrustlineBalance(usd)
+                                             : account.getBalance();
+        };
+
+        cfg.COMMUTATIVE_APPLY_SHARDS = 1;
+        auto serial = closeCommutativeLedger(cfg, makeTxs, usdBalance);
+
+        cfg.COMMUTATIVE_APPLY_SHARDS = numShards;
+        auto parallel = closeCommutativeLedger(cfg, makeTxs, usdBalance);
+
+        // Both credits to the receiver are applied, in order, by one shard.
+        REQUIRE(shardOf(parallel.shards, 0) == shardOf(parallel.shards, 1));
+        REQUIRE(countUsedShards(parallel.shards) == numShards);
+        REQUIRE(parallel.serialFallbacks == 0);
+
+        size_t failed = 0;
+        for (auto const& res : serial.results)
+        {
+            if (res.result.result.code() == txFAILED)
+            {
+                ++failed;
+                REQUIRE(res.result.result.results()[0]
+                            .tr()
+                            .paymentResult()
+                            .code() == PAYMENT_LINE_FULL);
+            }
+        }
+        REQUIRE(failed == 1);
+        REQUIRE(serial.balances[0] == 100);
+
+        REQUIRE(parallel.results == serial.results);
+        REQUIRE(parallel.balances == serial.balances);
+        REQUIRE(parallel.txSetResultHash == serial.txSetResultHash);
+    }
+}
@@ -30,7 +30,6 @@
 #include "invariant/LedgerEntryIsValid.h"
 #include "invariant/LiabilitiesMatchOffers.h"
 #include "invariant/SponsorshipCountIsValid.h"
-#include "ledger/InMemoryLedgerTxn.h"
 #include "ledger/InMemoryLedgerTxnRoot.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
@@ -278,6 +277,12 @@ ApplicationImpl::initialize(bool createNewDB, bool forceRebuild)
             mConfig.BEST_OFFER_DEBUGGING_ENABLED
 #endif
         );
+        if (mConfig.EXPERIMENTAL_BUCKET_INDEX_READS &&
+            mConfig.MODE_ENABLES_BUCKETLIST)
+        {
+            mLedgerTxnRoot->setBucketListForReads(
+                &mBucketManager->getBucketList());
+        }
     }
 
     BucketListIsConsistentWithDatabase::registerInvariant(*this);
@@ -313,14 +318,13 @@ ApplicationImpl::resetLedgerState()
 {
     if (getConfig().MODE_USES_IN_MEMORY_LEDGER)
     {
-        mNeverCommittingLedgerTxn.reset();
         mInMemoryLedgerTxnRoot = std::make_unique<InMemoryLedgerTxnRoot>(
+            getDatabase()
 #ifdef BEST_OFFER_DEBUGGING
+                ,
             mConfig.BEST_OFFER_DEBUGGING_ENABLED
 #endif
         );
-        mNeverCommittingLedgerTxn = std::make_unique<InMemoryLedgerTxn>(
-            *mInMemoryLedgerTxnRoot, getDatabase());
     }
     else
     {
@@ -1342,7 +1346,7 @@ AbstractLedgerTxnParent&
 ApplicationImpl::getLedgerTxnRoot()
 {
     assertThreadIsMain();
-    return mConfig.MODE_USES_IN_MEMORY_LEDGER ? *mNeverCommittingLedgerTxn
+    return mConfig.MODE_USES_IN_MEMORY_LEDGER ? *mInMemoryLedgerTxnRoot
                                               : *mLedgerTxnRoot;
 }
 }
@@ -33,7 +33,6 @@ class CommandHandler;
 class Database;
 class LedgerTxn;
 class LedgerTxnRoot;
-class InMemoryLedgerTxn;
 class InMemoryLedgerTxnRoot;
 class LoadGenerator;
 
@@ -169,19 +168,13 @@ class ApplicationImpl : public Application
     std::unique_ptr<StatusManager> mStatusManager;
     std::unique_ptr<AbstractLedgerTxnParent> mLedgerTxnRoot;
 
-    // These two exist for use in MODE_USES_IN_MEMORY_LEDGER only: the
-    // mInMemoryLedgerTxnRoot is a _stub_ AbstractLedgerTxnParent that refuses
-    // all commits and answers null to all queries; then an inner
-    // "never-committing" sub-LedgerTxn is constructed beneath it that serves as
-    // the "effective" in-memory root transaction, is returned when a client
-    // requests the root.
+    // Used in place of mLedgerTxnRoot in MODE_USES_IN_MEMORY_LEDGER, holding
+    // the whole ledger state in memory.
     //
-    // Note that using this only works when the ledger can fit in RAM -- as it
-    // is held in the never-committing LedgerTxn in its entirety -- so if it
+    // Note that using this only works when the ledger can fit in RAM, so if it
     // ever grows beyond RAM-size you need to use a mode with some sort of
     // database on secondary storage.
     std::unique_ptr<InMemoryLedgerTxnRoot> mInMemoryLedgerTxnRoot;
-    std::unique_ptr<InMemoryLedgerTxn> mNeverCommittingLedgerTxn;
 
     std::unique_ptr<CommandHandler> mCommandHandler;
 
@@ -26,7 +26,10 @@
 #include "util/types.h"
 #include "work/WorkScheduler.h"
 
+#include "speedex/sim_utils.h"
+#include "speedex/speedex.h"
 #include "xdr/speedex-sim.h"
+#include <lib/json/json.h>
 #include <xdrpp/marshal.h>
 
 #ifdef BUILD_TESTS
@@ -36,6 +39,7 @@
 #endif
 
 #include <fmt/format.h>
+#include <fstream>
 #include <iostream>
 #include <lib/clara.hpp>
 #include <optional>
@@ -1601,38 +1605,118 @@ runGenFuzz(CommandLineArgs const& args)
 #endif
 
 int
-runSpeedexSim(CommandLineArgs const& args) {
+runSpeedexSim(CommandLineArgs const& args)
+{
     std::string fileName;
 
-    return runWithHelp(
-        args,
-        {fileNameParser(fileName)},
-        [&] {
+    return runWithHelp(args, {fileNameParser(fileName)}, [&] {
+        auto sim = loadSpeedexSimulation(fileName);
+        auto results = runSpeedexSim(sim);
 
-            std::printf("loading from %s\n", fileName.c_str());
+        std::printf("PRICES\n");
+        for (auto const& valuation : results.valuations)
+        {
+            std::printf("%s %llu\n", assetToString(valuation.asset).c_str(),
+                        (unsigned long long)valuation.price);
+        }
+        std::printf("cleared %zu offers, %zu pools\n",
+                    results.offerStatuses.size(), results.lpStatuses.size());
+        return 0;
+    });
+}
 
-            SpeedexSimulation sim;
+int
+runBenchSpeedex(CommandLineArgs const& args)
+{
+    std::string loadFile;
+    std::string saveFile;
+    std::string outputFile;
+    uint32_t numAssets = 20;
+    uint32_t numOffers = 100000;
+    uint32_t numAMMs = 20;
+    uint64_t seed = 0;
+    uint32_t iterations = 5;
+
+    auto loadParser = clara::Opt{loadFile, "FILE-NAME"}["--load"](
+        "read the workload from an XDR SpeedexSimulation file, instead of "
+        "generating one");
+    auto saveParser = clara::Opt{saveFile, "FILE-NAME"}["--save"](
+        "write the workload to an XDR SpeedexSimulation file");
+    auto assetsParser = clara::Opt{numAssets, "N"}["--assets"](
+        "number of assets in a generated workload");
+    auto offersParser = clara::Opt{numOffers, "N"}["--offers"](
+        "number of offers in a generated workload");
+    auto ammsParser = clara::Opt{numAMMs, "N"}["--amms"](
+        "number of liquidity pools in a generated workload");
+    auto seedParser = clara::Opt{seed, "SEED"}["--seed"](
+        "random seed for a generated workload");
+    auto iterationsParser = clara::Opt{iterations, "N"}["--iterations"](
+        "number of batches to run");
 
-            using namespace std;
+    return runWithHelp(
+        args,
+        {loadParser, saveParser, assetsParser, offersParser, ammsParser,
+         seedParser, iterationsParser, outputFileParser(outputFile)},
+        [&] {
+            auto sim = loadFile.empty()
+                           ? generateSpeedexSimulation(numAssets, numOffers,
+                                                       numAMMs, seed)
+                           : loadSpeedexSimulation(loadFile);
+            if (!saveFile.empty())
             {
-                ostringstream input;
-                ifstream file(fileName.c_str());
-                if (!file)
-                {
-                    throw std::runtime_error(std::string("nonexistent file ") + fileName);
-                }
-                file.exceptions(std::ios::badbit);
-                input << file.rdbuf();
-
-                auto str = input.str();
-
-                xdr::opaque_vec<> v{str.begin(), str.end()};
+                saveSpeedexSimulation(sim, saveFile);
+            }
 
-                xdr::xdr_from_opaque(v, sim);
+            Json::Value out;
+            out["workload"]["assets"] =
+                static_cast<Json::UInt64>(sim.config.assets.size());
+            out["workload"]["offers"] =
+                static_cast<Json::UInt64>(sim.offers.size());
+            out["workload"]["amms"] =
+                static_cast<Json::UInt64>(sim.config.ammConfigs.size());
+            if (loadFile.empty())
+            {
+                out["workload"]["seed"] = static_cast<Json::UInt64>(seed);
+            }
+            else
+            {
+                out["workload"]["file"] = loadFile;
             }
+            out["version"] = STELLAR_CORE_VERSION;
 
-            std::printf("read file");
+            auto& runs = out["runs"];
+            runs = Json::Value(Json::arrayValue);
+            for (uint32_t i = 0; i < iterations; i++)
+            {
+                SpeedexPhaseTimings timings;
+                auto results = runSpeedexSim(sim, &timings);
+
+                Json::Value run;
+                run["seal_batch_ns"] =
+                    static_cast<Json::Int64>(timings.mSealBatch.count());
+                run["tatonnement_ns"] =
+                    static_cast<Json::Int64>(timings.mTatonnement.count());
+                run["solver_ns"] =
+                    static_cast<Json::Int64>(timings.mSolver.count());
+                run["clearing_ns"] =
+                    static_cast<Json::Int64>(timings.mClearing.count());
+                run["offers_cleared"] =
+                    static_cast<Json::UInt64>(results.offerStatuses.size());
+                runs.append(run);
+            }
 
+            auto content = out.toStyledString();
+            if (outputFile.empty())
+            {
+                std::cout << content;
+            }
+            else
+            {
+                std::ofstream file;
+                file.exceptions(std::ios::failbit | std::ios::badbit);
+                file.open(outputFile);
+                file << content;
+            }
             return 0;
         });
 }
@@ -1680,9 +1764,11 @@ handleCommandLine(int argc, char* const* argv)
          {"sign-transaction",
           "add signature to transaction envelope, then quit",
           runSignTransaction},
-         {"speedex",
-          "speedex simulation",
-           runSpeedexSim},
+         {"speedex", "run one speedex batch from a SpeedexSimulation file",
+          runSpeedexSim},
+         {"bench-speedex",
+          "time each phase of speedex batches, and report them as JSON",
+          runBenchSpeedex},
          {"upgrade-db", "upgrade database schema to current version",
           runUpgradeDB},
 #ifdef BUILD_TESTS
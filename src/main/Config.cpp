@@ -130,6 +130,11 @@ Config::Config() : NODE_SEED(SecretKey::random())
     CATCHUP_COMPLETE = false;
     CATCHUP_RECENT = 0;
     EXPERIMENTAL_PRECAUTION_DELAY_META = false;
+    EXPERIMENTAL_ASYNC_META_WRITES = false;
+    EXPERIMENTAL_BUCKET_INDEX_READS = false;
+    BUCKET_MERGE_RANGES = 1;
+    COMMUTATIVE_APPLY_SHARDS = 1;
+    TX_SET_VALIDATION_SHARDS = 1;
     // automatic maintenance settings:
     // 11 minutes is relatively short and prime with 1 hour
     // which will cause automatic maintenance to rarely conflict with any other
@@ -868,6 +873,26 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 EXPERIMENTAL_PRECAUTION_DELAY_META = readBool(item);
             }
+            else if (item.first == "EXPERIMENTAL_ASYNC_META_WRITES")
+            {
+                EXPERIMENTAL_ASYNC_META_WRITES = readBool(item);
+            }
+            else if (item.first == "EXPERIMENTAL_BUCKET_INDEX_READS")
+            {
+                EXPERIMENTAL_BUCKET_INDEX_READS = readBool(item);
+            }
+            else if (item.first == "BUCKET_MERGE_RANGES")
+            {
+                BUCKET_MERGE_RANGES = readInt<uint32_t>(item, 1, 64);
+            }
+            else if (item.first == "COMMUTATIVE_APPLY_SHARDS")
+            {
+                COMMUTATIVE_APPLY_SHARDS = readInt<uint32_t>(item, 1, 64);
+            }
+            else if (item.first == "TX_SET_VALIDATION_SHARDS")
+            {
+                TX_SET_VALIDATION_SHARDS = readInt<uint32_t>(item, 0, 64);
+            }
             else if (item.first == "METADATA_DEBUG_LEDGERS")
             {
                 METADATA_DEBUG_LEDGERS = readInt<uint32_t>(item);
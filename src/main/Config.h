@@ -231,6 +231,35 @@ class Config : public std::enable_shared_from_this<Config>
     // configuration) to delay emitting metadata by one ledger.
     bool EXPERIMENTAL_PRECAUTION_DELAY_META;
 
+    // A config parameter that writes ledger close meta on a separate thread.
+    // Meta emitted while closing a ledger is always written before that
+    // ledger commits; with EXPERIMENTAL_PRECAUTION_DELAY_META, each ledger's
+    // meta is written while the next one is applied. The last ledger whose
+    // meta was written is stored in the database.
+    bool EXPERIMENTAL_ASYNC_META_WRITES;
+
+    // A config parameter that indexes bucket files as they are adopted, and
+    // serves LedgerTxnRoot point loads from the BucketList instead of SQL
+    // whenever every bucket is indexed. SQL is still written, and still
+    // serves offer queries and bulk scans.
+    bool EXPERIMENTAL_BUCKET_INDEX_READS;
+
+    // Number of key ranges that large bucket merges are split into and merged
+    // in parallel. 1 (the default) merges serially. The merged buckets are
+    // the same either way.
+    uint32_t BUCKET_MERGE_RANGES;
+
+    // Number of shards that the commutative transactions of a ledger are
+    // split into, by the accounts they touch, and applied in parallel. 1 (the
+    // default) applies them serially. Results, meta and ledger state are the
+    // same either way.
+    uint32_t COMMUTATIVE_APPLY_SHARDS;
+
+    // Number of shards the per-account transaction queues of a tx set are
+    // split into and validated in parallel. 1 (the default) validates them
+    // serially, 0 picks one shard per hardware thread.
+    uint32_t TX_SET_VALIDATION_SHARDS;
+
     // A config parameter that stores historical data, such as transactions,
     // fees, and scp history in the database
     bool MODE_STORES_HISTORY_MISC;
@@ -0,0 +1,283 @@
+#include "simplex/circulation.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace stellar {
+
+MaxCirculationSolver::MaxCirculationSolver(std::vector<Asset> assets)
+	: MaxCirculationSolver(AssetIndex(assets))
+{}
+
+MaxCirculationSolver::MaxCirculationSolver(AssetIndex const& assetIndex)
+	: mNumAssets(assetIndex.size())
+	, mAssetIndex(assetIndex)
+	, mEdges()
+	, mEdgeByPair(mNumAssets * mNumAssets, -1)
+	, mSolved(false)
+{}
+
+void
+MaxCirculationSolver::throwIfSolved() const
+{
+	if (mSolved) {
+		throw std::logic_error("already solved");
+	}
+}
+
+void
+MaxCirculationSolver::throwIfUnsolved() const
+{
+	if (!mSolved)
+	{
+		throw std::logic_error("not yet solved");
+	}
+}
+
+void
+MaxCirculationSolver::setUpperBound(AssetPair const& assetPair, int128_t upperBound)
+{
+	throwIfSolved();
+
+	auto sellIdx = mAssetIndex.getIndex(assetPair.selling);
+	auto buyIdx = mAssetIndex.getIndex(assetPair.buying);
+
+	if (sellIdx == buyIdx) {
+		throw std::runtime_error("can't trade an asset for itself");
+	}
+
+	auto& edgeIdx = mEdgeByPair[sellIdx * mNumAssets + buyIdx];
+	if (edgeIdx >= 0) {
+		throw std::runtime_error("can't double-set upper bound");
+	}
+
+	if (upperBound <= 0) {
+		throw std::runtime_error("can't have nonpositive upper bound");
+	}
+
+	edgeIdx = mEdges.size();
+	mEdges.push_back(Edge{
+		.mSellIdx = sellIdx,
+		.mBuyIdx = buyIdx,
+		.mCapacity = upperBound,
+		.mFlow = 0
+	});
+}
+
+MaxCirculationSolver::int128_t
+MaxCirculationSolver::residualCapacity(ResidualArc const& arc) const
+{
+	auto const& edge = mEdges[arc.mEdgeIdx];
+	return arc.mForward ? edge.mCapacity - edge.mFlow : edge.mFlow;
+}
+
+void
+MaxCirculationSolver::buildResidualArcs(std::vector<ResidualArc>& out) const
+{
+	out.clear();
+	for (uint32_t i = 0; i < mEdges.size(); i++) {
+		auto const& edge = mEdges[i];
+		if (edge.mFlow < edge.mCapacity) {
+			out.push_back(ResidualArc{
+				.mFrom = edge.mSellIdx,
+				.mTo = edge.mBuyIdx,
+				.mEdgeIdx = i,
+				.mForward = true
+			});
+		}
+		if (edge.mFlow > 0) {
+			out.push_back(ResidualArc{
+				.mFrom = edge.mBuyIdx,
+				.mTo = edge.mSellIdx,
+				.mEdgeIdx = i,
+				.mForward = false
+			});
+		}
+	}
+}
+
+std::optional<std::vector<uint32_t>>
+MaxCirculationSolver::findMinMeanCycle(std::vector<ResidualArc> const& arcs) const
+{
+	// Karp's algorithm.  dist[k * n + v] is the minimum cost of a walk of
+	// exactly k arcs ending at v (starting anywhere).
+	const size_t n = mNumAssets;
+	constexpr int64_t INF = std::numeric_limits<int64_t>::max();
+
+	std::vector<int64_t> dist((n + 1) * n, INF);
+	std::vector<int32_t> parentArc((n + 1) * n, -1);
+
+	for (size_t v = 0; v < n; v++) {
+		dist[v] = 0;
+	}
+
+	for (size_t k = 1; k <= n; k++) {
+		for (uint32_t a = 0; a < arcs.size(); a++) {
+			auto const& arc = arcs[a];
+			auto prev = dist[(k-1) * n + arc.mFrom];
+			if (prev == INF) {
+				continue;
+			}
+			int64_t cand = prev + (arc.mForward ? -1 : 1);
+			if (cand < dist[k * n + arc.mTo]) {
+				dist[k * n + arc.mTo] = cand;
+				parentArc[k * n + arc.mTo] = a;
+			}
+		}
+	}
+
+	// mu* = min_v max_k (dist[n][v] - dist[k][v]) / (n - k), as num / den with den > 0
+	std::optional<size_t> bestV;
+	int64_t bestNum = 0, bestDen = 1;
+
+	for (size_t v = 0; v < n; v++) {
+		if (dist[n * n + v] == INF) {
+			continue;
+		}
+		std::optional<std::pair<int64_t, int64_t>> worst;
+		for (size_t k = 0; k < n; k++) {
+			if (dist[k * n + v] == INF) {
+				continue;
+			}
+			int64_t num = dist[n * n + v] - dist[k * n + v];
+			int64_t den = n - k;
+			if (!worst || num * worst->second > worst->first * den) {
+				worst = {num, den};
+			}
+		}
+		if (worst && (!bestV || worst->first * bestDen < bestNum * worst->second)) {
+			bestV = v;
+			bestNum = worst->first;
+			bestDen = worst->second;
+		}
+	}
+
+	if (!bestV || bestNum >= 0) {
+		return std::nullopt;
+	}
+
+	// Walk back along the parent arcs from level n, until some vertex repeats.
+	// The walk visits n+1 vertices, so this happens before level 0 is left.
+	// Any cycle on this walk has mean cost mu*.
+	std::vector<int32_t> levelSeen(n, -1);
+	size_t v = *bestV;
+	size_t k = n;
+	while (levelSeen[v] < 0) {
+		levelSeen[v] = k;
+		v = arcs[parentArc[k * n + v]].mFrom;
+		k--;
+	}
+
+	// v is the vertex at both level k and level top.
+	size_t top = levelSeen[v];
+	std::vector<uint32_t> cycle(top - k);
+	size_t cur = v;
+	for (size_t j = top; j > k; j--) {
+		auto a = parentArc[j * n + cur];
+		cycle[j - k - 1] = a;
+		cur = arcs[a].mFrom;
+	}
+	return cycle;
+}
+
+void
+MaxCirculationSolver::cancelCycle(std::vector<ResidualArc> const& arcs, std::vector<uint32_t> const& cycle)
+{
+	int128_t bottleneck = residualCapacity(arcs[cycle.front()]);
+	int64_t cost = 0;
+	for (auto a : cycle) {
+		bottleneck = std::min(bottleneck, residualCapacity(arcs[a]));
+		cost += arcs[a].mForward ? -1 : 1;
+	}
+	if (cost >= 0 || bottleneck <= 0) {
+		throw std::logic_error("invalid cycle to cancel");
+	}
+	for (auto a : cycle) {
+		auto& edge = mEdges[arcs[a].mEdgeIdx];
+		if (arcs[a].mForward) {
+			edge.mFlow += bottleneck;
+		} else {
+			edge.mFlow -= bottleneck;
+		}
+	}
+}
+
+void
+MaxCirculationSolver::saturateTwoCycles()
+{
+	for (auto& edge : mEdges) {
+		if (edge.mSellIdx > edge.mBuyIdx) {
+			continue;
+		}
+		auto reverseIdx = mEdgeByPair[edge.mBuyIdx * mNumAssets + edge.mSellIdx];
+		if (reverseIdx < 0) {
+			continue;
+		}
+		auto& reverse = mEdges[reverseIdx];
+		auto amount = std::min(edge.mCapacity, reverse.mCapacity);
+		edge.mFlow = amount;
+		reverse.mFlow = amount;
+	}
+}
+
+void
+MaxCirculationSolver::doSolve()
+{
+	throwIfSolved();
+
+	// edge order determines tie-breaking, so fix it independently of the
+	// order in which upper bounds were set.
+	std::sort(mEdges.begin(), mEdges.end(), [] (Edge const& a, Edge const& b) {
+		return std::make_pair(a.mSellIdx, a.mBuyIdx) < std::make_pair(b.mSellIdx, b.mBuyIdx);
+	});
+	for (uint32_t i = 0; i < mEdges.size(); i++) {
+		mEdgeByPair[mEdges[i].mSellIdx * mNumAssets + mEdges[i].mBuyIdx] = i;
+	}
+
+	saturateTwoCycles();
+
+	std::vector<ResidualArc> arcs;
+	while (true) {
+		buildResidualArcs(arcs);
+		auto cycle = findMinMeanCycle(arcs);
+		if (!cycle) {
+			break;
+		}
+		cancelCycle(arcs, *cycle);
+	}
+
+	mSolved = true;
+}
+
+MaxCirculationSolver::int128_t
+MaxCirculationSolver::getRowResult(AssetPair const& assetPair) const
+{
+	throwIfUnsolved();
+	auto sellIdx = mAssetIndex.getIndex(assetPair.selling);
+	auto buyIdx = mAssetIndex.getIndex(assetPair.buying);
+	auto edgeIdx = mEdgeByPair[sellIdx * mNumAssets + buyIdx];
+	if (edgeIdx < 0) {
+		return 0;
+	}
+	return mEdges[edgeIdx].mFlow;
+}
+
+UnorderedMap<AssetPair, MaxCirculationSolver::int128_t, AssetPairHash>
+MaxCirculationSolver::getSolution() const
+{
+	throwIfUnsolved();
+	UnorderedMap<AssetPair, int128_t, AssetPairHash> out;
+	for (auto const& edge : mEdges) {
+		if (edge.mFlow > 0) {
+			AssetPair tradingPair {
+				.selling = mAssetIndex.getAsset(edge.mSellIdx),
+				.buying = mAssetIndex.getAsset(edge.mBuyIdx)
+			};
+			out[tradingPair] = edge.mFlow;
+		}
+	}
+	return out;
+}
+
+} /* stellar */
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "simplex/trade_maximizer.h"
+
+#include "speedex/PriceVector.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace stellar {
+
+/*
+ Trade maximization as a network flow problem.
+
+ Assets are nodes, and each asset pair with an upper bound is an edge with
+ that capacity.  Asset conservation makes a feasible set of trades exactly
+ a circulation, so maximizing trade volume is a min-cost circulation
+ where every edge costs -1.
+
+ Solved by minimum-mean cycle cancelling (Goldberg & Tarjan), with
+ minimum-mean cycles found by Karp's algorithm.  This is strongly
+ polynomial, and all arithmetic is exact (int128 flows, integer costs).
+ Ties are broken by edge order, which follows the AssetIndex, so the
+ result is deterministic.
+*/
+class MaxCirculationSolver : public AbstractTradeMaximizingSolver {
+
+	struct Edge {
+		uint32_t mSellIdx;
+		uint32_t mBuyIdx;
+		int128_t mCapacity;
+		int128_t mFlow;
+	};
+
+	// A residual arc either pushes more flow along edge mEdgeIdx (cost -1),
+	// or pushes flow back (cost +1).
+	struct ResidualArc {
+		uint32_t mFrom;
+		uint32_t mTo;
+		uint32_t mEdgeIdx;
+		bool mForward;
+	};
+
+	const size_t mNumAssets;
+
+	AssetIndex mAssetIndex;
+
+	std::vector<Edge> mEdges;
+
+	// mEdgeByPair[sell * mNumAssets + buy], or -1 if no upper bound
+	std::vector<int32_t> mEdgeByPair;
+
+	bool mSolved;
+
+	void throwIfSolved() const;
+	void throwIfUnsolved() const;
+
+	void buildResidualArcs(std::vector<ResidualArc>& out) const;
+
+	// returns a cycle (as indices into arcs) of negative mean cost, if one exists
+	std::optional<std::vector<uint32_t>>
+	findMinMeanCycle(std::vector<ResidualArc> const& arcs) const;
+
+	int128_t residualCapacity(ResidualArc const& arc) const;
+
+	void cancelCycle(std::vector<ResidualArc> const& arcs, std::vector<uint32_t> const& cycle);
+
+	// a feasible starting circulation
+	void saturateTwoCycles();
+
+public:
+
+	MaxCirculationSolver(AssetIndex const& assetIndex);
+	MaxCirculationSolver(std::vector<Asset> assets);
+
+	MaxCirculationSolver(const MaxCirculationSolver&) = delete;
+	MaxCirculationSolver& operator=(const MaxCirculationSolver&) = delete;
+
+	void setUpperBound(AssetPair const& assetPair, int128_t upperBound) override;
+
+	void doSolve() override;
+
+	int128_t getRowResult(AssetPair const& assetPair) const override;
+
+	UnorderedMap<AssetPair, int128_t, AssetPairHash> getSolution() const override;
+};
+
+} /* stellar */
@@ -58,23 +58,14 @@ TradeMaximizingSolver::varIndexToIndexPair(size_t yijIdx) const {
 
 void
 TradeMaximizingSolver::printRow(size_t rowIdx) const {
-	for (size_t i = 0; i < numVars(); i++) {
-		auto var = mCoefficients[rowIdx].first[i];
-		if (var < 0) {
-			std::printf("-%d ", -var);
-		} else {
-			std::printf(" %d ", var);
-		}
-	}
-	double coeff = (double) mCoefficients[rowIdx].second;
-	std::printf("%lf\n", coeff);
+	mTableau->printRow(rowIdx);
 }
 
 void
 TradeMaximizingSolver::printTableau() const
 {
 	if (!debugPrints) return;
-	for (size_t i = 0; i < mCoefficients.size(); i++) {
+	for (size_t i = 0; i < mTableau->numRows(); i++) {
 		printRow(i);
 	}
 }
@@ -82,8 +73,8 @@ TradeMaximizingSolver::printTableau() const
 
 size_t 
 TradeMaximizingSolver::assetPairToVarIndex(AssetPair assetPair) const {
-	auto sellIdx = mIndexMap.at(assetPair.selling);
-	auto buyIdx = mIndexMap.at(assetPair.buying);
+	auto sellIdx = mAssetIndex.getIndex(assetPair.selling);
+	auto buyIdx = mAssetIndex.getIndex(assetPair.buying);
 	return indexPairToVarIndex(sellIdx, buyIdx);
 }
 
@@ -104,32 +95,29 @@ TradeMaximizingSolver::throwIfUnsolved() const
 	}
 }
 
-TradeMaximizingSolver::TradeMaximizingSolver(std::vector<Asset> assets) 
-	: mSolved(false) 
+TradeMaximizingSolver::TradeMaximizingSolver(std::vector<Asset> assets, SimplexTableauType tableauType) 
+	: TradeMaximizingSolver(AssetIndex(assets), tableauType)
+{}
+
+TradeMaximizingSolver::TradeMaximizingSolver(AssetIndex const& assetIndex, SimplexTableauType tableauType) 
+	: mNumAssets(assetIndex.size())
+	, mAssetIndex(assetIndex)
+	, mSolved(false) 
 {
-	size_t idx = 0;
-	for (auto asset : assets) {
-		mIndexMap[asset] = idx;
-	//	mReverseIndexMap[idx] = asset;
-		idx++;
-	}
-	mNumAssets = idx;
-	auto nVars = numVars();
-	size_t numRows = mNumAssets + 1; // last one is objective
-	mCoefficients.resize(numRows);
-	for (auto& row : mCoefficients) {
-		row.first.resize(nVars);
+	mTableau = makeSimplexTableau(tableauType, numVars());
+	size_t numRows = mNumAssets + 1; // first one is objective
+	for (size_t i = 0; i < numRows; i++) {
+		mTableau->addRow();
 	}
 
 	for (size_t i = 0; i < mNumAssets; i++) {
 		row_idx_t row_idx = i + 1;
-		auto& constraintRow = mCoefficients[row_idx];
 		for (size_t j = 0; j < mNumAssets; j++) {
 			if (i != j) {
 				auto yijIdx = indexPairToVarIndex(i, j);
 				auto yjiIdx = indexPairToVarIndex(j, i);
-				constraintRow.first[yijIdx] = 1;
-				constraintRow.first[yjiIdx] = -1;
+				mTableau->set(row_idx, yijIdx, 1);
+				mTableau->set(row_idx, yjiIdx, -1);
 			}
 		}
 		// Sum_{j} y_ij - Sum_{j} y_ji >= 0
@@ -137,7 +125,7 @@ TradeMaximizingSolver::TradeMaximizingSolver(std::vector<Asset> assets)
 		// amount of i sold to market >= amount of i bought from market.
 		// amount of i sold to market  - slack var = amount of i bought from market
 		size_t slackVarIdx = numYijEijVars() + i;
-		constraintRow.first[slackVarIdx] = 1;
+		mTableau->set(row_idx, slackVarIdx, 1);
 		mActiveBasis[row_idx] = slackVarIdx;
 	}
 
@@ -171,22 +159,18 @@ TradeMaximizingSolver::setUpperBound(AssetPair const& assetPair, int128_t upperB
 		throw std::runtime_error("can't have nonpositive upper bound");
 	}
 
-	auto rowIdx = mCoefficients.size();
-	mCoefficients.emplace_back();
+	auto rowIdx = mTableau->addRow();
 
 	mAssetPairToRowMap[assetPair] = rowIdx;
 
-	auto& row = mCoefficients.back();
-	row.first.resize(numVars());
-	row.first[yIdx] = 1;
-	row.first[eIdx] = 1;
-	row.second = upperBound;
+	mTableau->set(rowIdx, yIdx, 1);
+	mTableau->set(rowIdx, eIdx, 1);
+	mTableau->setRHS(rowIdx, upperBound);
 
 	mActiveBasis[rowIdx] = eIdx;
 	mActiveYijs[yIdx] = true;
 
-	auto& objectiveRow = mCoefficients.front();
-	objectiveRow.first[yIdx] = 1;
+	mTableau->set(0, yIdx, 1);
 
 	if (debugPrints)
 		std::printf("post add tableau:\n");
@@ -195,31 +179,30 @@ TradeMaximizingSolver::setUpperBound(AssetPair const& assetPair, int128_t upperB
 
 std::optional<size_t>
 TradeMaximizingSolver::getNextPivotIndex() const {
-	auto& objRow = mCoefficients.front();
-	for (size_t i = 0; i < objRow.first.size(); i++) {
-		//TODO mActiveYijs[i] is potentially an out of bounds access
-		if (objRow.first[i] > 0 && mActiveYijs[i]) {
-			return i;
-		}
-	}
-	return std::nullopt;
+	// only yij columns (the first numYijVars()) with an upper bound can enter
+	return mTableau->getFirstPositiveColumn(0, mActiveYijs);
 }
 
 size_t
-TradeMaximizingSolver::getNextPivotConstraint(size_t pivotColumn) const {
+TradeMaximizingSolver::getNextPivotConstraint(size_t pivotColumn) {
 	size_t minIdx = 0;
 	bool foundValue = false;
 	int128_t minValue = 0;
-	for (size_t i = 1; i < mCoefficients.size(); i++) {
+	mTableau->getNonzeroRows(pivotColumn, mPivotRows);
+	for (auto i : mPivotRows) {
+		if (i == 0) {
+			continue;
+		}
 		if (debugPrints)
 			std::printf("next pivot check %lu\n", i);
-		if (mCoefficients[i].first[pivotColumn] > 0) {
+		if (mTableau->get(i, pivotColumn) > 0) {
 			if (debugPrints)
 				std::printf("coeff is positive foundValue = %lu minValue = %lf\n", foundValue, (double) minValue);
-			if ((!foundValue) || minValue > mCoefficients[i].second) {
+			auto rhs = mTableau->getRHS(i);
+			if ((!foundValue) || minValue > rhs) {
 				foundValue = true;
 				minIdx = i;
-				minValue = mCoefficients[i].second;
+				minValue = rhs;
 			}
 		}
 	}
@@ -240,7 +223,7 @@ TradeMaximizingSolver::doPivot() {
 	}
 	auto nextPivotConstraint = getNextPivotConstraint(*nextPivotIdx);
 
-	auto coeff = mCoefficients[nextPivotConstraint].first[*nextPivotIdx];
+	auto coeff = mTableau->get(nextPivotConstraint, *nextPivotIdx);
 	if (!(coeff == 1 || coeff == -1)) {
 		throw std::runtime_error("matrix should be totally unimodular!");
 	}
@@ -248,14 +231,16 @@ TradeMaximizingSolver::doPivot() {
 	if (debugPrints)
 		std::printf("pivot col %lu pivot row %lu coeff %d\n", *nextPivotIdx, nextPivotConstraint, coeff);
 	//TODO is this correct?  Or should multiplyRow go after the for loop?
-	multiplyRow(nextPivotConstraint, coeff);
+	mTableau->multiplyRow(nextPivotConstraint, coeff);
 	if (debugPrints)
 		std::printf("post mult\n");
 	printTableau();
-	for (size_t i = 0; i < mCoefficients.size(); i++) {
+	// rows with a zero in the pivot column are unaffected
+	mTableau->getNonzeroRows(*nextPivotIdx, mPivotRows);
+	for (auto i : mPivotRows) {
 		if (i != nextPivotConstraint) {
-			auto rowCoeff = -coeff * mCoefficients[i].first[*nextPivotIdx];
-			addRowToRow(nextPivotConstraint, i, rowCoeff);
+			auto rowCoeff = -coeff * mTableau->get(i, *nextPivotIdx);
+			mTableau->addRowToRow(nextPivotConstraint, i, rowCoeff);
 		}
 	}
 
@@ -265,40 +250,10 @@ TradeMaximizingSolver::doPivot() {
 	return true;
 }
 
-void
-TradeMaximizingSolver::addRowToRow(size_t rowToAddIdx, size_t rowToBeAddedToIdx, int8_t coefficient) {
-	auto& rowToAdd = mCoefficients[rowToAddIdx];
-	auto& rowToBeAddedTo = mCoefficients[rowToBeAddedToIdx];
-	const auto sz = rowToAdd.first.size();
-
-	auto* rowToBeAddedToPtr = rowToBeAddedTo.first.data();
-	auto* rowToAddPtr = rowToAdd.first.data();
-
-	for (size_t i = 0; i < sz; i++) {
-		rowToBeAddedToPtr[i] += rowToAddPtr[i] * coefficient;
-	}
-	rowToBeAddedTo.second += rowToAdd.second * coefficient;
-}
-
-void
-TradeMaximizingSolver::multiplyRow(size_t rowIdx, int8_t coefficient) {
-	if (coefficient == 1) return;
-	auto& row = mCoefficients[rowIdx];
-
-	const auto sz = row.first.size();
-
-	auto* rowPtr = row.first.data();
-
-	for (size_t i = 0; i < sz; i++) {
-		rowPtr[i] *= coefficient;
-	}
-	row.second *= coefficient;
-}
-
 TradeMaximizingSolver::int128_t 
 TradeMaximizingSolver::getRowResult(AssetPair const& assetPair) const {
 	throwIfUnsolved();
-	auto pair = std::make_pair(mIndexMap.at(assetPair.selling), mIndexMap.at(assetPair.buying));
+	auto pair = std::make_pair<size_t, size_t>(mAssetIndex.getIndex(assetPair.selling), mAssetIndex.getIndex(assetPair.buying));
 	if (debugPrints)
 		std::printf("query for pair %lu %lu\n", pair.first, pair.second);
 	return mSolutionMap.at(pair);
@@ -317,7 +272,7 @@ TradeMaximizingSolver::constructSolution()
 		auto assetIdxs = varIndexToIndexPair(col_idx);
 		if (assetIdxs) {
 			solvedYijs[col_idx] = true;
-			mSolutionMap[*assetIdxs] = mCoefficients[row_idx].second;
+			mSolutionMap[*assetIdxs] = mTableau->getRHS(row_idx);
 		}
 	}
 
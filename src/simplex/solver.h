@@ -5,9 +5,15 @@
 #include "util/XDROperators.h"
 #include "ledger/AssetPair.h"
 
+#include "speedex/PriceVector.h"
+
+#include "simplex/tableau.h"
+#include "simplex/trade_maximizer.h"
+
 #include "ledger/LedgerHashUtils.h"
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 
@@ -15,20 +21,21 @@
 namespace stellar {
 
 
-class TradeMaximizingSolver {
+// Solves the trade maximization LP with the simplex method.
+class TradeMaximizingSolver : public AbstractTradeMaximizingSolver {
 
 	size_t mNumAssets;
 
-	using int128_t = __int128_t;
-	using Row = std::pair<std::vector<int8_t>, int128_t>;
+	// row 0 is the objective
+	std::unique_ptr<SimplexTableau> mTableau;
 
-	std::vector<Row> mCoefficients;
+	// scratch space for doPivot()
+	std::vector<size_t> mPivotRows;
 
 	using row_idx_t = size_t;
 	using col_idx_t = size_t;
 
-	UnorderedMap<Asset, size_t> mIndexMap; // asset to number
-	//UnorderedMap<size_t, Asset> mReverseIndexMap;  // number to asset
+	AssetIndex mAssetIndex; // same numbering as the rest of the speedex batch
 
 	UnorderedMap<AssetPair, row_idx_t, AssetPairHash> mAssetPairToRowMap;
 
@@ -60,16 +67,10 @@ class TradeMaximizingSolver {
 	getNextPivotIndex() const;
 
 	size_t
-	getNextPivotConstraint(size_t pivotColumn) const;
+	getNextPivotConstraint(size_t pivotColumn);
 
 	bool doPivot();
 
-	void
-	addRowToRow(size_t rowToAddIdx, size_t rowToBeAddedToIdx, int8_t coefficient);
-	
-	void
-	multiplyRow(size_t rowIdx, int8_t coefficient);
-
 	bool isBasisCol(size_t colIdx) const;
 
 	void constructSolution();
@@ -79,18 +80,20 @@ class TradeMaximizingSolver {
 
 public:
 
-	TradeMaximizingSolver(std::vector<Asset> assets);
+	// Both tableau types pivot identically; DENSE is kept for cross-checking.
+	TradeMaximizingSolver(AssetIndex const& assetIndex, SimplexTableauType tableauType = SimplexTableauType::SPARSE);
+	TradeMaximizingSolver(std::vector<Asset> assets, SimplexTableauType tableauType = SimplexTableauType::SPARSE);
 
 	TradeMaximizingSolver(const TradeMaximizingSolver&) = delete;
 	TradeMaximizingSolver& operator=(const TradeMaximizingSolver&) = delete;
 
-	void setUpperBound(AssetPair const& assetPair, int128_t upperBound);
+	void setUpperBound(AssetPair const& assetPair, int128_t upperBound) override;
 
-	void doSolve();
+	void doSolve() override;
 
-	int128_t getRowResult(AssetPair const& assetPair) const;
+	int128_t getRowResult(AssetPair const& assetPair) const override;
 
-	UnorderedMap<AssetPair, int128_t, AssetPairHash> getSolution() const;
+	UnorderedMap<AssetPair, int128_t, AssetPairHash> getSolution() const override;
 
 	void printSolution() const;
 
@@ -0,0 +1,246 @@
+#include "simplex/tableau.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace stellar {
+
+DenseSimplexTableau::DenseSimplexTableau(size_t numCols)
+	: mNumCols(numCols)
+	, mRows()
+	{}
+
+size_t
+DenseSimplexTableau::addRow()
+{
+	mRows.emplace_back();
+	mRows.back().first.resize(mNumCols, 0);
+	mRows.back().second = 0;
+	return mRows.size() - 1;
+}
+
+void
+DenseSimplexTableau::addRowToRow(size_t rowToAddIdx, size_t rowToBeAddedToIdx, int8_t coefficient) {
+	auto& rowToAdd = mRows[rowToAddIdx];
+	auto& rowToBeAddedTo = mRows[rowToBeAddedToIdx];
+	const auto sz = rowToAdd.first.size();
+
+	auto* rowToBeAddedToPtr = rowToBeAddedTo.first.data();
+	auto* rowToAddPtr = rowToAdd.first.data();
+
+	for (size_t i = 0; i < sz; i++) {
+		rowToBeAddedToPtr[i] += rowToAddPtr[i] * coefficient;
+	}
+	rowToBeAddedTo.second += rowToAdd.second * coefficient;
+}
+
+void
+DenseSimplexTableau::multiplyRow(size_t rowIdx, int8_t coefficient) {
+	if (coefficient == 1) return;
+	auto& row = mRows[rowIdx];
+
+	const auto sz = row.first.size();
+
+	auto* rowPtr = row.first.data();
+
+	for (size_t i = 0; i < sz; i++) {
+		rowPtr[i] *= coefficient;
+	}
+	row.second *= coefficient;
+}
+
+void
+DenseSimplexTableau::getNonzeroRows(size_t colIdx, std::vector<size_t>& out) const
+{
+	out.clear();
+	for (size_t i = 0; i < mRows.size(); i++) {
+		if (mRows[i].first[colIdx] != 0) {
+			out.push_back(i);
+		}
+	}
+}
+
+std::optional<size_t>
+DenseSimplexTableau::getFirstPositiveColumn(size_t rowIdx, std::vector<bool> const& allowedCols) const
+{
+	auto const& row = mRows[rowIdx].first;
+	for (size_t i = 0; i < allowedCols.size(); i++) {
+		if (row[i] > 0 && allowedCols[i]) {
+			return i;
+		}
+	}
+	return std::nullopt;
+}
+
+void
+DenseSimplexTableau::printRow(size_t rowIdx) const {
+	for (size_t i = 0; i < mNumCols; i++) {
+		auto var = mRows[rowIdx].first[i];
+		if (var < 0) {
+			std::printf("-%d ", -var);
+		} else {
+			std::printf(" %d ", var);
+		}
+	}
+	double coeff = (double) mRows[rowIdx].second;
+	std::printf("%lf\n", coeff);
+}
+
+SparseSimplexTableau::SparseSimplexTableau(size_t numCols)
+	: mNumCols(numCols)
+	, mRows()
+	, mRowsByCol(numCols)
+	, mMergeBuffer()
+	{}
+
+size_t
+SparseSimplexTableau::addRow()
+{
+	mRows.emplace_back();
+	return mRows.size() - 1;
+}
+
+int8_t
+SparseSimplexTableau::get(size_t rowIdx, size_t colIdx) const
+{
+	auto const& entries = mRows[rowIdx].mEntries;
+	auto it = std::lower_bound(entries.begin(), entries.end(), colIdx, [] (Entry const& e, size_t col) {
+		return e.first < col;
+	});
+	if (it != entries.end() && it->first == colIdx) {
+		return it->second;
+	}
+	return 0;
+}
+
+void
+SparseSimplexTableau::set(size_t rowIdx, size_t colIdx, int8_t value)
+{
+	if (colIdx >= mNumCols) {
+		throw std::runtime_error("column out of range");
+	}
+	auto& entries = mRows[rowIdx].mEntries;
+	auto it = std::lower_bound(entries.begin(), entries.end(), colIdx, [] (Entry const& e, size_t col) {
+		return e.first < col;
+	});
+	bool present = (it != entries.end() && it->first == colIdx);
+	if (value == 0) {
+		if (present) {
+			entries.erase(it);
+			mRowsByCol[colIdx].erase(rowIdx);
+		}
+		return;
+	}
+	if (present) {
+		it->second = value;
+	} else {
+		entries.insert(it, Entry{static_cast<uint32_t>(colIdx), value});
+		mRowsByCol[colIdx].insert(rowIdx);
+	}
+}
+
+void
+SparseSimplexTableau::addRowToRow(size_t rowToAddIdx, size_t rowToBeAddedToIdx, int8_t coefficient)
+{
+	if (coefficient == 0) {
+		return;
+	}
+
+	auto const& src = mRows[rowToAddIdx].mEntries;
+	auto& dst = mRows[rowToBeAddedToIdx].mEntries;
+
+	mMergeBuffer.clear();
+	mMergeBuffer.reserve(src.size() + dst.size());
+
+	// merge of two sorted lists, dropping entries that cancel to zero
+	size_t i = 0, j = 0;
+	while (i < src.size() || j < dst.size()) {
+		if (j == dst.size() || (i < src.size() && src[i].first < dst[j].first)) {
+			int8_t value = src[i].second * coefficient;
+			mMergeBuffer.push_back({src[i].first, value});
+			mRowsByCol[src[i].first].insert(rowToBeAddedToIdx);
+			i++;
+		} else if (i == src.size() || dst[j].first < src[i].first) {
+			mMergeBuffer.push_back(dst[j]);
+			j++;
+		} else {
+			int8_t value = dst[j].second + src[i].second * coefficient;
+			if (value != 0) {
+				mMergeBuffer.push_back({dst[j].first, value});
+			} else {
+				mRowsByCol[dst[j].first].erase(rowToBeAddedToIdx);
+			}
+			i++;
+			j++;
+		}
+	}
+
+	std::swap(dst, mMergeBuffer);
+
+	mRows[rowToBeAddedToIdx].mRHS += mRows[rowToAddIdx].mRHS * coefficient;
+}
+
+void
+SparseSimplexTableau::multiplyRow(size_t rowIdx, int8_t coefficient)
+{
+	if (coefficient == 1) return;
+	if (coefficient == 0) {
+		throw std::runtime_error("can't zero out a row");
+	}
+	auto& row = mRows[rowIdx];
+	for (auto& entry : row.mEntries) {
+		entry.second *= coefficient;
+	}
+	row.mRHS *= coefficient;
+}
+
+void
+SparseSimplexTableau::getNonzeroRows(size_t colIdx, std::vector<size_t>& out) const
+{
+	auto const& rows = mRowsByCol[colIdx];
+	out.assign(rows.begin(), rows.end());
+}
+
+std::optional<size_t>
+SparseSimplexTableau::getFirstPositiveColumn(size_t rowIdx, std::vector<bool> const& allowedCols) const
+{
+	for (auto const& [colIdx, value] : mRows[rowIdx].mEntries) {
+		if (colIdx >= allowedCols.size()) {
+			break;
+		}
+		if (value > 0 && allowedCols[colIdx]) {
+			return colIdx;
+		}
+	}
+	return std::nullopt;
+}
+
+void
+SparseSimplexTableau::printRow(size_t rowIdx) const {
+	for (size_t i = 0; i < mNumCols; i++) {
+		auto var = get(rowIdx, i);
+		if (var < 0) {
+			std::printf("-%d ", -var);
+		} else {
+			std::printf(" %d ", var);
+		}
+	}
+	double coeff = (double) mRows[rowIdx].mRHS;
+	std::printf("%lf\n", coeff);
+}
+
+std::unique_ptr<SimplexTableau>
+makeSimplexTableau(SimplexTableauType type, size_t numCols)
+{
+	switch(type)
+	{
+		case SimplexTableauType::DENSE:
+			return std::make_unique<DenseSimplexTableau>(numCols);
+		case SimplexTableauType::SPARSE:
+			return std::make_unique<SparseSimplexTableau>(numCols);
+	}
+	throw std::runtime_error("unknown tableau type");
+}
+
+} /* stellar */
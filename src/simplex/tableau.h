@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <set>
+#include <vector>
+
+namespace stellar {
+
+/*
+ Storage for the simplex tableau used by TradeMaximizingSolver.
+ Coefficients are small integers (the constraint matrix is totally
+ unimodular), and right-hand sides are exact int128s.
+
+ The solver only touches the tableau through this interface, so both
+ implementations follow identical pivot sequences and produce identical
+ results.
+*/
+class SimplexTableau {
+
+public:
+	using int128_t = __int128_t;
+
+	virtual ~SimplexTableau() = default;
+
+	// appends an all-zero row, and returns its index
+	virtual size_t addRow() = 0;
+	virtual size_t numRows() const = 0;
+
+	virtual int8_t get(size_t rowIdx, size_t colIdx) const = 0;
+	virtual void set(size_t rowIdx, size_t colIdx, int8_t value) = 0;
+
+	virtual int128_t getRHS(size_t rowIdx) const = 0;
+	virtual void setRHS(size_t rowIdx, int128_t value) = 0;
+
+	// row[rowToBeAddedToIdx] += coefficient * row[rowToAddIdx]
+	virtual void addRowToRow(size_t rowToAddIdx, size_t rowToBeAddedToIdx, int8_t coefficient) = 0;
+	virtual void multiplyRow(size_t rowIdx, int8_t coefficient) = 0;
+
+	// Indices of rows with a nonzero entry in column colIdx, in increasing order.
+	virtual void getNonzeroRows(size_t colIdx, std::vector<size_t>& out) const = 0;
+
+	// smallest column index colIdx < allowedCols.size()
+	// with allowedCols[colIdx] and a positive entry in row rowIdx.
+	virtual std::optional<size_t>
+	getFirstPositiveColumn(size_t rowIdx, std::vector<bool> const& allowedCols) const = 0;
+
+	virtual void printRow(size_t rowIdx) const = 0;
+};
+
+// One full-width row per constraint.
+class DenseSimplexTableau : public SimplexTableau {
+
+	using Row = std::pair<std::vector<int8_t>, int128_t>;
+
+	const size_t mNumCols;
+	std::vector<Row> mRows;
+
+public:
+
+	DenseSimplexTableau(size_t numCols);
+
+	size_t addRow() override;
+	size_t numRows() const override {
+		return mRows.size();
+	}
+
+	int8_t get(size_t rowIdx, size_t colIdx) const override {
+		return mRows[rowIdx].first[colIdx];
+	}
+	void set(size_t rowIdx, size_t colIdx, int8_t value) override {
+		mRows[rowIdx].first[colIdx] = value;
+	}
+
+	int128_t getRHS(size_t rowIdx) const override {
+		return mRows[rowIdx].second;
+	}
+	void setRHS(size_t rowIdx, int128_t value) override {
+		mRows[rowIdx].second = value;
+	}
+
+	void addRowToRow(size_t rowToAddIdx, size_t rowToBeAddedToIdx, int8_t coefficient) override;
+	void multiplyRow(size_t rowIdx, int8_t coefficient) override;
+
+	void getNonzeroRows(size_t colIdx, std::vector<size_t>& out) const override;
+
+	std::optional<size_t>
+	getFirstPositiveColumn(size_t rowIdx, std::vector<bool> const& allowedCols) const override;
+
+	void printRow(size_t rowIdx) const override;
+};
+
+/*
+ Rows store only their nonzero entries, sorted by column, and each
+ column tracks the set of rows in which it is nonzero.
+
+ Each constraint row has O(n) nonzeros out of O(n^2) columns, and
+ a pivot only needs to update the rows with a nonzero in the pivot
+ column, so a pivot costs roughly O(n) instead of O(n^3).
+*/
+class SparseSimplexTableau : public SimplexTableau {
+
+	using Entry = std::pair<uint32_t, int8_t>; // (column, coefficient)
+
+	struct Row {
+		std::vector<Entry> mEntries; // sorted by column, no zeros
+		int128_t mRHS = 0;
+	};
+
+	const size_t mNumCols;
+	std::vector<Row> mRows;
+
+	// mRowsByCol[c] = rows with a nonzero in column c
+	std::vector<std::set<size_t>> mRowsByCol;
+
+	// scratch space for addRowToRow
+	std::vector<Entry> mMergeBuffer;
+
+public:
+
+	SparseSimplexTableau(size_t numCols);
+
+	size_t addRow() override;
+	size_t numRows() const override {
+		return mRows.size();
+	}
+
+	int8_t get(size_t rowIdx, size_t colIdx) const override;
+	void set(size_t rowIdx, size_t colIdx, int8_t value) override;
+
+	int128_t getRHS(size_t rowIdx) const override {
+		return mRows[rowIdx].mRHS;
+	}
+	void setRHS(size_t rowIdx, int128_t value) override {
+		mRows[rowIdx].mRHS = value;
+	}
+
+	void addRowToRow(size_t rowToAddIdx, size_t rowToBeAddedToIdx, int8_t coefficient) override;
+	void multiplyRow(size_t rowIdx, int8_t coefficient) override;
+
+	void getNonzeroRows(size_t colIdx, std::vector<size_t>& out) const override;
+
+	std::optional<size_t>
+	getFirstPositiveColumn(size_t rowIdx, std::vector<bool> const& allowedCols) const override;
+
+	void printRow(size_t rowIdx) const override;
+};
+
+enum class SimplexTableauType
+{
+	DENSE,
+	SPARSE
+};
+
+std::unique_ptr<SimplexTableau>
+makeSimplexTableau(SimplexTableauType type, size_t numCols);
+
+} /* stellar */
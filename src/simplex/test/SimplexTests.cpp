@@ -5,10 +5,14 @@
 #include "test/test.h"
 #include "test/TxTests.h"
 
+#include "util/Math.h"
 #include "util/XDROperators.h"
 
+#include "simplex/circulation.h"
 #include "simplex/solver.h"
 
+#include <chrono>
+
 using namespace stellar;
 using namespace stellar::txtest;
 
@@ -20,7 +24,7 @@ static Asset makeSimplexAsset(std::string const& issuerName, std::string const&
 
 using int128_t = __int128_t;
 
-static void checkSimplexAmount(Asset const& sell, Asset const& buy, TradeMaximizingSolver const& solver, int128_t amount)
+static void checkSimplexAmount(Asset const& sell, Asset const& buy, AbstractTradeMaximizingSolver const& solver, int128_t amount)
 {
 	AssetPair tradingPair {
 		.selling = sell,
@@ -30,7 +34,7 @@ static void checkSimplexAmount(Asset const& sell, Asset const& buy, TradeMaximiz
 	REQUIRE(solver.getRowResult(tradingPair) == amount);
 }
 
-static void setSimplexAmount(Asset const& sell, Asset const& buy, TradeMaximizingSolver& solver, int128_t amount)
+static void setSimplexAmount(Asset const& sell, Asset const& buy, AbstractTradeMaximizingSolver& solver, int128_t amount)
 {
 	AssetPair tradingPair {
 		.selling = sell,
@@ -39,7 +43,7 @@ static void setSimplexAmount(Asset const& sell, Asset const& buy, TradeMaximizin
 	solver.setUpperBound(tradingPair, amount);
 }
 
-static void checkAssetConstraint(TradeMaximizingSolver const& solver, Asset const& asset, std::vector<Asset> const& otherAssets)
+static void checkAssetConstraint(AbstractTradeMaximizingSolver const& solver, Asset const& asset, std::vector<Asset> const& otherAssets)
 {
 	int128_t sellAmount = 0, buyAmount = 0;
 
@@ -54,7 +58,7 @@ static void checkAssetConstraint(TradeMaximizingSolver const& solver, Asset cons
 	REQUIRE(sellAmount == buyAmount);
 }
 
-static void checkAllAssetConstraints(TradeMaximizingSolver const& solver, std::vector<Asset> const& assets)
+static void checkAllAssetConstraints(AbstractTradeMaximizingSolver const& solver, std::vector<Asset> const& assets)
 {
 	for (auto const& asset : assets)
 	{
@@ -62,7 +66,7 @@ static void checkAllAssetConstraints(TradeMaximizingSolver const& solver, std::v
 	}
 }
 
-static void checkObjective(TradeMaximizingSolver const& solver, std::vector<Asset> const& assets, int128_t expectedObjective)
+static void checkObjective(AbstractTradeMaximizingSolver const& solver, std::vector<Asset> const& assets, int128_t expectedObjective)
 {
 	int128_t obj = 0;
 	for (size_t i = 0; i < assets.size(); i++) {
@@ -244,3 +248,170 @@ TEST_CASE("simplex 3 asset", "[simplex]")
 	}
 }
 
+
+TEST_CASE("simplex sparse and dense tableaus agree", "[simplex]")
+{
+	std::vector<Asset> assets;
+	for (auto i = 0u; i < 8; i++) {
+		assets.emplace_back(makeSimplexAsset("issuer", fmt::format("A{}", i)));
+	}
+
+	for (auto trial = 0; trial < 20; trial++)
+	{
+		TradeMaximizingSolver dense(assets, SimplexTableauType::DENSE);
+		TradeMaximizingSolver sparse(assets, SimplexTableauType::SPARSE);
+
+		int128_t totalBound = 0;
+		for (size_t i = 0; i < assets.size(); i++) {
+			for (size_t j = 0; j < assets.size(); j++) {
+				if (i != j && rand_flip()) {
+					int128_t bound = rand_uniform<int64_t>(1, 1'000'000);
+					setSimplexAmount(assets[i], assets[j], dense, bound);
+					setSimplexAmount(assets[i], assets[j], sparse, bound);
+					totalBound += bound;
+				}
+			}
+		}
+
+		dense.doSolve();
+		sparse.doSolve();
+
+		checkAllAssetConstraints(sparse, assets);
+
+		int128_t obj = 0;
+		for (size_t i = 0; i < assets.size(); i++) {
+			for (size_t j = 0; j < assets.size(); j++) {
+				if (i != j) {
+					AssetPair tradingPair{
+						.selling = assets[i],
+						.buying = assets[j]
+					};
+					auto amount = sparse.getRowResult(tradingPair);
+					REQUIRE(amount == dense.getRowResult(tradingPair));
+					REQUIRE(amount >= 0);
+					obj += amount;
+				}
+			}
+		}
+		REQUIRE(obj <= totalBound);
+		REQUIRE(sparse.getSolution() == dense.getSolution());
+	}
+}
+
+static int128_t
+setRandomUpperBounds(std::vector<Asset> const& assets, std::vector<AbstractTradeMaximizingSolver*> const& solvers, uint32_t density)
+{
+	int128_t totalBound = 0;
+	for (size_t i = 0; i < assets.size(); i++) {
+		for (size_t j = 0; j < assets.size(); j++) {
+			if (i != j && rand_uniform<uint32_t>(0, 99) < density) {
+				int128_t bound = rand_uniform<int64_t>(1, INT64_MAX);
+				for (auto* solver : solvers) {
+					setSimplexAmount(assets[i], assets[j], *solver, bound);
+				}
+				totalBound += bound;
+			}
+		}
+	}
+	return totalBound;
+}
+
+static int128_t 
+getObjective(AbstractTradeMaximizingSolver const& solver, std::vector<Asset> const& assets)
+{
+	int128_t obj = 0;
+	for (size_t i = 0; i < assets.size(); i++) {
+		for (size_t j = 0; j < assets.size(); j++) {
+			if (i != j) {
+				auto amount = solver.getRowResult(AssetPair{.selling = assets[i], .buying = assets[j]});
+				REQUIRE(amount >= 0);
+				obj += amount;
+			}
+		}
+	}
+	return obj;
+}
+
+TEST_CASE("max circulation matches simplex", "[simplex]")
+{
+	std::vector<Asset> assets;
+	for (auto i = 0u; i < 8; i++) {
+		assets.emplace_back(makeSimplexAsset("issuer", fmt::format("A{}", i)));
+	}
+
+	SECTION("directed cycle")
+	{
+		MaxCirculationSolver solver(assets);
+		setSimplexAmount(assets[0], assets[1], solver, 200);
+		setSimplexAmount(assets[1], assets[2], solver, 100);
+		setSimplexAmount(assets[2], assets[0], solver, 150);
+
+		solver.doSolve();
+
+		checkSimplexAmount(assets[0], assets[1], solver, 100);
+		checkSimplexAmount(assets[1], assets[2], solver, 100);
+		checkSimplexAmount(assets[2], assets[0], solver, 100);
+		checkSimplexAmount(assets[1], assets[0], solver, 0);
+		REQUIRE(solver.getSolution().size() == 3);
+	}
+
+	SECTION("random bounds")
+	{
+		for (auto trial = 0; trial < 20; trial++)
+		{
+			TradeMaximizingSolver simplex(assets);
+			MaxCirculationSolver circulation(assets);
+
+			auto totalBound = setRandomUpperBounds(assets, {&simplex, &circulation}, 40);
+
+			simplex.doSolve();
+			circulation.doSolve();
+
+			checkAllAssetConstraints(circulation, assets);
+
+			// optima need not be unique, but the objective is
+			auto obj = getObjective(circulation, assets);
+			REQUIRE(obj == getObjective(simplex, assets));
+			REQUIRE(obj <= totalBound);
+		}
+	}
+}
+
+TEST_CASE("trade maximization bench", "[simplex][bench][!hide]")
+{
+	for (size_t numAssets : {10, 20, 50})
+	{
+		std::vector<Asset> assets;
+		for (auto i = 0u; i < numAssets; i++) {
+			assets.emplace_back(makeSimplexAsset("issuer", fmt::format("A{}", i)));
+		}
+
+		std::chrono::nanoseconds simplexTime(0), circulationTime(0);
+		const int numTrials = 5;
+
+		for (auto trial = 0; trial < numTrials; trial++)
+		{
+			TradeMaximizingSolver simplex(assets);
+			MaxCirculationSolver circulation(assets);
+
+			setRandomUpperBounds(assets, {&simplex, &circulation}, 60);
+
+			auto start = std::chrono::steady_clock::now();
+			simplex.doSolve();
+			auto mid = std::chrono::steady_clock::now();
+			circulation.doSolve();
+			auto end = std::chrono::steady_clock::now();
+
+			simplexTime += mid - start;
+			circulationTime += end - mid;
+
+			REQUIRE(getObjective(simplex, assets) == getObjective(circulation, assets));
+		}
+
+		std::printf("%lu assets: simplex %lf ms, max circulation %lf ms (mean of %d)\n",
+			numAssets,
+			std::chrono::duration<double, std::milli>(simplexTime).count() / numTrials,
+			std::chrono::duration<double, std::milli>(circulationTime).count() / numTrials,
+			numTrials);
+	}
+}
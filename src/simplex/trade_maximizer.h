@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ledger/AssetPair.h"
+#include "ledger/LedgerHashUtils.h"
+
+#include "util/UnorderedMap.h"
+#include "util/XDROperators.h"
+
+#include <cstdint>
+
+namespace stellar {
+
+/*
+ Given upper bounds on the amount of each asset pair traded,
+ maximizes total trade volume subject to every asset
+ being sold in the same amount as it is bought.
+*/
+class AbstractTradeMaximizingSolver {
+
+protected:
+	using int128_t = __int128_t;
+
+public:
+
+	virtual ~AbstractTradeMaximizingSolver() = default;
+
+	// Throws if called twice for the same pair, or with a nonpositive bound.
+	virtual void setUpperBound(AssetPair const& assetPair, int128_t upperBound) = 0;
+
+	virtual void doSolve() = 0;
+
+	// amount of assetPair.selling sold for assetPair.buying
+	virtual int128_t getRowResult(AssetPair const& assetPair) const = 0;
+
+	// only contains pairs that trade a nonzero amount
+	virtual UnorderedMap<AssetPair, int128_t, AssetPairHash> getSolution() const = 0;
+};
+
+} /* stellar */
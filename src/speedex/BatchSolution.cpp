@@ -2,11 +2,14 @@
 
 #include "speedex/OrderbookClearingTarget.h"
 
+#include <algorithm>
+
 namespace stellar {
 
 
-BatchSolution::BatchSolution(UnorderedMap<AssetPair, int128_t, AssetPairHash> const& tradeAmounts, std::map<Asset, uint64_t> const& prices)
+BatchSolution::BatchSolution(UnorderedMap<AssetPair, int128_t, AssetPairHash> const& tradeAmounts, PriceVector const& prices, AssetIndex const& assetIndex)
 	: mTradeAmountsTimesPrices(tradeAmounts)
+	, mAssetIndex(assetIndex)
 	, mAssetPrices(prices)
 {}
 
@@ -14,11 +17,25 @@ BatchSolution::BatchSolution(UnorderedMap<AssetPair, int128_t, AssetPairHash> co
 std::vector<OrderbookClearingTarget>
 BatchSolution::produceClearingTargets() const {
 
+	// UnorderedMap iteration order is randomized; sort by (sell, buy) index
+	// so that targets are cleared in a deterministic order.
+	std::vector<std::pair<std::pair<uint32_t, uint32_t>, decltype(mTradeAmountsTimesPrices)::value_type const*>> sorted;
+	for (auto const& entry : mTradeAmountsTimesPrices) {
+		sorted.emplace_back(
+			std::make_pair(mAssetIndex.getIndex(entry.first.selling), mAssetIndex.getIndex(entry.first.buying)),
+			&entry);
+	}
+	std::sort(sorted.begin(), sorted.end(), [] (auto const& a, auto const& b) {
+		return a.first < b.first;
+	});
+
 	std::vector<OrderbookClearingTarget> out;
+	out.reserve(sorted.size());
 
-	for (auto& [tradingPair, amount] : mTradeAmountsTimesPrices) {
-		uint64_t sellPrice = mAssetPrices.at(tradingPair.selling);
-		uint64_t buyPrice = mAssetPrices.at(tradingPair.buying);
+	for (auto const& [idxs, entry] : sorted) {
+		auto const& [tradingPair, amount] = *entry;
+		uint64_t sellPrice = mAssetPrices[idxs.first];
+		uint64_t buyPrice = mAssetPrices[idxs.second];
 
 		out.emplace_back(tradingPair, sellPrice, buyPrice, amount);
 	}
@@ -31,11 +48,11 @@ BatchSolution::getValuationResults() const
 
 	std::vector<SpeedexClearingValuation> out;
 
-	for (auto const& [asset, price] : mAssetPrices)
+	for (uint32_t i = 0; i < mAssetIndex.size(); i++)
 	{
 		out.emplace_back();
-		out.back().asset = asset;
-		out.back().price = price;
+		out.back().asset = mAssetIndex.getAsset(i);
+		out.back().price = mAssetPrices[i];
 	}
 	return out;
 }
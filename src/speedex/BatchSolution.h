@@ -5,6 +5,7 @@
 #include "ledger/LedgerHashUtils.h"
 #include "util/XDROperators.h"
 #include "util/UnorderedMap.h"
+#include "speedex/PriceVector.h"
 #include <map>
 
 #include "xdr/Stellar-ledger.h"
@@ -18,7 +19,8 @@ class BatchSolution {
 
 	UnorderedMap<AssetPair, int128_t, AssetPairHash> mTradeAmountsTimesPrices;
 
-	std::map<Asset, uint64_t> mAssetPrices;
+	AssetIndex mAssetIndex;
+	PriceVector mAssetPrices;
 
 	//Note different units than in IOCOffer precomputedTatonnementStats
 	//This is just (trade amount -- int64_t) * valuation (uint64_t)
@@ -26,7 +28,8 @@ public:
 
 	BatchSolution(
 		UnorderedMap<AssetPair, int128_t, AssetPairHash> const& tradeAmounts,
-		std::map<Asset, uint64_t> const& prices);
+		PriceVector const& prices,
+		AssetIndex const& assetIndex);
 
 	std::vector<OrderbookClearingTarget>
 	produceClearingTargets() const;
@@ -5,7 +5,9 @@
 
 #include "speedex/DemandUtils.h"
 
-#include "simplex/solver.h"
+#include "simplex/trade_maximizer.h"
+
+#include <algorithm>
 
 namespace stellar
 {
@@ -13,43 +15,61 @@ namespace stellar
 DemandOracle::DemandOracle(IOCOrderbookManager const& orderbooks, LiquidityPoolSetFrame const& liquidityPools)
 	: mOrderbooks(orderbooks)
 	, mLiquidityPools(liquidityPools)
-	{}
+	, mAssetIndex(orderbooks.getAssetIndex())
+	, mLiquidityPoolKernel()
+	{
+		mLiquidityPoolKernel.build(mLiquidityPools, mAssetIndex);
+
+		for (uint32_t sellIdx = 0; sellIdx < mAssetIndex.size(); sellIdx++)
+		{
+			for (uint32_t buyIdx = 0; buyIdx < mAssetIndex.size(); buyIdx++)
+			{
+				if (mOrderbooks.hasOrderbook(sellIdx, buyIdx)
+					|| mLiquidityPoolKernel.hasPool(sellIdx, buyIdx))
+				{
+					mActivePairs.emplace_back(sellIdx, buyIdx);
+				}
+			}
+		}
+	}
+
+void
+DemandOracle::demandQuery(PriceVector const& prices, SupplyDemand& supplyDemand, uint8_t smoothMult) const
+{
+	supplyDemand.reset();
+	mOrderbooks.demandQuery(prices, supplyDemand, smoothMult);
+	mLiquidityPoolKernel.demandQuery(prices, supplyDemand);
+}
 
 SupplyDemand
-DemandOracle::demandQuery(std::map<Asset, uint64_t> const& prices, uint8_t smoothMult) const
+DemandOracle::demandQuery(PriceVector const& prices, uint8_t smoothMult) const
 {
-	SupplyDemand sd;
-	mOrderbooks.demandQuery(prices, sd, smoothMult);
-	mLiquidityPools.demandQuery(prices, sd);
+	SupplyDemand sd(mAssetIndex);
+	demandQuery(prices, sd, smoothMult);
 	return sd;
 }
 
 DemandOracle::int128_t
-DemandOracle::demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const
+DemandOracle::demandQueryOneAssetPair(uint32_t sellIdx, uint32_t buyIdx, PriceVector const& prices, uint8_t smoothMult) const
 {
-	return mOrderbooks.demandQueryOneAssetPair(tradingPair, prices)
-		 + mLiquidityPools.demandQueryOneAssetPair(tradingPair, prices);
+	int128_t out = mOrderbooks.demandQueryOneAssetPair(sellIdx, buyIdx, prices, smoothMult);
+	out += mLiquidityPoolKernel.demandQueryOneAssetPair(sellIdx, buyIdx, prices);
+	return out;
 }
 
 void
-DemandOracle::setSolverUpperBounds(TradeMaximizingSolver& solver, std::map<Asset, uint64_t> const& prices) const
+DemandOracle::setSolverUpperBounds(AbstractTradeMaximizingSolver& solver, PriceVector const& prices) const
 {
-	for (auto const& [sellAsset, sellPrice] : prices)
+	for (auto const& [sellIdx, buyIdx] : mActivePairs)
 	{
-		for (auto const& [buyAsset, buyPrice] : prices)
+		int128_t supply = demandQueryOneAssetPair(sellIdx, buyIdx, prices, 0);
+		if (supply != 0)
 		{
-			if (buyAsset != sellAsset)
-			{
-				AssetPair tradingPair {
-					.selling = sellAsset,
-					.buying = buyAsset
-				};
-				int128_t supply = demandQueryOneAssetPair(tradingPair, prices);
-				if (supply != 0)
-				{
-					solver.setUpperBound(tradingPair, supply);
-				}
-			}
+			AssetPair tradingPair {
+				.selling = mAssetIndex.getAsset(sellIdx),
+				.buying = mAssetIndex.getAsset(buyIdx)
+			};
+			solver.setUpperBound(tradingPair, supply);
 		}
 	}
 }
@@ -1,19 +1,22 @@
 #pragma once
 
-#include <map>
 #include "xdr/Stellar-ledger-entries.h"
 
 #include <cstdint>
+#include <vector>
 
 #include "ledger/AssetPair.h"
 
+#include "speedex/LiquidityPoolDemandKernel.h"
+#include "speedex/PriceVector.h"
+
 namespace stellar
 {
 
 class IOCOrderbookManager;
 class LiquidityPoolSetFrame;
 struct SupplyDemand;
-class TradeMaximizingSolver;
+class AbstractTradeMaximizingSolver;
 
 class DemandOracle {
 	using int128_t = __int128;
@@ -21,17 +24,40 @@ class DemandOracle {
 	const IOCOrderbookManager& mOrderbooks;
 	const LiquidityPoolSetFrame& mLiquidityPools;
 
-	int128_t demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const;
+	// owned by mOrderbooks
+	AssetIndex const& mAssetIndex;
+
+	// pool reserves as of construction
+	LiquidityPoolDemandKernel mLiquidityPoolKernel;
 
+	// every (sellIdx, buyIdx) with an orderbook or a liquidity pool, sorted
+	std::vector<std::pair<uint32_t, uint32_t>> mActivePairs;
 
 public:
 
+	// orderbooks must be sealed.  Every liquidity pool asset must be in orderbooks.getAssetIndex().
+	// Pools must not change while the oracle is in use.
 	DemandOracle(IOCOrderbookManager const& orderbooks, LiquidityPoolSetFrame const& liquidityPools);
 
-	SupplyDemand demandQuery(std::map<Asset, uint64_t> const& prices, uint8_t smoothMult) const;
+	AssetIndex const& getAssetIndex() const {
+		return mAssetIndex;
+	}
+
+	// overwrites supplyDemand, without allocating
+	void demandQuery(PriceVector const& prices, SupplyDemand& supplyDemand, uint8_t smoothMult) const;
+
+	SupplyDemand demandQuery(PriceVector const& prices, uint8_t smoothMult) const;
+
+	// Amount of sellIdx offered for sale (times its price) by the orderbook
+	// and liquidity pool trading sellIdx for buyIdx.
+	int128_t demandQueryOneAssetPair(uint32_t sellIdx, uint32_t buyIdx, PriceVector const& prices, uint8_t smoothMult) const;
+
+	std::vector<std::pair<uint32_t, uint32_t>> const& getActivePairs() const {
+		return mActivePairs;
+	}
 
-	void setSolverUpperBounds(TradeMaximizingSolver& solver, std::map<Asset, uint64_t> const& prices) const;
+	void setSolverUpperBounds(AbstractTradeMaximizingSolver& solver, PriceVector const& prices) const;
 };
 
 
-} /* stellar */
\ No newline at end of file
+} /* stellar */
@@ -1,13 +1,28 @@
 #include "speedex/DemandUtils.h"
 
+#include <stdexcept>
+
 namespace stellar
 {
 
+SupplyDemand::SupplyDemand(AssetIndex const& assetIndex)
+	: mAssetIndex(&assetIndex)
+	, mSupplyDemand(assetIndex.size(), {0, 0})
+{}
+
+void
+SupplyDemand::reset()
+{
+	for (auto& sd : mSupplyDemand)
+	{
+		sd = {0, 0};
+	}
+}
+
 void
 SupplyDemand::addSupplyDemand(Asset const& sell, Asset const& buy, int128_t amount)
 {
-	mSupplyDemand[sell].first += amount;
-	mSupplyDemand[buy].second += amount;
+	addSupplyDemand(mAssetIndex->getIndex(sell), mAssetIndex->getIndex(buy), amount);
 }
 void
 SupplyDemand::addSupplyDemand(AssetPair const& tradingPair, int128_t amount) 
@@ -17,8 +32,7 @@ SupplyDemand::addSupplyDemand(AssetPair const& tradingPair, int128_t amount)
 
 SupplyDemand::int128_t
 SupplyDemand::getDelta(Asset const& asset) const {
-	auto const& [supply, demand] = mSupplyDemand.at(asset);
-	return demand - supply;
+	return getDelta(mAssetIndex->getIndex(asset));
 }
 
 TatonnementObjectiveFn 
@@ -27,16 +41,31 @@ SupplyDemand::getObjective() const
 	return TatonnementObjectiveFn(mSupplyDemand);
 }
 
-TatonnementObjectiveFn::TatonnementObjectiveFn(std::map<Asset, std::pair<int128_t, int128_t>> const& supplyDemands)
+TatonnementObjectiveFn::TatonnementObjectiveFn(std::vector<std::pair<int128_t, int128_t>> const& supplyDemands)
 	: value({0, 0})
 {
-	for (auto const& [_, sd] : supplyDemands)
+	for (auto const& sd : supplyDemands)
 	{
 		auto const& [supply, demand] = sd;
 		value += uint256_t::square(demand-supply);
 	}
 }
 
+// Same precision caveats as isBetterThan
+TatonnementObjectiveFn
+TatonnementObjectiveFn::scaledBy(uint8_t tolN, uint8_t tolD) const
+{
+	if (tolN > tolD) {
+		throw std::runtime_error("can only scale objective down");
+	}
+	TatonnementObjectiveFn out(*this);
+	out.value = uint256_t {
+		.lowbits = (value.lowbits / tolD) * tolN,
+		.highbits = (value.highbits / tolD) * tolN
+	};
+	return out;
+}
+
 // is self <= other * (1+tolN/tolD)?
 // is (self - other) < other * (tolN / tolD)
 // this doesn't need to be super precise, so doing (other / tolD) * tolN is ok
@@ -54,4 +83,21 @@ TatonnementObjectiveFn::isBetterThan(TatonnementObjectiveFn const& other, uint8_
 	return compareL <= compareR;
 }
 
-} /* stellar */
\ No newline at end of file
+uint32_t
+TatonnementObjectiveFn::bitLength() const
+{
+	auto bits = [] (uint256_t::uint128_t v) {
+		uint32_t out = 0;
+		while (v) {
+			v >>= 1;
+			out++;
+		}
+		return out;
+	};
+	if (value.highbits) {
+		return 128 + bits(value.highbits);
+	}
+	return bits(value.lowbits);
+}
+
+} /* stellar */
@@ -1,11 +1,12 @@
 #pragma once
 
 #include "speedex/uint256_t.h"
+#include "speedex/PriceVector.h"
 
 #include "ledger/AssetPair.h"
 
 #include <cstdint>
-#include <map>
+#include <vector>
 
 #include "util/XDROperators.h"
 
@@ -14,17 +15,34 @@ namespace stellar
 
 class TatonnementObjectiveFn;
 
+// Indexed by the AssetIndex the SupplyDemand is constructed with.
 struct SupplyDemand {
 	using int128_t = __int128;
 
+	AssetIndex const* mAssetIndex;
+
 	// pairs are (supply, demand)
-	std::map<Asset, std::pair<int128_t, int128_t>> mSupplyDemand;
+	std::vector<std::pair<int128_t, int128_t>> mSupplyDemand;
+
+	SupplyDemand(AssetIndex const& assetIndex);
+
+	// zeroes every entry, without reallocating
+	void reset();
 
+	void addSupplyDemand(uint32_t sellIdx, uint32_t buyIdx, int128_t amount) {
+		mSupplyDemand[sellIdx].first += amount;
+		mSupplyDemand[buyIdx].second += amount;
+	}
 	void addSupplyDemand(Asset const& sell, Asset const& buy, int128_t amount);
 	void addSupplyDemand(AssetPair const& tradingPair, int128_t amount);
 
 	TatonnementObjectiveFn getObjective() const;
 
+	int128_t getDelta(uint32_t idx) const {
+		auto const& [supply, demand] = mSupplyDemand[idx];
+		return demand - supply;
+	}
+
 	int128_t getDelta(Asset const& asset) const;
 
 };
@@ -37,11 +55,17 @@ class TatonnementObjectiveFn
 
 public:
 
-	TatonnementObjectiveFn(std::map<Asset, std::pair<int128_t, int128_t>> const& excessDemands);
+	TatonnementObjectiveFn(std::vector<std::pair<int128_t, int128_t>> const& excessDemands);
+
+	// approximately self * tolN/tolD, for tolN <= tolD
+	TatonnementObjectiveFn scaledBy(uint8_t tolN, uint8_t tolD) const;
 
 	// is self <= other * tolN/tolD?
 	bool isBetterThan(TatonnementObjectiveFn const& other, uint8_t tolN, uint8_t tolD) const;
+
+	// floor(log2(value)) + 1, or 0 for a zero objective.  For metrics.
+	uint32_t bitLength() const;
 };
 
 
-} /* stellar */
\ No newline at end of file
+} /* stellar */
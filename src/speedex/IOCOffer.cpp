@@ -2,8 +2,6 @@
 
 #include "util/XDROperators.h"
 
-#include <xdrpp/marshal.h>
-
 #include "xdr/Stellar-transaction.h"
 #include "crypto/SHA.h"
 
@@ -18,12 +16,20 @@ namespace stellar {
 IOCOffer::IOCOffer(int64_t sellAmount, Price minPrice, AccountID sourceAccount, uint64_t sourceSeqNum, uint32_t opIdNum)
 	: mSellAmount(sellAmount)
 	, mMinPrice(minPrice)
-	, mTotalOrderingHash(offerHash(minPrice, sourceAccount, sourceSeqNum, opIdNum))
 	, mSourceAccount(sourceAccount)
 	, mSourceSeqNum (sourceSeqNum)
 	, mOpIdx(opIdNum)
+	, mTotalOrderingHash()
 {}
 
+Hash const&
+IOCOffer::getTotalOrderingHash() const {
+	if (!mTotalOrderingHash) {
+		mTotalOrderingHash = offerHash(mMinPrice, mSourceAccount, mSourceSeqNum, mOpIdx);
+	}
+	return *mTotalOrderingHash;
+}
+
 std::strong_ordering 
 IOCOffer::operator<=>(const IOCOffer& other) const {
 	int64_t lhs = ((int64_t)mMinPrice.n) * ((int64_t) other.mMinPrice.d);
@@ -36,10 +42,12 @@ IOCOffer::operator<=>(const IOCOffer& other) const {
 		return std::strong_ordering::greater;
 	}
 
-	if (mTotalOrderingHash < other.mTotalOrderingHash) {
+	auto const& hash = getTotalOrderingHash();
+	auto const& otherHash = other.getTotalOrderingHash();
+	if (hash < otherHash) {
 		return std::strong_ordering::less;
 	}
-	if (mTotalOrderingHash > other.mTotalOrderingHash) {
+	if (hash > otherHash) {
 		return std::strong_ordering::greater;
 	}
 	return std::strong_ordering::equal;
@@ -49,16 +57,14 @@ IOCOffer::operator<=>(const IOCOffer& other) const {
 Hash 
 IOCOffer::offerHash(Price price, AccountID sourceAccount, uint64_t sourceSeqNum, uint32_t opIdNum)
 {
-	SHA256 hasher;
-
 	SpeedexIOCOfferHashContents hashContents(
 		sourceAccount,
 		price,
 		sourceSeqNum,
 		opIdNum);
 
-	hasher.add(xdr::xdr_to_opaque(hashContents));
-	return hasher.finish();
+	// streams the fixed-size encoding through a stack buffer
+	return xdrSha256(hashContents);
 }
 
 SpeedexOfferClearingStatus 
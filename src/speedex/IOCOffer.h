@@ -7,6 +7,7 @@
 #include <compare>
 
 #include <cstdint>
+#include <optional>
 
 namespace stellar {
 
@@ -17,7 +18,6 @@ class AbstractLedgerTxn;
 struct IOCOffer {
 	int64_t mSellAmount;
 	Price mMinPrice;
-	Hash mTotalOrderingHash;
 	AccountID mSourceAccount;
 	uint64_t mSourceSeqNum;
 	uint32_t mOpIdx;
@@ -26,10 +26,18 @@ struct IOCOffer {
 
 	std::strong_ordering operator<=>(const IOCOffer& other) const;
 
+	// Breaks ties between offers at the same price.  Computed on first use,
+	// since most offers never tie.  Not thread-safe, but an offer is only
+	// ever compared within its own orderbook.
+	Hash const& getTotalOrderingHash() const;
+
 	// should not be changed by feeBumpTx;
 	static Hash offerHash(Price price, AccountID sourceAccount, uint64_t sourceSeqNum, uint32_t opIdNum);
 
 	SpeedexOfferClearingStatus getClearingStatus(int64_t sellAmount, int64_t buyAmount, AssetPair const& tradingPair) const;
+
+private:
+	mutable std::optional<Hash> mTotalOrderingHash;
 };
 
 } /* stellar */
\ No newline at end of file
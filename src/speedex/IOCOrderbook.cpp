@@ -1,9 +1,16 @@
 #include "speedex/IOCOrderbook.h"
 
+#include "ledger/BalanceDeltaAccumulator.h"
 #include "ledger/LedgerTxn.h"
 
+#include "transactions/TransactionUtils.h"
+
+#include "util/Logging.h"
 #include "util/types.h"
 
+#include <algorithm>
+#include <iterator>
+
 namespace stellar {
 
 IOCOrderbook::IOCOrderbook(AssetPair tradingPair) 
@@ -32,12 +39,104 @@ priceNEQ(Price const& p1, Price const& p2)
 	return ((uint64_t)p1.n) * ((uint64_t) p2.d) != ((uint64_t)p1.d) * ((uint64_t) p2.n);
 }
 
+static uint64_t
+hashPrefix(Hash const& hash)
+{
+	uint64_t out = 0;
+	for (size_t i = 0; i < sizeof(uint64_t); i++) {
+		out = (out << 8) | hash[i];
+	}
+	return out;
+}
+
+void
+IOCOrderbook::sortOffers() {
+	size_t numNewOffers = 0;
+	for (auto const& run : mRuns) {
+		numNewOffers += run.size();
+	}
+
+	mOffers.reserve(mOffers.size() + numNewOffers);
+	for (auto& run : mRuns) {
+		mOffers.insert(mOffers.end(), 
+			std::make_move_iterator(run.begin()), 
+			std::make_move_iterator(run.end()));
+	}
+	mRuns.clear();
+
+	mSortedOffers.clear();
+	mSortedOffers.reserve(mOffers.size());
+	for (uint32_t i = 0; i < mOffers.size(); i++) {
+		mSortedOffers.push_back(OfferKey{
+			.mMinPrice = mOffers[i].mMinPrice,
+			.mHashPrefix = 0,
+			.mOfferIdx = i
+		});
+	}
+
+	auto priceCmp = [] (OfferKey const& a, OfferKey const& b) -> std::strong_ordering {
+		int64_t lhs = ((int64_t)a.mMinPrice.n) * ((int64_t) b.mMinPrice.d);
+		int64_t rhs = ((int64_t)a.mMinPrice.d) * ((int64_t) b.mMinPrice.n);
+		return lhs <=> rhs;
+	};
+
+	// Same order as IOCOffer::operator<=>.  Only valid once the hash prefixes
+	// of any keys at the same price are filled in.  Ties on the hash prefix
+	// are rare, and only those touch the offer payloads.
+	auto cmp = [this, &priceCmp] (OfferKey const& a, OfferKey const& b) -> std::strong_ordering {
+		auto res = priceCmp(a, b);
+		if (res != 0) {
+			return res;
+		}
+		if (a.mHashPrefix != b.mHashPrefix) {
+			return a.mHashPrefix <=> b.mHashPrefix;
+		}
+		return mOffers[a.mOfferIdx] <=> mOffers[b.mOfferIdx];
+	};
+
+	// Sort by price alone first, then hash (and sort) only the offers
+	// that tie on price with another offer.
+	std::sort(mSortedOffers.begin(), mSortedOffers.end(), 
+		[&priceCmp] (OfferKey const& a, OfferKey const& b) {
+			return priceCmp(a, b) < 0;
+		});
+
+	auto groupBegin = mSortedOffers.begin();
+	while (groupBegin != mSortedOffers.end()) {
+		auto groupEnd = std::find_if(groupBegin + 1, mSortedOffers.end(), 
+			[&priceCmp, groupBegin] (OfferKey const& key) {
+				return priceCmp(*groupBegin, key) != 0;
+			});
+
+		if (groupEnd - groupBegin > 1) {
+			for (auto it = groupBegin; it != groupEnd; it++) {
+				it -> mHashPrefix = hashPrefix(mOffers[it -> mOfferIdx].getTotalOrderingHash());
+			}
+			std::sort(groupBegin, groupEnd, 
+				[&cmp] (OfferKey const& a, OfferKey const& b) {
+					return cmp(a, b) < 0;
+				});
+		}
+		groupBegin = groupEnd;
+	}
+
+	mSortedOffers.erase(
+		std::unique(mSortedOffers.begin(), mSortedOffers.end(), 
+			[&cmp] (OfferKey const& a, OfferKey const& b) {
+				return cmp(a, b) == 0;
+			}),
+		mSortedOffers.end());
+}
+
 void 
 IOCOrderbook::doPriceComputationPreprocessing() {
 	//std::printf("preprocess\n");
+	sortOffers();
+
 	PriceCompStats stats = zeroStats;
 	mPrecomputedTatonnementData.clear();
-	for (auto& offer : mOffers) {
+	for (auto const& key : mSortedOffers) {
+		auto const& offer = mOffers[key.mOfferIdx];
 		//intentionally starting with 0 at bot
 		if (priceNEQ(offer.mMinPrice, stats.marginalPrice))
 		{
@@ -59,50 +158,116 @@ IOCOrderbook::doPriceComputationPreprocessing() {
 
 void 
 IOCOrderbook::addOffer(IOCOffer offer) {
-	mOffers.insert(offer);
+	if (mRuns.empty()) {
+		mRuns.emplace_back();
+	}
+	mRuns.back().push_back(std::move(offer));
 }
 
 void
-IOCOrderbook::commitChild(const IOCOrderbook& other) {
+IOCOrderbook::commitChild(IOCOrderbook& other) {
 	throwIfCleared();
 
 	if (mTradingPair != other.mTradingPair) {
 		throw std::runtime_error("merge orderbooks trading pair mismatch!");
 	}
-	mOffers.insert(other.mOffers.begin(), other.mOffers.end());
+
+	if (!other.mOffers.empty()) {
+		mRuns.push_back(std::move(other.mOffers));
+		other.mOffers.clear();
+		other.mSortedOffers.clear();
+	}
+	for (auto& run : other.mRuns) {
+		mRuns.push_back(std::move(run));
+	}
+	other.mRuns.clear();
+
 	mPrecomputedTatonnementData.clear();
 }
 
-std::pair<std::vector<SpeedexOfferClearingStatus>, std::optional<SpeedexLiquidityPoolClearingStatus>>
-IOCOrderbook::clearOffers(AbstractLedgerTxn& ltx, OrderbookClearingTarget& target, LiquidityPoolFrame& lpFrame)
+IOCOrderbook::OrderbookFills
+IOCOrderbook::computeFills(OrderbookClearingTarget& target) const
 {
-	throwIfCleared();
-
-	auto sellStr = assetToString(mTradingPair.selling);
-	auto buyStr = assetToString(mTradingPair.buying);
-
-	std::printf("clearing trade pair sell %s buy %s\n", sellStr.c_str(), buyStr.c_str());
+	if (mCleared) {
+		throw std::runtime_error("Throw if cleared!");
+	}
+	if (!mRuns.empty()) {
+		throw std::runtime_error("orderbook has unsorted offers (not preprocessed)");
+	}
 
-	std::vector<SpeedexOfferClearingStatus> out;
+	OrderbookFills out;
 
-	for (auto iter = mOffers.begin(); iter != mOffers.end(); iter++) {
+	for (auto const& key : mSortedOffers) {
 		if (!target.doneClearing()) {
+			auto const& offer = mOffers[key.mOfferIdx];
 			// TODO adjust here if prioritizing full execution over trading at all
-			out.push_back(target.clearOffer(ltx, *iter));
+			out.mOfferFills.emplace_back(&offer, target.computeOfferFill(offer));
 		} else
 		{
 			break;
 		}
 	}
 
-	std::optional<SpeedexLiquidityPoolClearingStatus> lpRes = std::nullopt;
+	if (!target.doneClearing()) {
+		out.mLiquidityPoolFill = target.computeLiquidityPoolFill();
+	}
+	return out;
+}
 
-	if (!target.doneClearing() && lpFrame) {
-		std::printf("finishing with lp\n");
-		lpRes = target.finishWithLiquidityPool(ltx, lpFrame);
+size_t
+IOCOrderbook::numOffers() const
+{
+	size_t out = mOffers.size();
+	for (auto const& run : mRuns) {
+		out += run.size();
 	}
-	if (!target.doneClearing()) {
-		throw std::runtime_error("invalid trade amounts!");
+	return out;
+}
+
+void
+IOCOrderbook::insertKeysForClearing(UnorderedSet<LedgerKey>& keys) const
+{
+	if (!mRuns.empty()) {
+		throw std::runtime_error("orderbook has unsorted offers (not preprocessed)");
+	}
+
+	auto insertKey = [&] (AccountID const& account, Asset const& asset) {
+		if (asset.type() == ASSET_TYPE_NATIVE) {
+			keys.emplace(accountKey(account));
+		} else {
+			keys.emplace(trustlineKey(account, asset));
+		}
+	};
+
+	for (auto const& offer : mOffers) {
+		insertKey(offer.mSourceAccount, mTradingPair.selling);
+		insertKey(offer.mSourceAccount, mTradingPair.buying);
+	}
+}
+
+std::pair<std::vector<SpeedexOfferClearingStatus>, std::optional<SpeedexLiquidityPoolClearingStatus>>
+IOCOrderbook::applyFills(BalanceDeltaAccumulator& balances, OrderbookClearingTarget const& target, OrderbookFills const& fills, LiquidityPoolFrame& lpFrame)
+{
+	throwIfCleared();
+
+	CLOG_TRACE(Speedex, "clearing trade pair sell {} buy {}",
+		assetToString(mTradingPair.selling),
+		assetToString(mTradingPair.buying));
+
+	std::vector<SpeedexOfferClearingStatus> out;
+
+	for (auto const& [offer, fill] : fills.mOfferFills) {
+		out.push_back(target.applyOfferFill(balances, *offer, fill));
+	}
+
+	std::optional<SpeedexLiquidityPoolClearingStatus> lpRes = std::nullopt;
+
+	if (fills.mLiquidityPoolFill) {
+		if (!lpFrame) {
+			throw std::runtime_error("invalid trade amounts!");
+		}
+		CLOG_TRACE(Speedex, "finishing with lp");
+		lpRes = target.applyLiquidityPoolFill(lpFrame, *fills.mLiquidityPoolFill);
 	}
 	mCleared = true;
 
@@ -256,13 +421,31 @@ IOCOrderbook::cumulativeOfferedForSaleTimesPrice(uint64_t sellPrice, uint64_t bu
 	auto partialExecStats = getPriceCompStats(partialExecSellPrice, buyPrice);
 	auto fullExecStats = getPriceCompStats(fullExecSellPrice, buyPrice);
 
-	int64_t fullExecEndow = fullExecStats.cumulativeOfferedForSale;
-	int64_t partialExecEndow = partialExecStats.cumulativeOfferedForSale - fullExecEndow;
+	return valueSold(
+		fullExecStats.cumulativeOfferedForSale,
+		fullExecStats.cumulativeOfferedForSaleTimesPrice,
+		partialExecStats.cumulativeOfferedForSale,
+		partialExecStats.cumulativeOfferedForSaleTimesPrice,
+		sellPrice,
+		buyPrice,
+		smoothMult);
+}
 
-//	std::printf("full endow %lld partial endow %lld\n", fullExecEndow, partialExecEndow);
+IOCOrderbook::int128_t
+IOCOrderbook::valueSold(
+	int64_t fullExecCumulativeOffered,
+	int128_t fullExecCumulativeOfferedTimesPrice,
+	int64_t partialExecCumulativeOffered,
+	int128_t partialExecCumulativeOfferedTimesPrice,
+	uint64_t sellPrice,
+	uint64_t buyPrice,
+	uint8_t smoothMult)
+{
+	int64_t fullExecEndow = fullExecCumulativeOffered;
+	int64_t partialExecEndow = partialExecCumulativeOffered - fullExecEndow;
 
-	int128_t fullExecEndowTimesPrice = fullExecStats.cumulativeOfferedForSaleTimesPrice;
-	int128_t partialExecEndowTimesPrice = partialExecStats.cumulativeOfferedForSaleTimesPrice - fullExecEndowTimesPrice;
+	int128_t fullExecEndowTimesPrice = fullExecCumulativeOfferedTimesPrice;
+	int128_t partialExecEndowTimesPrice = partialExecCumulativeOfferedTimesPrice - fullExecEndowTimesPrice;
 
 	int128_t partialAmountTimesSellPrice = ((int128_t) partialExecEndow) * ((int128_t) sellPrice);
 
@@ -1,11 +1,16 @@
 #include "speedex/IOCOrderbookManager.h"
 
+#include <algorithm>
+
+#include "ledger/BalanceDeltaAccumulator.h"
 #include "ledger/LedgerTxn.h"
 #include "speedex/OrderbookClearingTarget.h"
 #include "speedex/LiquidityPoolFrame.h"
 
 #include "transactions/TransactionUtils.h"
 
+#include "util/Logging.h"
+#include "util/Thread.h"
 #include "util/types.h"
 #include "util/XDROperators.h"
 #include "speedex/DemandUtils.h"
@@ -37,11 +42,12 @@ IOCOrderbookManager::throwIfAlreadyCleared() const
 }
 
 void
-IOCOrderbookManager::doPriceComputationPreprocessing() {
+IOCOrderbookManager::doPriceComputationPreprocessing(AssetIndex const& assetIndex) {
 	for (auto & [_, orderbook] : mOrderbooks)
 	{
 		orderbook.doPriceComputationPreprocessing();
 	}
+	mDemandKernel.build(mOrderbooks, assetIndex);
 }
 
 
@@ -60,8 +66,17 @@ IOCOrderbookManager::numOpenOrderbooks() const {
 	return mOrderbooks.size();
 }
 
+size_t
+IOCOrderbookManager::numOffers() const {
+	size_t out = 0;
+	for (auto const& [_, orderbook] : mOrderbooks) {
+		out += orderbook.numOffers();
+	}
+	return out;
+}
+
 void
-IOCOrderbookManager::commitChild(const IOCOrderbookManager& child) {
+IOCOrderbookManager::commitChild(IOCOrderbookManager& child) {
 	
 	if (numOpenOrderbooks() > 0)
 	{
@@ -70,7 +85,7 @@ IOCOrderbookManager::commitChild(const IOCOrderbookManager& child) {
 
 	if (child.numOpenOrderbooks() > 0) {
 		throwIfSealed();
-		for (const auto& orderbook : child.mOrderbooks) {
+		for (auto& orderbook : child.mOrderbooks) {
 			getOrCreateOrderbook(orderbook.first).commitChild(orderbook.second);
 		}
 	}
@@ -85,26 +100,58 @@ IOCOrderbookManager::addOffer(AssetPair const& assetPair, IOCOffer const& offer)
 void
 IOCOrderbookManager::clear() { // no offer unwinding here b/c only called when ltx rollsback
 	mOrderbooks.clear();
+	mDemandKernel.clear();
 }
 
 
-std::pair<std::vector<SpeedexOfferClearingStatus>, std::optional<SpeedexLiquidityPoolClearingStatus>>
-IOCOrderbookManager::clearOrderbook(AbstractLedgerTxn& ltx, OrderbookClearingTarget& target, LiquidityPoolFrame& lpFrame) {
-	auto assetPair = target.getAssetPair();
-	return getOrCreateOrderbook(assetPair).clearOffers(ltx, target, lpFrame);
+std::vector<IOCOrderbook::OrderbookFills>
+IOCOrderbookManager::computeFills(std::vector<OrderbookClearingTarget>& targets) {
+
+	// getOrCreateOrderbook() can modify mOrderbooks, so look up every book first
+	std::vector<IOCOrderbook const*> orderbooks;
+	for (auto const& target : targets) {
+		orderbooks.push_back(&getOrCreateOrderbook(target.getAssetPair()));
+	}
+
+	std::vector<IOCOrderbook::OrderbookFills> fills(targets.size());
+
+	parallelFor(targets.size(), targets.size(), [&orderbooks, &targets, &fills] (size_t i) {
+		fills[i] = orderbooks[i]->computeFills(targets[i]);
+	});
+	return fills;
 }
 
 void
-IOCOrderbookManager::sealBatch() {
+IOCOrderbookManager::sealBatch(AssetIndex const& assetIndex) {
 	throwIfSealed();
 	mSealed = true;
-	doPriceComputationPreprocessing();
+	mAssetIndex = assetIndex;
+	doPriceComputationPreprocessing(*mAssetIndex);
+}
+
+void
+IOCOrderbookManager::sealBatch() {
+	std::vector<Asset> assets;
+	for (auto const& [tradingPair, _] : mOrderbooks)
+	{
+		assets.push_back(tradingPair.selling);
+		assets.push_back(tradingPair.buying);
+	}
+	std::sort(assets.begin(), assets.end());
+	assets.erase(std::unique(assets.begin(), assets.end()), assets.end());
+
+	sealBatch(AssetIndex(assets));
+}
+
+AssetIndex const&
+IOCOrderbookManager::getAssetIndex() const {
+	throwIfNotSealed();
+	return *mAssetIndex;
 }
 
 void IOCOrderbookManager::returnToSource(AbstractLedgerTxn& ltx, Asset asset, int64_t amount) {
 
-	auto str = assetToString(asset);
-	std::printf("Returning %lld units of %s\n", amount, str.c_str());
+	CLOG_TRACE(Speedex, "returning {} units of {}", amount, assetToString(asset));
 	if (asset.type() == ASSET_TYPE_NATIVE) {
 		auto header = ltx.loadHeader();
 		header.current().feePool += amount;
@@ -127,8 +174,25 @@ void IOCOrderbookManager::returnToSource(AbstractLedgerTxn& ltx, Asset asset, in
 	}
 }
 
+void
+IOCOrderbookManager::insertKeysForClearing(UnorderedSet<LedgerKey>& keys) const
+{
+	throwIfNotSealed();
+
+	for (auto const& [tradingPair, orderbook] : mOrderbooks) {
+		orderbook.insertKeysForClearing(keys);
+	}
+
+	// returnToSource() credits unsold amounts to the issuers
+	for (auto const& asset : mAssetIndex->getAssets()) {
+		if (asset.type() != ASSET_TYPE_NATIVE) {
+			keys.emplace(accountKey(getIssuer(asset)));
+		}
+	}
+}
+
 SpeedexResults 
-IOCOrderbookManager::clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& solution, LiquidityPoolSetFrame& liquidityPools) {
+IOCOrderbookManager::clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& solution, LiquidityPoolSetFrame& liquidityPools, int64_t* roundingErrorReturned) {
 	throwIfNotSealed();
 	throwIfAlreadyCleared();
 
@@ -147,9 +211,20 @@ IOCOrderbookManager::clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& sol
 		target.print();
 	}
 
-	for (auto& target : orderbookTargets) {
+	// Fills are computed in parallel, then applied serially,
+	// in the (deterministic) order of orderbookTargets.
+	auto fills = computeFills(orderbookTargets);
+
+	// Traders with many offers would otherwise have their trustlines
+	// loaded and stored once per offer.  Only each trustline's net change
+	// is checked against its limit, so an offer's credit can't fail on its
+	// own while the trader's other offers debit the same trustline.
+	BalanceDeltaAccumulator balances;
+
+	for (size_t i = 0; i < orderbookTargets.size(); i++) {
+		auto const& target = orderbookTargets[i];
 		auto& lpFrame = liquidityPools.getFrame(target.getAssetPair());
-		auto [offerResults, lpResults] = clearOrderbook(ltx, target, lpFrame);
+		auto [offerResults, lpResults] = getOrCreateOrderbook(target.getAssetPair()).applyFills(balances, target, fills[i], lpFrame);
 		results.offerStatuses.insert(
 			results.offerStatuses.end(),
 			offerResults.begin(),
@@ -157,6 +232,8 @@ IOCOrderbookManager::clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& sol
 		if (lpResults)
 			results.lpStatuses.push_back(*lpResults);
 	}
+	balances.apply(ltx);
+
 	UnorderedMap<Asset, int64_t> roundingErrors;
 
 	for (auto& [_, orderbook] : mOrderbooks) {
@@ -165,25 +242,28 @@ IOCOrderbookManager::clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& sol
 	for (auto& target : orderbookTargets) {
 		auto assetPair = target.getAssetPair();
 
-		auto sellStr = assetToString(assetPair.selling);
-		auto buyStr = assetToString(assetPair.buying);
-
-		std::printf("realized sell %s %lld buy %s %lld\n", 
-			sellStr.c_str(),
+		CLOG_TRACE(Speedex, "realized sell {} {} buy {} {}",
+			assetToString(assetPair.selling),
 			target.getRealizedSellAmount(),
-			buyStr.c_str(),
+			assetToString(assetPair.buying),
 			target.getRealizedBuyAmount());
 		roundingErrors[assetPair.selling] += target.getRealizedSellAmount();
 		roundingErrors[assetPair.buying] -= target.getRealizedBuyAmount();
 	}
 
+	int128_t totalReturned = 0;
 	for (auto& [asset, roundingError] : roundingErrors) {
 		if (roundingError < 0) {
 			throw std::runtime_error("market paid out more than it received!");
 		}
 		returnToSource(ltx, asset, roundingError);
+		totalReturned += roundingError;
+	}
+	if (roundingErrorReturned) {
+		*roundingErrorReturned = std::min<int128_t>(totalReturned, INT64_MAX);
 	}
 	mOrderbooks.clear();
+	mDemandKernel.clear();
 	mCleared = true;
 
 	//One would sort the results here, if we wanted to hash them.
@@ -191,37 +271,79 @@ IOCOrderbookManager::clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& sol
 	return results;
 }
 
-void 
-IOCOrderbookManager::demandQuery(
-	std::map<Asset, uint64_t> const& prices, 
-	SupplyDemand& supplyDemand,
-	uint8_t smoothMult) const
-{
-	for (auto const& [assetPair, orderbook] : mOrderbooks)
-	{
-		auto sellPrice = prices.at(assetPair.selling);
-		auto buyPrice = prices.at(assetPair.buying);
+SpeedexResults
+IOCOrderbookManager::clearSimBatch(const BatchSolution& solution, LiquidityPoolSetFrame& liquidityPools) {
+	throwIfNotSealed();
+	throwIfAlreadyCleared();
 
-		auto tradeAmount = orderbook.cumulativeOfferedForSaleTimesPrice(sellPrice, buyPrice, smoothMult);
+	SpeedexResults results;
 
-		//std::printf("ob sell %s buy %s: %lf\n", 
-		//	assetToString(assetPair.selling).c_str(),
-		//	assetToString(assetPair.buying).c_str(),
-		//	(double) tradeAmount);
+	auto valuations = solution.getValuationResults();
+	results.valuations.insert(
+		results.valuations.end(),
+		valuations.begin(),
+		valuations.end());
 
+	auto orderbookTargets = solution.produceClearingTargets();
 
-		supplyDemand.addSupplyDemand(assetPair, tradeAmount);
+	auto fills = computeFills(orderbookTargets);
+
+	// Offers have no accounts to pay out to, so only pools are modified.
+	for (size_t i = 0; i < orderbookTargets.size(); i++) {
+		auto const& target = orderbookTargets[i];
+		auto const& assetPair = target.getAssetPair();
+		for (auto const& [offer, fill] : fills[i].mOfferFills) {
+			results.offerStatuses.push_back(
+				offer->getClearingStatus(fill.mSellAmount, fill.mBuyAmount, assetPair));
+		}
+		if (fills[i].mLiquidityPoolFill) {
+			auto& lpFrame = liquidityPools.getFrame(assetPair);
+			results.lpStatuses.push_back(
+				target.applyLiquidityPoolFill(lpFrame, *fills[i].mLiquidityPoolFill));
+		}
+	}
+
+	UnorderedMap<Asset, int64_t> roundingErrors;
+	for (auto const& target : orderbookTargets) {
+		auto assetPair = target.getAssetPair();
+		roundingErrors[assetPair.selling] += target.getRealizedSellAmount();
+		roundingErrors[assetPair.buying] -= target.getRealizedBuyAmount();
+	}
+	for (auto const& [_, roundingError] : roundingErrors) {
+		if (roundingError < 0) {
+			throw std::runtime_error("market paid out more than it received!");
+		}
 	}
+
+	mOrderbooks.clear();
+	mDemandKernel.clear();
+	mCleared = true;
+
+	return results;
+}
+
+void 
+IOCOrderbookManager::demandQuery(
+	PriceVector const& prices, 
+	SupplyDemand& supplyDemand,
+	uint8_t smoothMult) const
+{
+	throwIfNotSealed();
+	mDemandKernel.demandQuery(prices, supplyDemand, smoothMult);
 }
 
 IOCOrderbookManager::int128_t 
-IOCOrderbookManager::demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const
+IOCOrderbookManager::demandQueryOneAssetPair(uint32_t sellIdx, uint32_t buyIdx, PriceVector const& prices, uint8_t smoothMult) const
 {
-	auto iter = mOrderbooks.find(tradingPair);
-	if (iter == mOrderbooks.end()) {
-		return 0;
-	}
-	return iter->second.cumulativeOfferedForSaleTimesPrice(prices.at(tradingPair.selling), prices.at(tradingPair.buying), 0);
+	throwIfNotSealed();
+	return mDemandKernel.demandQueryOneAssetPair(sellIdx, buyIdx, prices, smoothMult);
+}
+
+bool
+IOCOrderbookManager::hasOrderbook(uint32_t sellIdx, uint32_t buyIdx) const
+{
+	throwIfNotSealed();
+	return mDemandKernel.hasOrderbook(sellIdx, buyIdx);
 }
 
 } /* stellar */
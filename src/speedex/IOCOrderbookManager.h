@@ -4,6 +4,8 @@
 
 #include "speedex/IOCOrderbook.h"
 #include "speedex/BatchSolution.h"
+#include "speedex/OrderbookDemandKernel.h"
+#include "speedex/PriceVector.h"
 
 #include "util/UnorderedMap.h"
 #include <map>
@@ -24,11 +26,19 @@ class IOCOrderbookManager {
 
 	UnorderedMap<AssetPair, IOCOrderbook, AssetPairHash> mOrderbooks;
 
+	// set in sealBatch()
+	std::optional<AssetIndex> mAssetIndex;
+
+	// built in sealBatch(), serves demandQuery()
+	OrderbookDemandKernel mDemandKernel;
+
 	bool mSealed;
 	bool mCleared;
 
-	std::pair<std::vector<SpeedexOfferClearingStatus>, std::optional<SpeedexLiquidityPoolClearingStatus>>
- 	clearOrderbook(AbstractLedgerTxn& ltx, OrderbookClearingTarget& target, LiquidityPoolFrame& lpFrame);
+	// fills[i] = the fills of the orderbook of targets[i].  Orderbooks are
+	// independent, so this is spread across threads with parallelFor().
+	std::vector<IOCOrderbook::OrderbookFills>
+	computeFills(std::vector<OrderbookClearingTarget>& targets);
 
 	void throwIfSealed() const;
 	void throwIfNotSealed() const;
@@ -40,7 +50,7 @@ class IOCOrderbookManager {
  
 	void returnToSource(AbstractLedgerTxn& ltx, Asset asset, int64_t amount);
 
-	void doPriceComputationPreprocessing();
+	void doPriceComputationPreprocessing(AssetIndex const& assetIndex);
 
 public:
 
@@ -48,26 +58,48 @@ public:
 
 	void addOffer(AssetPair const& assetPair, IOCOffer const& offer);
 
-	void commitChild(const IOCOrderbookManager& child);
+	// Moves child's offers into this manager, leaving child's orderbooks empty.
+	void commitChild(IOCOrderbookManager& child);
 
 	void clear();
 
+	// Numbers assets as in assetIndex, which must include every traded asset.
+	void sealBatch(AssetIndex const& assetIndex);
+
+	// Numbers the traded assets in sorted order.
 	void sealBatch();
 
+	// throws if not sealed
+	AssetIndex const& getAssetIndex() const;
+
+	// Inserts the keys of the entries clearBatch() loads, other than
+	// liquidity pools (see LiquidityPoolSetFrame::insertKeysForPools).
+	// Throws if not sealed.
+	void insertKeysForClearing(UnorderedSet<LedgerKey>& keys) const;
+
+	// If given, roundingErrorReturned is set to the total amount (summed
+	// across assets, in each asset's own units) returned to issuers.
 	SpeedexResults
-	clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& batchSolution, LiquidityPoolSetFrame& liquidityPools);
+	clearBatch(AbstractLedgerTxn& ltx, const BatchSolution& batchSolution, LiquidityPoolSetFrame& liquidityPools, int64_t* roundingErrorReturned = nullptr);
 
 	size_t numOpenOrderbooks() const;
 
+	size_t numOffers() const;
+
+	// prices and supplyDemand are indexed by getAssetIndex()
 	void demandQuery(
-		std::map<Asset, uint64_t> const& prices, 
+		PriceVector const& prices, 
 		SupplyDemand& supplyDemand,
 		uint8_t smoothMult) const;
 
 	int128_t 
 	demandQueryOneAssetPair(
-		AssetPair const& tradingPair, 
-		std::map<Asset, uint64_t> const& prices) const; //smooth mult = 0
+		uint32_t sellIdx,
+		uint32_t buyIdx,
+		PriceVector const& prices,
+		uint8_t smoothMult) const;
+
+	bool hasOrderbook(uint32_t sellIdx, uint32_t buyIdx) const;
 
 	SpeedexResults
 	clearSimBatch(const BatchSolution& batchSolution, LiquidityPoolSetFrame& liquidityPools);
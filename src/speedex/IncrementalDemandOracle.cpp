@@ -0,0 +1,125 @@
+#include "speedex/IncrementalDemandOracle.h"
+
+#include "speedex/DemandOracle.h"
+
+#include <stdexcept>
+
+namespace stellar
+{
+
+IncrementalDemandOracle::IncrementalDemandOracle(DemandOracle const& demandOracle, uint8_t smoothMult)
+	: mDemandOracle(demandOracle)
+	, mSmoothMult(smoothMult)
+	, mPairs(demandOracle.getActivePairs())
+	, mPairsByAsset(demandOracle.getAssetIndex().size())
+	, mContributions(mPairs.size(), 0)
+	, mPairEpoch(mPairs.size(), 0)
+	, mPrices(demandOracle.getAssetIndex().size())
+	, mSupplyDemand(demandOracle.getAssetIndex())
+	, mTrialPrices(demandOracle.getAssetIndex().size())
+	{
+		for (uint32_t i = 0; i < mPairs.size(); i++)
+		{
+			mPairsByAsset[mPairs[i].first].push_back(i);
+			mPairsByAsset[mPairs[i].second].push_back(i);
+		}
+		mUndoLog.reserve(mPairs.size());
+		mChangedAssets.reserve(mPrices.size());
+	}
+
+void
+IncrementalDemandOracle::setContribution(uint32_t pairIdx, int128_t contribution)
+{
+	auto const& [sellIdx, buyIdx] = mPairs[pairIdx];
+	mSupplyDemand.addSupplyDemand(sellIdx, buyIdx, contribution - mContributions[pairIdx]);
+	mContributions[pairIdx] = contribution;
+}
+
+void
+IncrementalDemandOracle::reset(PriceVector const& prices)
+{
+	mPrices = prices;
+	mSupplyDemand.reset();
+	for (uint32_t i = 0; i < mPairs.size(); i++)
+	{
+		auto const& [sellIdx, buyIdx] = mPairs[i];
+		mContributions[i] = mDemandOracle.demandQueryOneAssetPair(sellIdx, buyIdx, mPrices, mSmoothMult);
+		mSupplyDemand.addSupplyDemand(sellIdx, buyIdx, mContributions[i]);
+	}
+	mUndoLog.clear();
+	mChangedAssets.clear();
+	mTrialPending = false;
+}
+
+SupplyDemand const&
+IncrementalDemandOracle::trialQuery(PriceVector const& trialPrices)
+{
+	if (mTrialPending)
+	{
+		throw std::runtime_error("trialQuery with a trial already pending");
+	}
+	mTrialPending = true;
+	mUndoLog.clear();
+	mChangedAssets.clear();
+	mEpoch++;
+
+	for (uint32_t i = 0; i < mPrices.size(); i++)
+	{
+		if (mPrices[i] != trialPrices[i])
+		{
+			mChangedAssets.push_back(i);
+		}
+	}
+
+	mTrialPrices = trialPrices;
+
+	for (auto assetIdx : mChangedAssets)
+	{
+		for (auto pairIdx : mPairsByAsset[assetIdx])
+		{
+			if (mPairEpoch[pairIdx] == mEpoch)
+			{
+				continue;
+			}
+			mPairEpoch[pairIdx] = mEpoch;
+
+			auto const& [sellIdx, buyIdx] = mPairs[pairIdx];
+			mUndoLog.push_back(UndoEntry{
+				.mPairIdx = pairIdx,
+				.mContribution = mContributions[pairIdx]
+			});
+			setContribution(pairIdx, mDemandOracle.demandQueryOneAssetPair(sellIdx, buyIdx, mTrialPrices, mSmoothMult));
+		}
+	}
+	return mSupplyDemand;
+}
+
+void
+IncrementalDemandOracle::accept()
+{
+	if (!mTrialPending)
+	{
+		throw std::runtime_error("accept without a pending trial");
+	}
+	for (auto assetIdx : mChangedAssets)
+	{
+		mPrices[assetIdx] = mTrialPrices[assetIdx];
+	}
+	mTrialPending = false;
+}
+
+void
+IncrementalDemandOracle::reject()
+{
+	if (!mTrialPending)
+	{
+		throw std::runtime_error("reject without a pending trial");
+	}
+	for (auto const& entry : mUndoLog)
+	{
+		setContribution(entry.mPairIdx, entry.mContribution);
+	}
+	mTrialPending = false;
+}
+
+} /* stellar */
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "speedex/DemandUtils.h"
+#include "speedex/PriceVector.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace stellar
+{
+
+class DemandOracle;
+
+/*
+ Caches each asset pair's contribution to SupplyDemand, so that
+ a query at a trial price vector only re-evaluates pairs where
+ the price of the selling or buying asset differs from the
+ last accepted price vector.
+
+ Usage, once per tatonnement round:
+ 	trialQuery(trialPrices), then exactly one of accept() or reject().
+
+ Contributions are exact int128 sums, so the cached result is
+ always equal to a full DemandOracle::demandQuery at the same prices.
+*/
+class IncrementalDemandOracle {
+
+	using int128_t = __int128;
+
+	DemandOracle const& mDemandOracle;
+	const uint8_t mSmoothMult;
+
+	// copy of mDemandOracle.getActivePairs()
+	std::vector<std::pair<uint32_t, uint32_t>> mPairs;
+
+	// indices into mPairs of each pair that sells or buys asset i
+	std::vector<std::vector<uint32_t>> mPairsByAsset;
+
+	std::vector<int128_t> mContributions;
+
+	// mPairEpoch[p] == mEpoch iff pair p was already recomputed this trial
+	std::vector<uint64_t> mPairEpoch;
+	uint64_t mEpoch = 0;
+
+	// prices at which mContributions were last accepted
+	PriceVector mPrices;
+
+	// reflects the pending trial, if there is one
+	SupplyDemand mSupplyDemand;
+
+	struct UndoEntry
+	{
+		uint32_t mPairIdx;
+		int128_t mContribution;
+	};
+
+	std::vector<UndoEntry> mUndoLog;
+	std::vector<uint32_t> mChangedAssets;
+	PriceVector mTrialPrices;
+	bool mTrialPending = false;
+
+	void setContribution(uint32_t pairIdx, int128_t contribution);
+
+public:
+
+	IncrementalDemandOracle(DemandOracle const& demandOracle, uint8_t smoothMult);
+
+	// full recompute; discards any pending trial
+	void reset(PriceVector const& prices);
+
+	// Only recomputes pairs touching an asset whose price changed.
+	// The result stays valid until the next accept(), reject(), or reset().
+	SupplyDemand const& trialQuery(PriceVector const& trialPrices);
+
+	void accept();
+	void reject();
+
+	// demand at the last accepted prices, or at the pending trial prices
+	SupplyDemand const& getSupplyDemand() const {
+		return mSupplyDemand;
+	}
+
+	// number of pairs recomputed by the last trialQuery()
+	size_t numRecomputedPairs() const {
+		return mUndoLog.size();
+	}
+};
+
+} /* stellar */
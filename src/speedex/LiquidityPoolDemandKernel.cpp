@@ -0,0 +1,191 @@
+#include "speedex/LiquidityPoolDemandKernel.h"
+
+#include "speedex/DemandUtils.h"
+#include "speedex/LiquidityPoolSetFrame.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace stellar {
+
+namespace {
+
+using uint128_t = unsigned __int128;
+
+// floor(sqrt(a * b)), exactly.  The floating point estimate only seeds
+// one Newton step; the result is then corrected with integer comparisons,
+// so it never depends on how the platform rounds.
+uint64_t
+sqrtFloor(uint64_t a, uint64_t b)
+{
+	uint128_t prod = ((uint128_t) a) * ((uint128_t) b);
+	if (prod == 0) {
+		return 0;
+	}
+
+	long double estimate = std::sqrt((long double) prod);
+	uint128_t x = estimate >= 18446744073709551615.0L 
+		? std::numeric_limits<uint64_t>::max() 
+		: std::max<uint64_t>(1, (uint64_t) estimate);
+
+	// floor((x + floor(prod / x)) / 2) >= floor(sqrt(prod)), for any x > 0
+	x = (x + prod / x) / 2;
+	if (x > std::numeric_limits<uint64_t>::max()) {
+		x = std::numeric_limits<uint64_t>::max();
+	}
+
+	while (x * x > prod) {
+		x--;
+	}
+	while (x < std::numeric_limits<uint64_t>::max() && (x + 1) * (x + 1) <= prod) {
+		x++;
+	}
+	return (uint64_t) x;
+}
+
+// ceil(sqrt(a * b)), exactly.
+uint64_t
+sqrtCeil(uint64_t a, uint64_t b)
+{
+	uint64_t x = sqrtFloor(a, b);
+	if (((uint128_t) x) * ((uint128_t) x) == ((uint128_t) a) * ((uint128_t) b)) {
+		return x;
+	}
+	return x + 1;
+}
+
+} /* anonymous namespace */
+
+LiquidityPoolDemandKernel::PoolParams
+LiquidityPoolDemandKernel::makePoolParams(int64_t sellReserve, int64_t buyReserve, uint32_t fee)
+{
+	PoolParams out {
+		.mSellReserve = (uint64_t) std::max<int64_t>(sellReserve, 0),
+		.mBuyReserve = (uint64_t) std::max<int64_t>(buyReserve, 0),
+		.mSellReserveAfterFee = 0,
+		.mSqrtSellTimesSellAfterFee = 0
+	};
+
+	uint64_t tax = (((uint128_t) out.mSellReserve) * fee) / 10000;
+	if (tax < out.mSellReserve) {
+		out.mSellReserveAfterFee = out.mSellReserve - tax;
+	}
+
+	out.mSqrtSellTimesSellAfterFee = sqrtFloor(out.mSellReserve, out.mSellReserveAfterFee);
+	return out;
+}
+
+LiquidityPoolDemandKernel::int128_t
+LiquidityPoolDemandKernel::offeredForSaleTimesSellPrice(PoolParams const& params, uint64_t sellPrice, uint64_t buyPrice)
+{
+	if (params.mSellReserve == 0 || params.mSellReserveAfterFee == 0) {
+		return 0;
+	}
+
+	// sellPrice / buyPrice < mBuyReserve / mSellReserveAfterFee
+	if (((uint128_t) sellPrice) * params.mSellReserveAfterFee < ((uint128_t) params.mBuyReserve) * buyPrice) {
+		return 0;
+	}
+
+	// Rounding the first term down and the second up underestimates what
+	// the pool offers, which is safe.
+	uint128_t top = ((uint128_t) sellPrice) * params.mSqrtSellTimesSellAfterFee;
+	uint128_t bot = ((uint128_t) sqrtCeil(params.mBuyReserve, buyPrice)) 
+		* sqrtCeil(params.mSellReserve, sellPrice);
+
+	if (top <= bot) {
+		return 0;
+	}
+
+	uint128_t total = top - bot;
+
+	constexpr uint128_t INT128_MAX = (((uint128_t)1) << 127) - 1;
+	if (total > INT128_MAX) {
+		total = INT128_MAX;
+	}
+
+	// The pool can only sell an integral amount, so it really offers
+	// floor(amount) * price.
+	total -= total % sellPrice;
+	return total;
+}
+
+void
+LiquidityPoolDemandKernel::clear()
+{
+	mNumAssets = 0;
+	mPoolIdxByPair.clear();
+	mSellAssetIdx.clear();
+	mBuyAssetIdx.clear();
+	mParams.clear();
+}
+
+void
+LiquidityPoolDemandKernel::build(LiquidityPoolSetFrame const& liquidityPools, AssetIndex const& assetIndex)
+{
+	clear();
+
+	mNumAssets = assetIndex.size();
+
+	// UnorderedMap iteration order is randomized, so sort everything first.
+	std::vector<std::pair<std::pair<uint32_t, uint32_t>, LiquidityPoolFrame const*>> pools;
+	for (auto const& [tradingPair, lpFrame] : liquidityPools.getFrames())
+	{
+		if (!lpFrame) {
+			continue;
+		}
+		pools.push_back({
+			{assetIndex.getIndex(tradingPair.selling), assetIndex.getIndex(tradingPair.buying)},
+			&lpFrame});
+	}
+
+	std::sort(pools.begin(), pools.end(), [] (auto const& a, auto const& b) {
+		return a.first < b.first;
+	});
+
+	mPoolIdxByPair.resize(mNumAssets * mNumAssets, -1);
+
+	for (auto const& [idxs, lpFrame] : pools)
+	{
+		auto const& [sellIdx, buyIdx] = idxs;
+
+		mPoolIdxByPair[sellIdx * mNumAssets + buyIdx] = mParams.size();
+		mSellAssetIdx.push_back(sellIdx);
+		mBuyAssetIdx.push_back(buyIdx);
+
+		auto [sellReserve, buyReserve] = lpFrame->getSellBuyAmounts();
+		mParams.push_back(makePoolParams(sellReserve, buyReserve, lpFrame->getFixedPointFeeRate()));
+	}
+}
+
+void
+LiquidityPoolDemandKernel::demandQuery(PriceVector const& prices, SupplyDemand& supplyDemand) const
+{
+	const size_t numPools = mParams.size();
+	for (size_t i = 0; i < numPools; i++)
+	{
+		auto sellIdx = mSellAssetIdx[i];
+		auto buyIdx = mBuyAssetIdx[i];
+
+		supplyDemand.addSupplyDemand(sellIdx, buyIdx, 
+			offeredForSaleTimesSellPrice(mParams[i], prices[sellIdx], prices[buyIdx]));
+	}
+}
+
+LiquidityPoolDemandKernel::int128_t
+LiquidityPoolDemandKernel::demandQueryOneAssetPair(uint32_t sellIdx, uint32_t buyIdx, PriceVector const& prices) const
+{
+	if (mPoolIdxByPair.empty())
+	{
+		return 0;
+	}
+	auto poolIdx = mPoolIdxByPair[sellIdx * mNumAssets + buyIdx];
+	if (poolIdx < 0)
+	{
+		return 0;
+	}
+	return offeredForSaleTimesSellPrice(mParams[poolIdx], prices[sellIdx], prices[buyIdx]);
+}
+
+} /* stellar */
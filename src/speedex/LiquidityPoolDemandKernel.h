@@ -0,0 +1,90 @@
+#pragma once
+
+#include "speedex/PriceVector.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace stellar {
+
+class LiquidityPoolSetFrame;
+struct SupplyDemand;
+
+/*
+ Flat copy of every liquidity pool's reserves and fee, taken once per
+ batch, for the tatonnement demand queries.
+
+ A constant product pool trading sell for buy, with reserves S and B and
+ fee f, offers (times the sell price p_s, against buy price p_b)
+
+	p_s * sqrt(S * S(1-f)) - sqrt(S * p_s * B * p_b)
+
+ once p_s / p_b exceeds its minimum price B / (S(1-f)).  The first
+ square root depends only on the pool, so it is computed here once, and
+ a query only needs the other two.  All arithmetic is integer, so results
+ do not depend on the platform's floating point.
+
+ Reserves are a snapshot; the kernel must be rebuilt if the pools change.
+*/
+class LiquidityPoolDemandKernel {
+
+	using int128_t = __int128_t;
+
+public:
+
+	struct PoolParams {
+		uint64_t mSellReserve;
+		uint64_t mBuyReserve;
+		// sell reserve, less the fee
+		uint64_t mSellReserveAfterFee;
+		// floor(sqrt(mSellReserve * mSellReserveAfterFee))
+		uint64_t mSqrtSellTimesSellAfterFee;
+	};
+
+	// fee is in basis points
+	static PoolParams makePoolParams(int64_t sellReserve, int64_t buyReserve, uint32_t fee);
+
+	// Amount offered for sale, times the sell price, rounded down to a
+	// multiple of the sell price.  Rounds against the pool throughout.
+	static int128_t offeredForSaleTimesSellPrice(PoolParams const& params, uint64_t sellPrice, uint64_t buyPrice);
+
+private:
+
+	size_t mNumAssets = 0;
+
+	// mPoolIdxByPair[sell * mNumAssets + buy] is the index of the pool
+	// selling sell for buy, or -1 if there is none.
+	std::vector<int32_t> mPoolIdxByPair;
+
+	// per (pool, direction), sorted by (sell, buy)
+	std::vector<uint32_t> mSellAssetIdx;
+	std::vector<uint32_t> mBuyAssetIdx;
+	std::vector<PoolParams> mParams;
+
+public:
+
+	LiquidityPoolDemandKernel() = default;
+
+	// Skips pools that don't exist.  Throws if a pool trades an asset
+	// that assetIndex does not know.
+	void build(LiquidityPoolSetFrame const& liquidityPools, AssetIndex const& assetIndex);
+
+	void clear();
+
+	size_t numPools() const {
+		return mParams.size();
+	}
+
+	bool hasPool(uint32_t sellIdx, uint32_t buyIdx) const {
+		return !mPoolIdxByPair.empty() && mPoolIdxByPair[sellIdx * mNumAssets + buyIdx] >= 0;
+	}
+
+	// Adds each pool's supply and demand to supplyDemand.
+	void demandQuery(PriceVector const& prices, SupplyDemand& supplyDemand) const;
+
+	// returns 0 if there is no pool for the pair.
+	int128_t
+	demandQueryOneAssetPair(uint32_t sellIdx, uint32_t buyIdx, PriceVector const& prices) const;
+};
+
+} /* stellar */
@@ -1,14 +1,15 @@
 #include "speedex/LiquidityPoolFrame.h"
 #include "speedex/LiquidityPoolFrameBase.h"
+#include "speedex/LiquidityPoolDemandKernel.h"
 
 #include "ledger/LedgerTxn.h"
 
 #include "transactions/TransactionUtils.h"
 
-#include <cmath>
 #include <stdexcept>
 #include <utility>
 
+#include "util/Logging.h"
 #include "util/numeric.h"
 
 namespace stellar {
@@ -41,14 +42,6 @@ LiquidityPoolFrame::getSellBuyAmounts() const {
 	}
 }
 
-double
-LiquidityPoolFrame::getFeeRate() const {
-	if (!mBaseFrame) {
-		return 0.0;
-	}
-	return (((double) mBaseFrame.getFee()) / (10000.0));
-}
-
 uint32_t
 LiquidityPoolFrame::getFixedPointFeeRate() const {
 	if (!mBaseFrame) {
@@ -73,13 +66,6 @@ LiquidityPoolFrame::subtractFeeRateFixedPoint(uint64_t startingPrice) const
 	return startingPrice - tax;
 }
 
-double
-LiquidityPoolFrame::getMinPriceRatio() const {
-	auto [sellAmount, buyAmount] = getSellBuyAmounts();
-	double feeRate = getFeeRate();
-	return (((double) buyAmount) / ((double) sellAmount)) * (1.0 / (1.0 -  feeRate));
-}
-
 //returns fraction n/d
 std::pair<uint64_t, uint64_t>
 LiquidityPoolFrame::getMinPriceRatioFixedPoint() const {
@@ -95,136 +81,16 @@ LiquidityPoolFrame::amountOfferedForSaleTimesSellPrice(uint64_t sellPrice, uint6
 {
 	auto [sellAmount, buyAmount] = getSellBuyAmounts(); // reserves
 
-	using uint128_t = unsigned __int128;
-
-	if (sellAmount == 0) {
-		return 0;
-	}
-
-	auto [priceN, priceD] = getMinPriceRatioFixedPoint();
-	if (priceD == 0) {
-		return 0;
-	}
-
-	auto priceLT = [] (uint64_t p1n, uint64_t p1d, uint64_t p2n, uint64_t p2d) -> bool
-	{
-		// p1n/p1d <? p2n/p2d
-		return ((uint128_t) p1n) * ((uint128_t) p2d) < ((uint128_t) p2n) * ((uint128_t) p1d);
-	};
-
-	if (priceLT(sellPrice, buyPrice, priceN, priceD)) {
-		return 0;
-	}
-
-	/*
-
-	output trade amounts (not sellprice weighted):
-
-	K = product of reserves (sellAmount * buyAmount)
-
-	sqrt(K) * (1/sqrt(minRatio) - 1/sqrt(offeredRatio))
-
-	but K = sellAmount * buyAmount, and minratio = buyAmount / (sellAmount (1-fee))
-
-	so we get 
-	sqrt((sell * buy) * (sell(1-fee)) / buy)
-	= sell * sqrt(1-fee)
-	= sqrt(sell * sell * (1-fee))
-	= sqrt(sellAmount * priceD)
-
-	all told, we get
-
-	sqrt(sell * priceD) - sqrt(sellAmount * buyAmount / (sellPrice / buyPrice))
-
-	Multiplying by sellPrice gives
-
-	sellPrice * sqrt(sellAmount * priceD) - sqrt(sellAmount * sellPrice * buyAmount * buyPrice);
-	
-	*/
-
-	constexpr auto sqrt = [](uint64_t a, uint64_t b) -> uint64_t {
-		// return bigSquareRoot(a, b)
-		return (uint64_t) std::ceil(std::pow(((double)a) * ((double) b), 0.5));
-	};
-
-	constexpr auto hackyBigSquareRootRoundDown = [=] (uint64_t a, uint64_t b) -> uint64_t {
-		uint64_t sqrtRoundUp = sqrt(a, b);
-		uint128_t prod = ((uint128_t) a) * ((uint128_t) b);
-		uint128_t prodRoundUp = ((uint128_t) sqrtRoundUp) * ((uint128_t) sqrtRoundUp);
-		if (prod == prodRoundUp) {
-			return sqrtRoundUp;
-		}
-		return sqrtRoundUp - 1;
-	};
-
-	constexpr auto hackyBigSquareRootRoundUp = [=] (uint64_t a, uint64_t b) -> uint64_t {
-		return sqrt(a,b);
-	};
-
-	// Rounding in this manner underestimates available trade amounts, but this is ok.
-	// Better to underestimate than overestimate.
-	uint64_t firstTerm = hackyBigSquareRootRoundDown(sellAmount, priceD);
-	//std::printf("firstTerm: %llu\n", firstTerm);
-
-	uint64_t secondTermA = hackyBigSquareRootRoundUp(buyAmount, buyPrice);
-	uint64_t secondTermB = hackyBigSquareRootRoundUp(sellAmount, sellPrice);
-
-	//std::printf("secondTermA %llu secondTermB %llu\n", secondTermA, secondTermB);
-
-	uint128_t top = static_cast<uint128_t>(sellPrice) * static_cast<uint128_t>(firstTerm);
-	uint128_t bot = static_cast<uint128_t>(secondTermA) * static_cast<uint128_t>(secondTermB);
-
-	if (top < bot) {
-		return 0;
-	}
-
-	uint128_t total = top - bot;
-
-	constexpr uint128_t INT128_MAX = (((uint128_t)1) << 127) - 1;
-
-	if (total > INT128_MAX) {
-		total = INT128_MAX;
-	}
-
-	// Round again, to ensure we don't have to round against the liquidity pool later.
-	// An offer can always offer to sell (amount * price), but the liquidity pool cannot
-	// -- it offers some amount * price, but the amount is non integral.
-	// The actual offered value is floor(amount) * price.
-	uint128_t roundingError = total % static_cast<uint128_t>(sellPrice);
-
-	total -= roundingError;
-	return total;
+	// Same computation as the tatonnement demand queries, so that clearing
+	// never asks a pool for more than tatonnement saw it offer.
+	auto params = LiquidityPoolDemandKernel::makePoolParams(sellAmount, buyAmount, getFixedPointFeeRate());
+	return LiquidityPoolDemandKernel::offeredForSaleTimesSellPrice(params, sellPrice, buyPrice);
 }
 
 int64_t 
 LiquidityPoolFrame::amountOfferedForSale(uint64_t sellPrice, uint64_t buyPrice) const {
-	//TODO run in fixed point
-	double offeredRatio = ((double) sellPrice) / ((double) buyPrice);
-
-	auto [sellAmount, buyAmount] = getSellBuyAmounts();
-
-	if (sellAmount == 0) {
-		return 0;
-	}
-
-	auto minRatio = getMinPriceRatio();
-
-	if (offeredRatio < minRatio) {
-		return 0;
-	}
-
-	int128_t k = ((int128_t) sellAmount) * ((int128_t) buyAmount);
-
-
-	auto invSqrt = [] (double val) {
-		return std::pow(val, -0.5);
-	};
-
-	auto sqrt = [] (double val) {
-		return std::pow(val, 0.5);
-	};
-
-	return std::floor(sqrt((double)k) * (invSqrt(minRatio) - invSqrt(offeredRatio)));
+	// amountOfferedForSaleTimesSellPrice is a multiple of sellPrice
+	return amountOfferedForSaleTimesSellPrice(sellPrice, buyPrice) / sellPrice;
 }
 
 void 
@@ -258,8 +124,13 @@ LiquidityPoolFrame::assertValidTrade(int64_t sellAmount, int64_t buyAmount, uint
 
 	int128_t prevK = ((int128_t) oldSellAmount) * ((int128_t) oldBuyAmount);
 
+	using uint128_t = unsigned __int128;
+
+	// the fee is kept out of the product, rounding in the pool's favor
+	int64_t buyAmountAfterFee = (((uint128_t) buyAmount) * (10000 - getFixedPointFeeRate())) / 10000;
+
 	int128_t newK = ((int128_t) (oldSellAmount - sellAmount)) 
-		* ((int128_t) (oldBuyAmount + std::floor(((double) buyAmount) * (1.0 - getFeeRate()))));
+		* ((int128_t) (oldBuyAmount + buyAmountAfterFee));
 
 	if (newK < prevK) {
 		throw std::runtime_error("constant product invariant not preserved");
@@ -269,7 +140,7 @@ LiquidityPoolFrame::assertValidTrade(int64_t sellAmount, int64_t buyAmount, uint
 SpeedexLiquidityPoolClearingStatus 
 LiquidityPoolFrame::doTransfer(int64_t sellAmount, int64_t buyAmount, uint64_t sellPrice, uint64_t buyPrice)
 {
-	std::printf("doing an lp transfer sellAmount %lld buyAmount %lld\n", sellAmount, buyAmount);
+	CLOG_TRACE(Speedex, "lp transfer sellAmount {} buyAmount {}", sellAmount, buyAmount);
 	if (!mBaseFrame) {
 		throw std::runtime_error("can't modify nonexistent lp");
 	}
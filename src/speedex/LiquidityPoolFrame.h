@@ -16,17 +16,15 @@ class LiquidityPoolFrame {
 
 	AssetPair mTradingPair;
 
-	double getFeeRate() const;
-
-	double getMinPriceRatio() const;
-
-	uint32_t
-	getFixedPointFeeRate() const;
 	uint64_t
 	subtractFeeRateFixedPoint(uint64_t startingPrice) const;
 
 public:
 
+	// in basis points
+	uint32_t
+	getFixedPointFeeRate() const;
+
 	std::pair<int64_t, int64_t> 
 	getSellBuyAmounts() const;
 
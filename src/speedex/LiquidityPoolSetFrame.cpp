@@ -5,6 +5,8 @@
 #include "speedex/DemandUtils.h"
 #include "speedex/sim_utils.h"
 
+#include "transactions/TransactionUtils.h"
+
 #include <utility>
 
 #include "util/types.h"
@@ -67,33 +69,17 @@ LiquidityPoolSetFrame::LiquidityPoolSetFrame(SpeedexSimConfig const& sim)
 }
 
 void
-LiquidityPoolSetFrame::demandQuery(std::map<Asset, uint64_t> const& prices, SupplyDemand& supplyDemand) const
-{
-	for (auto const& [tradingPair, lpFrame] : mLiquidityPools)
-	{
-		int128_t sellAmountTimesPrice = lpFrame.amountOfferedForSaleTimesSellPrice(prices.at(tradingPair.selling), prices.at(tradingPair.buying));
-
-		//std::printf("lp sell %s buy %s: %lf %ld\n", 
-		//	assetToString(tradingPair.selling).c_str(),
-		//	assetToString(tradingPair.buying).c_str(),
-		//	(double) sellAmountTimesPrice,
-		//	(int64_t) sellAmountTimesPrice);
-
-		supplyDemand.addSupplyDemand(tradingPair, sellAmountTimesPrice);
-	}
-}
-
-LiquidityPoolSetFrame::int128_t
-LiquidityPoolSetFrame::demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const
+LiquidityPoolSetFrame::insertKeysForPools(std::vector<Asset> const& assets, UnorderedSet<LedgerKey>& keys)
 {
-	auto iter = mLiquidityPools.find(tradingPair);
-	if (iter == mLiquidityPools.end()) {
-		return 0;
+	for (auto const& sellAsset : assets) {
+		for (auto const& buyAsset : assets) {
+			if (sellAsset < buyAsset) {
+				keys.emplace(liquidityPoolKey(getPoolID(sellAsset, buyAsset)));
+			}
+		}
 	}
-	return iter->second.amountOfferedForSaleTimesSellPrice(prices.at(tradingPair.selling), prices.at(tradingPair.buying));
 }
 
-
 LiquidityPoolFrame&
 LiquidityPoolSetFrame::getFrame(AssetPair const& tradingPair) {
 	return mLiquidityPools.at(tradingPair);
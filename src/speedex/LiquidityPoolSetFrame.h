@@ -4,7 +4,9 @@
 #include "speedex/LiquidityPoolFrame.h"
 #include "speedex/LiquidityPoolFrameBase.h"
 
+#include "ledger/LedgerHashUtils.h"
 #include "util/UnorderedMap.h"
+#include "util/UnorderedSet.h"
 #include <map>
 
 #include "xdr/speedex-sim.h"
@@ -27,14 +29,18 @@ public:
 	LiquidityPoolSetFrame(std::vector<Asset> const& assets, AbstractLedgerTxn& ltx);
 	LiquidityPoolSetFrame(SpeedexSimConfig const& sim);
 
-	void demandQuery(std::map<Asset, uint64_t> const& prices, SupplyDemand& supplyDemand) const;
-
-	int128_t 
-	demandQueryOneAssetPair(AssetPair const& tradingPair, std::map<Asset, uint64_t> const& prices) const;
-
 	LiquidityPoolFrame&
 	getFrame(AssetPair const& tradingPair);
 
+	// Inserts the keys of the pools the ltx constructor loads.
+	static void insertKeysForPools(std::vector<Asset> const& assets, UnorderedSet<LedgerKey>& keys);
+
+	// Iteration order is randomized; callers that need an order must sort.
+	UnorderedMap<AssetPair, LiquidityPoolFrame, AssetPairHash> const&
+	getFrames() const {
+		return mLiquidityPools;
+	}
+
 };
 
 } /* stellar */
\ No newline at end of file
@@ -1,14 +1,18 @@
 #include "speedex/OrderbookClearingTarget.h"
 
 #include "speedex/IOCOffer.h"
+#include "ledger/BalanceDeltaAccumulator.h"
 #include "ledger/LedgerTxn.h"
 
 #include "transactions/TransactionUtils.h"
 
 #include "ledger/TrustLineWrapper.h"
 
+#include "util/Logging.h"
 #include "util/types.h"
 
+#include "speedex/LiquidityPoolFrame.h"
+
 namespace stellar {
 
 OrderbookClearingTarget::OrderbookClearingTarget(
@@ -43,94 +47,72 @@ OrderbookClearingTarget::getBuyAmount(int128_t amountTimesPrice) const {
 void
 OrderbookClearingTarget::print() const
 {
-	auto sell = assetToString(mTradingPair.selling);
-	auto buy = assetToString(mTradingPair.buying);
-	std::printf("sell %s buy %s target %lf\n", sell.c_str(), buy.c_str(), (double) mTotalClearTarget);
+	CLOG_TRACE(Speedex, "sell {} buy {} target {}",
+		assetToString(mTradingPair.selling),
+		assetToString(mTradingPair.buying),
+		(double) mTotalClearTarget);
 }
 
-SpeedexOfferClearingStatus
-OrderbookClearingTarget::clearOffer(AbstractLedgerTxn& ltx, const IOCOffer& offer) {
+OrderbookClearingTarget::Fill
+OrderbookClearingTarget::computeOfferFill(const IOCOffer& offer) {
 
 	if (!checkPrice(offer)) {
 		throw std::logic_error("tried to clear offer with bad price!");
 	}
-	std::printf("clearing an offer with amount %lld sellPrice (%ld / %ld) \n", offer.mSellAmount, offer.mMinPrice.n, offer.mMinPrice.d);
 
 	int128_t offeredSellRealization = static_cast<int128_t>(offer.mSellAmount) * static_cast<int128_t>(mSellPrice);
 
-	//std::printf("offeredSellRealization (double %lf) %lld\n", (double) offeredSellRealization, (int64_t) offeredSellRealization);
-
 	int128_t curSellRealization = std::min(mTotalClearTarget - mRealizedClearTarget, offeredSellRealization);
 
 	mRealizedClearTarget += curSellRealization;
 
-	//std::printf("curSellRealization (double %lf) %lld\n", (double) curSellRealization, (int64_t) curSellRealization);
-
-	int64_t sellAmount = getSellAmount(curSellRealization);
-	int64_t buyAmount = getBuyAmount(curSellRealization);
-
-	//std::printf("sellAmount %lld buyAmount %lld\n", sellAmount, buyAmount);
-
-	mRealizedSellAmount += sellAmount;
-	mRealizedBuyAmount += buyAmount;
-
-	auto header = ltx.loadHeader();
+	Fill fill {
+		.mSellAmount = getSellAmount(curSellRealization),
+		.mBuyAmount = getBuyAmount(curSellRealization)
+	};
 
-	auto doTransfer = [&] (Asset asset, int64_t amount) {
-		if (asset.type() == ASSET_TYPE_NATIVE) {
-			auto account = loadAccount(ltx, offer.mSourceAccount);
-			auto ok = addBalance(header, account, amount);
-			if (!ok) {
-				throw std::runtime_error("fail to add xlm balance");
-			}
-		} else {
-	        auto sourceLine = loadTrustLine(ltx, offer.mSourceAccount, asset);
+	mRealizedSellAmount += fill.mSellAmount;
+	mRealizedBuyAmount += fill.mBuyAmount;
 
-	        if (!sourceLine) {
-	        	throw std::runtime_error("failed to find trustline");
-	        }
+	return fill;
+}
 
-	        if (!sourceLine.addBalance(header, amount))
-	        {
-	            throw std::runtime_error("failed to add nonxlm balance");
-	        }
-		}
-	};
+SpeedexOfferClearingStatus
+OrderbookClearingTarget::applyOfferFill(BalanceDeltaAccumulator& balances, const IOCOffer& offer, Fill const& fill) const {
 
-	doTransfer(mTradingPair.buying, buyAmount);
+	balances.addDelta(offer.mSourceAccount, mTradingPair.buying, fill.mBuyAmount);
 	//When creating the offer, we do not modify account balances.
 	//The correct approach might instead to be adjust an account's liabilities during offer
 	//creation instead.
-	doTransfer(mTradingPair.selling, -sellAmount);
+	balances.addDelta(offer.mSourceAccount, mTradingPair.selling, -fill.mSellAmount);
 
-	return offer.getClearingStatus(sellAmount, buyAmount, mTradingPair);
+	return offer.getClearingStatus(fill.mSellAmount, fill.mBuyAmount, mTradingPair);
 }
 
-SpeedexLiquidityPoolClearingStatus
-OrderbookClearingTarget::finishWithLiquidityPool(AbstractLedgerTxn& ltx, LiquidityPoolFrame& lpFrame) {
-	//std::printf("mTotalClearTarget (double %lf) %lld\n", (double) mTotalClearTarget, (int64_t) mTotalClearTarget);
-	//std::printf("mRealizedClearTarget (double %lf) %lld\n", (double) mRealizedClearTarget, (int64_t) mRealizedClearTarget);
-
+OrderbookClearingTarget::Fill
+OrderbookClearingTarget::computeLiquidityPoolFill() {
 
 	int128_t remainingToClear = mTotalClearTarget - mRealizedClearTarget;
 
-	//std::printf("remainingToClear (double %lf) %lld\n", (double) remainingToClear, (int64_t) remainingToClear);
-
-	int64_t sellAmount = getSellAmount(remainingToClear);
-	int64_t buyAmount = getBuyAmount(remainingToClear);
+	Fill fill {
+		.mSellAmount = getSellAmount(remainingToClear),
+		.mBuyAmount = getBuyAmount(remainingToClear)
+	};
 
-	//std::printf("sellAmount %lld buyAmount %lld\n", sellAmount, buyAmount);
+	mRealizedSellAmount += fill.mSellAmount;
+	mRealizedBuyAmount += fill.mBuyAmount;
 
-	lpFrame.assertValidSellAmount(sellAmount, mSellPrice, mBuyPrice);
+	mRealizedClearTarget += remainingToClear;
 
-	auto status = lpFrame.doTransfer(sellAmount, buyAmount, mSellPrice, mBuyPrice);
+	return fill;
+}
 
-	mRealizedSellAmount += sellAmount;
-	mRealizedBuyAmount += buyAmount;
+SpeedexLiquidityPoolClearingStatus
+OrderbookClearingTarget::applyLiquidityPoolFill(LiquidityPoolFrame& lpFrame, Fill const& fill) const {
 
-	mRealizedClearTarget += remainingToClear;
+	lpFrame.assertValidSellAmount(fill.mSellAmount, mSellPrice, mBuyPrice);
 
-	return status;
+	return lpFrame.doTransfer(fill.mSellAmount, fill.mBuyAmount, mSellPrice, mBuyPrice);
 }
 
 bool
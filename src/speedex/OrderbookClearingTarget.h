@@ -6,7 +6,7 @@
 
 namespace stellar {
 
-class AbstractLedgerTxn;
+class BalanceDeltaAccumulator;
 struct IOCOffer;
 class LiquidityPoolFrame;
 
@@ -29,7 +29,12 @@ class OrderbookClearingTarget {
 
 public:
 
+	struct Fill {
+		int64_t mSellAmount;
+		int64_t mBuyAmount;
+	};
 
+	// logs the target, at trace level
 	void print() const;
 	
 	int64_t getRealizedSellAmount() const {
@@ -41,15 +46,26 @@ public:
 
 	OrderbookClearingTarget(AssetPair tradingPair, uint64_t sellPrice, uint64_t buyPrice, int128_t totalClearingTarget);
 
+	// computeOfferFill() and computeLiquidityPoolFill() only advance this target,
+	// and touch no ledger state, so distinct targets can be filled concurrently.
+	// The resulting fills are then applied with applyOfferFill() and 
+	// applyLiquidityPoolFill().
+
+	Fill computeOfferFill(const IOCOffer& offer);
+
+	// fills the remainder of the target
+	Fill computeLiquidityPoolFill();
+
+	// Records the offer's balance changes in balances, for the caller to apply.
 	SpeedexOfferClearingStatus
-	clearOffer(AbstractLedgerTxn& ltx, const IOCOffer& offer);
+	applyOfferFill(BalanceDeltaAccumulator& balances, const IOCOffer& offer, Fill const& fill) const;
+
+	SpeedexLiquidityPoolClearingStatus
+	applyLiquidityPoolFill(LiquidityPoolFrame& lpFrame, Fill const& fill) const;
 
 	AssetPair getAssetPair() const;
 
 	bool doneClearing() const;
-
-	SpeedexLiquidityPoolClearingStatus
-	finishWithLiquidityPool(AbstractLedgerTxn& ltx, LiquidityPoolFrame& lpFrame);
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "speedex/OrderbookDemandKernel.h"
+
+#include "speedex/DemandUtils.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace stellar {
+
+void
+OrderbookDemandKernel::clear()
+{
+	mNumAssets = 0;
+	mBookIdxByPair.clear();
+	mSellAssetIdx.clear();
+	mBuyAssetIdx.clear();
+	mOffsets.clear();
+	mMarginalPriceN.clear();
+	mMarginalPriceD.clear();
+	mCumulativeOfferedForSale.clear();
+	mCumulativeOfferedForSaleTimesPrice.clear();
+}
+
+void
+OrderbookDemandKernel::build(UnorderedMap<AssetPair, IOCOrderbook, AssetPairHash> const& orderbooks, AssetIndex const& assetIndex)
+{
+	clear();
+
+	mNumAssets = assetIndex.size();
+
+	// UnorderedMap iteration order is randomized, so sort everything first.
+	std::vector<std::pair<std::pair<uint32_t, uint32_t>, IOCOrderbook const*>> books;
+	for (auto const& [tradingPair, orderbook] : orderbooks)
+	{
+		books.push_back({
+			{assetIndex.getIndex(tradingPair.selling), assetIndex.getIndex(tradingPair.buying)},
+			&orderbook});
+	}
+
+	std::sort(books.begin(), books.end(), [] (auto const& a, auto const& b) {
+		return a.first < b.first;
+	});
+
+	mBookIdxByPair.resize(mNumAssets * mNumAssets, -1);
+
+	mOffsets.push_back(0);
+	for (auto const& [idxs, orderbook] : books)
+	{
+		auto const& [sellIdx, buyIdx] = idxs;
+
+		mBookIdxByPair[sellIdx * mNumAssets + buyIdx] = mSellAssetIdx.size();
+		mSellAssetIdx.push_back(sellIdx);
+		mBuyAssetIdx.push_back(buyIdx);
+
+		auto const& stats = orderbook->getPrecomputedTatonnementData();
+		if (stats.empty())
+		{
+			throw std::runtime_error("orderbook not preprocessed before kernel build");
+		}
+		for (auto const& stat : stats)
+		{
+			mMarginalPriceN.push_back(stat.marginalPrice.n);
+			mMarginalPriceD.push_back(stat.marginalPrice.d);
+			mCumulativeOfferedForSale.push_back(stat.cumulativeOfferedForSale);
+			mCumulativeOfferedForSaleTimesPrice.push_back(stat.cumulativeOfferedForSaleTimesPrice);
+		}
+		mOffsets.push_back(mMarginalPriceN.size());
+	}
+}
+
+uint32_t
+OrderbookDemandKernel::findStatsIdx(uint32_t bookIdx, uint64_t sellPrice, uint64_t buyPrice) const
+{
+	// Entry 0 of each book is the zero price, which is always <= sellPrice / buyPrice,
+	// so this is the last index where the (monotone) comparison holds.
+	uint32_t base = mOffsets[bookIdx];
+	uint32_t len = mOffsets[bookIdx + 1] - base;
+
+	while (len > 1)
+	{
+		uint32_t half = len / 2;
+		uint32_t mid = base + half;
+		// marginalPrice.n / marginalPrice.d <=? sellPrice / buyPrice
+		bool lte = ((int128_t) mMarginalPriceN[mid]) * ((int128_t) buyPrice) 
+			<= ((int128_t) mMarginalPriceD[mid]) * ((int128_t) sellPrice);
+		base = lte ? mid : base;
+		len -= half;
+	}
+	return base;
+}
+
+OrderbookDemandKernel::int128_t
+OrderbookDemandKernel::cumulativeOfferedForSaleTimesPrice(uint32_t bookIdx, uint64_t sellPrice, uint64_t buyPrice, uint8_t smoothMult) const
+{
+	auto partialIdx = findStatsIdx(bookIdx, sellPrice, buyPrice);
+	auto fullIdx = findStatsIdx(bookIdx, applySmoothMult(sellPrice, smoothMult), buyPrice);
+
+	return IOCOrderbook::valueSold(
+		mCumulativeOfferedForSale[fullIdx],
+		mCumulativeOfferedForSaleTimesPrice[fullIdx],
+		mCumulativeOfferedForSale[partialIdx],
+		mCumulativeOfferedForSaleTimesPrice[partialIdx],
+		sellPrice,
+		buyPrice,
+		smoothMult);
+}
+
+void
+OrderbookDemandKernel::demandQuery(
+	PriceVector const& prices,
+	SupplyDemand& supplyDemand,
+	uint8_t smoothMult) const
+{
+	const size_t numBooks = numOrderbooks();
+	for (size_t i = 0; i < numBooks; i++)
+	{
+		auto sellIdx = mSellAssetIdx[i];
+		auto buyIdx = mBuyAssetIdx[i];
+
+		auto tradeAmount = cumulativeOfferedForSaleTimesPrice(i, prices[sellIdx], prices[buyIdx], smoothMult);
+
+		supplyDemand.addSupplyDemand(sellIdx, buyIdx, tradeAmount);
+	}
+}
+
+OrderbookDemandKernel::int128_t
+OrderbookDemandKernel::demandQueryOneAssetPair(uint32_t sellIdx, uint32_t buyIdx, PriceVector const& prices, uint8_t smoothMult) const
+{
+	if (mBookIdxByPair.empty())
+	{
+		return 0;
+	}
+	auto bookIdx = mBookIdxByPair[sellIdx * mNumAssets + buyIdx];
+	if (bookIdx < 0)
+	{
+		return 0;
+	}
+	return cumulativeOfferedForSaleTimesPrice(bookIdx, prices[sellIdx], prices[buyIdx], smoothMult);
+}
+
+} /* stellar */
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ledger/AssetPair.h"
+
+#include "speedex/IOCOrderbook.h"
+#include "speedex/PriceVector.h"
+
+#include "util/UnorderedMap.h"
+#include "util/XDROperators.h"
+
+#include "ledger/LedgerHashUtils.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace stellar {
+
+struct SupplyDemand;
+
+/*
+ Flattened, structure-of-arrays copy of every orderbook's precomputed
+ tatonnement data.  Built once, when the batch is sealed.
+
+ Assets are numbered by the batch's AssetIndex, and each orderbook's
+ PriceCompStats are laid out contiguously in a set of flat arrays.
+ A demand query is then a walk over these arrays that accumulates into
+ a vector indexed by asset number -- no asset hashing and no map lookups
+ in the inner loop.
+*/
+class OrderbookDemandKernel {
+
+	using int128_t = __int128_t;
+
+	size_t mNumAssets = 0;
+
+	// mBookIdxByPair[sell * mNumAssets + buy] is the index of the orderbook
+	// trading sell for buy, or -1 if there is none.
+	std::vector<int32_t> mBookIdxByPair;
+
+	// per orderbook
+	std::vector<uint32_t> mSellAssetIdx;
+	std::vector<uint32_t> mBuyAssetIdx;
+	// orderbook i occupies [mOffsets[i], mOffsets[i+1]) in the flat arrays below
+	std::vector<uint32_t> mOffsets;
+
+	// per PriceCompStats entry
+	std::vector<uint32_t> mMarginalPriceN;
+	std::vector<uint32_t> mMarginalPriceD;
+	std::vector<int64_t> mCumulativeOfferedForSale;
+	std::vector<int128_t> mCumulativeOfferedForSaleTimesPrice;
+
+	// returns the index of the last entry of orderbook bookIdx 
+	// with marginal price <= sellPrice / buyPrice
+	uint32_t findStatsIdx(uint32_t bookIdx, uint64_t sellPrice, uint64_t buyPrice) const;
+
+public:
+
+	OrderbookDemandKernel() = default;
+
+	// Throws if an orderbook trades an asset that assetIndex does not know.
+	void build(UnorderedMap<AssetPair, IOCOrderbook, AssetPairHash> const& orderbooks, AssetIndex const& assetIndex);
+
+	void clear();
+
+	size_t numOrderbooks() const {
+		return mSellAssetIdx.size();
+	}
+
+	// Adds (supply, demand) of each asset to supplyDemand.
+	void demandQuery(
+		PriceVector const& prices,
+		SupplyDemand& supplyDemand,
+		uint8_t smoothMult) const;
+
+	bool hasOrderbook(uint32_t sellIdx, uint32_t buyIdx) const {
+		return !mBookIdxByPair.empty() && mBookIdxByPair[sellIdx * mNumAssets + buyIdx] >= 0;
+	}
+
+	// returns 0 if there is no orderbook for the pair.
+	int128_t 
+	demandQueryOneAssetPair(uint32_t sellIdx, uint32_t buyIdx, PriceVector const& prices, uint8_t smoothMult) const;
+
+	// Same output as IOCOrderbook::cumulativeOfferedForSaleTimesPrice
+	int128_t 
+	cumulativeOfferedForSaleTimesPrice(uint32_t bookIdx, uint64_t sellPrice, uint64_t buyPrice, uint8_t smoothMult) const;
+};
+
+} /* stellar */
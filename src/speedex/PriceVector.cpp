@@ -0,0 +1,67 @@
+#include "speedex/PriceVector.h"
+
+#include <stdexcept>
+
+namespace stellar {
+
+AssetIndex::AssetIndex(std::vector<Asset> const& assets)
+	: mAssets(assets)
+{
+	for (uint32_t i = 0; i < mAssets.size(); i++)
+	{
+		if (!mIndices.emplace(mAssets[i], i).second)
+		{
+			throw std::runtime_error("duplicate asset in asset index");
+		}
+	}
+}
+
+uint32_t
+AssetIndex::getIndex(Asset const& asset) const
+{
+	auto iter = mIndices.find(asset);
+	if (iter == mIndices.end())
+	{
+		throw std::runtime_error("asset not in asset index");
+	}
+	return iter->second;
+}
+
+std::optional<uint32_t>
+AssetIndex::tryGetIndex(Asset const& asset) const
+{
+	auto iter = mIndices.find(asset);
+	if (iter == mIndices.end())
+	{
+		return std::nullopt;
+	}
+	return iter->second;
+}
+
+PriceVector::PriceVector(size_t numAssets, uint64_t initialPrice)
+	: mPrices(numAssets, initialPrice)
+{}
+
+PriceVector
+PriceVector::fromMap(AssetIndex const& assetIndex, std::map<Asset, uint64_t> const& prices)
+{
+	PriceVector out(assetIndex.size());
+	for (uint32_t i = 0; i < assetIndex.size(); i++)
+	{
+		out[i] = prices.at(assetIndex.getAsset(i));
+	}
+	return out;
+}
+
+std::map<Asset, uint64_t>
+PriceVector::toMap(AssetIndex const& assetIndex) const
+{
+	std::map<Asset, uint64_t> out;
+	for (uint32_t i = 0; i < assetIndex.size(); i++)
+	{
+		out[assetIndex.getAsset(i)] = mPrices.at(i);
+	}
+	return out;
+}
+
+} /* stellar */
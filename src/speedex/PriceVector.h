@@ -0,0 +1,79 @@
+#pragma once
+
+#include "xdr/Stellar-ledger-entries.h"
+
+#include "ledger/LedgerHashUtils.h"
+
+#include "util/UnorderedMap.h"
+#include "util/XDROperators.h"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace stellar {
+
+/*
+ Dense numbering of the assets traded in a speedex batch.
+ On the ledger, the numbering is the order of SpeedexConfigEntry::speedexAssets.
+ Every per-asset vector in speedex (prices, supply/demand, solver variables)
+ is indexed by this numbering.
+*/
+class AssetIndex {
+	std::vector<Asset> mAssets;
+	UnorderedMap<Asset, uint32_t> mIndices;
+
+public:
+
+	AssetIndex() = default;
+
+	// keeps the order of assets.  Throws on duplicates.
+	explicit AssetIndex(std::vector<Asset> const& assets);
+
+	size_t size() const {
+		return mAssets.size();
+	}
+
+	Asset const& getAsset(uint32_t idx) const {
+		return mAssets.at(idx);
+	}
+
+	std::vector<Asset> const& getAssets() const {
+		return mAssets;
+	}
+
+	// throws if asset is not indexed
+	uint32_t getIndex(Asset const& asset) const;
+
+	std::optional<uint32_t> tryGetIndex(Asset const& asset) const;
+};
+
+class PriceVector {
+	std::vector<uint64_t> mPrices;
+
+public:
+
+	PriceVector() = default;
+	explicit PriceVector(size_t numAssets, uint64_t initialPrice = 0);
+
+	size_t size() const {
+		return mPrices.size();
+	}
+
+	uint64_t& operator[](uint32_t idx) {
+		return mPrices[idx];
+	}
+	uint64_t operator[](uint32_t idx) const {
+		return mPrices[idx];
+	}
+
+	bool operator==(PriceVector const& other) const = default;
+
+	// throws if an indexed asset is missing from prices
+	static PriceVector fromMap(AssetIndex const& assetIndex, std::map<Asset, uint64_t> const& prices);
+
+	std::map<Asset, uint64_t> toMap(AssetIndex const& assetIndex) const;
+};
+
+} /* stellar */
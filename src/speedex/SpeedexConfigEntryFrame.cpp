@@ -1,5 +1,6 @@
 #include "speedex/SpeedexConfigEntryFrame.h"
 
+#include "transactions/TransactionUtils.h"
 #include "util/XDROperators.h"
 
 namespace stellar {
@@ -38,30 +39,95 @@ SpeedexConfigSnapshotFrame::getAssets() const
 	return mSpeedexConfig->data.speedexConfig().speedexAssets;
 }
 
+AssetIndex
+SpeedexConfigSnapshotFrame::getAssetIndex() const
+{
+	return AssetIndex(getAssets());
+}
+
 TatonnementControlParams
 SpeedexConfigSnapshotFrame::getControls() const
 {
-	return TatonnementControlParams
+	TatonnementControlParams out
     {
         .mTaxRate = 5,
         .mSmoothMult = 7,
         .mMaxRounds = 1000,
-        .mStepUp = 45,
-        .mStepDown = 25,
+        .mStepUp = kMultiStartStepParams[0].mStepUp,
+        .mStepDown = kMultiStartStepParams[0].mStepDown,
         .mStepSizeRadix = 5,
-        .mStepRadix = 65
+        .mStepRadix = 65,
+        .mStagnationRounds = 100,
+        .mStagnationTolN = 1,
+        .mStagnationTolD = 100
     };
+
+	auto const& sce = mSpeedexConfig->data.speedexConfig();
+	if (sce.ext.v() == 1 && sce.ext.v1().ext.v() == 2)
+	{
+		auto const& stagnation = sce.ext.v1().ext.v2().stagnation;
+		bool valid = stagnation.tolD >= 1 && stagnation.tolD <= UINT8_MAX
+			&& stagnation.tolN <= stagnation.tolD;
+		out.mStagnationRounds = valid ? stagnation.stagnationRounds : 0;
+		out.mStagnationTolN = valid ? stagnation.tolN : 0;
+		out.mStagnationTolD = valid ? stagnation.tolD : 1;
+	}
+	return out;
 }
 
-std::map<Asset, uint64_t>
+std::vector<TatonnementInstanceParams>
+SpeedexConfigSnapshotFrame::getTatonnementInstances() const
+{
+	auto base = getControls();
+
+	std::vector<TatonnementInstanceParams> out;
+	for (auto const& step : kMultiStartStepParams)
+	{
+		auto controls = base;
+		controls.mStepUp = step.mStepUp;
+		controls.mStepDown = step.mStepDown;
+		out.push_back(TatonnementInstanceParams{
+			.mControls = controls,
+			.mStartingPrices = std::nullopt
+		});
+	}
+	if (hasWarmStart())
+	{
+		out.push_back(TatonnementInstanceParams{
+			.mControls = base,
+			.mStartingPrices = getColdStartingPrices()
+		});
+	}
+	return out;
+}
+
+PriceVector
 SpeedexConfigSnapshotFrame::getStartingPrices() const
 {
-	std::map<Asset, uint64_t> prices;
-	for (auto const& asset : getAssets())
+	auto assetIndex = getAssetIndex();
+	auto out = getColdStartingPrices();
+	for (auto const& valuation : getLastValuations(mSpeedexConfig->data.speedexConfig()))
 	{
-		prices[asset] = 0x100000000;
+		// assets may have been removed from the config since the last batch
+		auto idx = assetIndex.tryGetIndex(valuation.asset);
+		if (idx && valuation.price != 0)
+		{
+			out[*idx] = valuation.price;
+		}
 	}
-	return prices;
+	return out;
+}
+
+PriceVector
+SpeedexConfigSnapshotFrame::getColdStartingPrices() const
+{
+	return PriceVector(getAssets().size(), kDefaultStartingPrice);
+}
+
+bool
+SpeedexConfigSnapshotFrame::hasWarmStart() const
+{
+	return getStartingPrices() != getColdStartingPrices();
 }
 
 } /* stellar */
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "ledger/AssetPair.h"
 
 #include "speedex/TatonnementControls.h"
+#include "speedex/TatonnementOracle.h"
+#include "speedex/PriceVector.h"
 
 #include "util/XDROperators.h"
 
@@ -26,9 +28,35 @@ public:
 
 	std::vector<Asset> getAssets() const;
 
+	// numbers assets in the order of SpeedexConfigEntry::speedexAssets
+	AssetIndex getAssetIndex() const;
+
+	// stagnation criterion from SpeedexConfigEntryExtensionV2, if set
 	TatonnementControlParams getControls() const;
 
-	std::map<Asset, uint64_t> getStartingPrices() const;
+	// Variants of getControls() run concurrently by multi-start tatonnement.
+	// Only step adjustment parameters vary, so that objective values remain
+	// comparable across instances.
+	// When getStartingPrices() is warm-started, one extra instance starts 
+	// from getColdStartingPrices(), in case the market moved sharply.
+	std::vector<TatonnementInstanceParams> getTatonnementInstances() const;
+
+	// Instances stop once the objective falls to within this fraction
+	// of the objective at the starting prices.
+	constexpr static uint8_t kMultiStartTolN = 1;
+	constexpr static uint8_t kMultiStartTolD = 200;
+
+	constexpr static uint64_t kDefaultStartingPrice = 0x100000000;
+
+	// indexed by getAssetIndex().
+	// The prices of the last cleared batch (SpeedexConfigEntryExtensionV1::lastValuations),
+	// where known, and kDefaultStartingPrice otherwise.
+	PriceVector getStartingPrices() const;
+
+	// kDefaultStartingPrice for every asset
+	PriceVector getColdStartingPrices() const;
+
+	bool hasWarmStart() const;
 };
 
 
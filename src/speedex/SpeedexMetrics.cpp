@@ -0,0 +1,44 @@
+#include "speedex/SpeedexMetrics.h"
+
+#include "main/Application.h"
+
+#include "medida/histogram.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+#include <Tracy.hpp>
+
+namespace stellar {
+
+SpeedexMetrics::SpeedexMetrics(Application& app)
+	: mSealTime(app.getMetrics().NewTimer({"speedex", "phase", "seal"}))
+	, mTatonnementTime(app.getMetrics().NewTimer({"speedex", "phase", "tatonnement"}))
+	, mSolveTime(app.getMetrics().NewTimer({"speedex", "phase", "solve"}))
+	, mClearTime(app.getMetrics().NewTimer({"speedex", "phase", "clear"}))
+	, mTatonnementRounds(app.getMetrics().NewHistogram({"speedex", "tatonnement", "rounds"}))
+	, mObjectiveBits(app.getMetrics().NewHistogram({"speedex", "tatonnement", "objective-bits"}))
+	, mNumOffers(app.getMetrics().NewHistogram({"speedex", "batch", "offers"}))
+	, mNumOrderbooks(app.getMetrics().NewHistogram({"speedex", "batch", "orderbooks"}))
+	, mRoundingErrorReturned(app.getMetrics().NewHistogram({"speedex", "batch", "rounding-error"}))
+	{}
+
+void
+SpeedexMetrics::record(SpeedexBatchMetrics const& batch)
+{
+	mSealTime.Update(batch.mTimings.mSealBatch);
+	mTatonnementTime.Update(batch.mTimings.mTatonnement);
+	mSolveTime.Update(batch.mTimings.mSolver);
+	mClearTime.Update(batch.mTimings.mClearing);
+
+	mTatonnementRounds.Update(batch.mTatonnementRounds);
+	mObjectiveBits.Update(batch.mObjectiveBits);
+	mNumOffers.Update(batch.mNumOffers);
+	mNumOrderbooks.Update(batch.mNumOrderbooks);
+	mRoundingErrorReturned.Update(batch.mRoundingErrorReturned);
+
+	TracyPlot("speedex.tatonnement.rounds", static_cast<int64_t>(batch.mTatonnementRounds));
+	TracyPlot("speedex.batch.offers", static_cast<int64_t>(batch.mNumOffers));
+	TracyPlot("speedex.batch.rounding-error", batch.mRoundingErrorReturned);
+}
+
+} /* stellar */
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "speedex/speedex.h"
+
+namespace medida
+{
+class Timer;
+class Histogram;
+}
+
+namespace stellar {
+
+class Application;
+
+/*
+ Per-batch speedex metrics, in the app's registry (and so on the
+ metrics route).
+*/
+struct SpeedexMetrics {
+
+	SpeedexMetrics(Application& app);
+
+	medida::Timer& mSealTime;
+	medida::Timer& mTatonnementTime;
+	medida::Timer& mSolveTime;
+	medida::Timer& mClearTime;
+
+	medida::Histogram& mTatonnementRounds;
+	medida::Histogram& mObjectiveBits;
+	medida::Histogram& mNumOffers;
+	medida::Histogram& mNumOrderbooks;
+	medida::Histogram& mRoundingErrorReturned;
+
+	void record(SpeedexBatchMetrics const& batch);
+};
+
+} /* stellar */
@@ -24,7 +24,31 @@ TatonnementControlParamsWrapper::incrementRound()
 bool
 TatonnementControlParamsWrapper::done() const
 {
-	return mRoundNumber >= mParams.mMaxRounds;
+	return mRoundNumber >= mParams.mMaxRounds || mStagnated;
+}
+
+void
+TatonnementControlParamsWrapper::recordObjective(TatonnementObjectiveFn const& objective)
+{
+	if (mParams.mStagnationRounds == 0) {
+		return;
+	}
+
+	// a significant improvement is one that beats the best so far by more than the tolerance
+	if (!mBestObjective || !mBestObjective->isBetterThan(objective, mParams.mStagnationTolN, mParams.mStagnationTolD)) {
+		mBestObjective = objective;
+		mBestObjectiveRound = mRoundNumber;
+		return;
+	}
+
+	if (objective.isBetterThan(*mBestObjective, 0, 1)) {
+		// keep the best value, but without restarting the clock
+		mBestObjective = objective;
+	}
+
+	if (mRoundNumber - mBestObjectiveRound >= mParams.mStagnationRounds) {
+		mStagnated = true;
+	}
 }
 
 uint64_t 
@@ -106,17 +130,14 @@ TatonnementControlParamsWrapper::setTrialPrice(uint64_t curPrice, int128_t const
 
 
 
-std::map<Asset, uint64_t>
+void
 TatonnementControlParamsWrapper::setTrialPrices(
-	std::map<Asset, uint64_t> const& curPrices, SupplyDemand const& demands, uint64_t stepSize) const
+	PriceVector const& curPrices, SupplyDemand const& demands, uint64_t stepSize, PriceVector& trialPrices) const
 {
-	std::map<Asset, uint64_t> pricesOut;
-	for (auto const& [asset, curPrice] : curPrices)
+	for (uint32_t i = 0; i < curPrices.size(); i++)
 	{
-		pricesOut[asset] = setTrialPrice(curPrice, demands.getDelta(asset), stepSize);
+		trialPrices[i] = setTrialPrice(curPrices[i], demands.getDelta(i), stepSize);
 	}
-
-	return pricesOut;
 }
 
 
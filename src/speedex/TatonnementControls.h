@@ -11,6 +11,11 @@
 
 #include "ledger/LedgerHashUtils.h"
 
+#include "speedex/DemandUtils.h"
+#include "speedex/PriceVector.h"
+
+#include <optional>
+
 namespace stellar
 {
 
@@ -24,9 +29,25 @@ struct TatonnementControlParams
 	uint8_t mStepUp, mStepDown, mStepSizeRadix;
 
 	uint8_t mStepRadix;
+
+	// Stop once the objective has gone mStagnationRounds rounds without
+	// improving on its best value by more than mStagnationTolN / mStagnationTolD.
+	// Uses only exact comparisons, so every validator stops at the same round.
+	// 0 disables the check.
+	uint32_t mStagnationRounds = 0;
+	uint8_t mStagnationTolN = 0, mStagnationTolD = 1;
 };
 
-struct SupplyDemand;
+// (mStepUp, mStepDown) of each cold-start instance multi-start tatonnement
+// runs; the first is also the step adjustment of the base controls.
+struct TatonnementStepParams
+{
+	uint8_t mStepUp, mStepDown;
+};
+
+inline constexpr TatonnementStepParams kMultiStartStepParams[] = {
+	{45, 25}, {38, 28}, {56, 20}
+};
 
 class TatonnementControlParamsWrapper
 {
@@ -35,6 +56,11 @@ class TatonnementControlParamsWrapper
 
 	uint32_t mRoundNumber = 0;
 
+	// best objective seen so far, and the round it was set
+	std::optional<TatonnementObjectiveFn> mBestObjective;
+	uint32_t mBestObjectiveRound = 0;
+	bool mStagnated = false;
+
 	using int128_t = __int128;
 	using uint128_t = unsigned __int128;
 
@@ -54,6 +80,13 @@ public:
 	void incrementRound();
 	bool done() const;
 
+	// Called with the current objective after each round, to track stagnation.
+	void recordObjective(TatonnementObjectiveFn const& objective);
+
+	bool stagnated() const {
+		return mStagnated;
+	}
+
 	uint8_t smoothMult() const {
 		return mParams.mSmoothMult;
 	}
@@ -64,8 +97,9 @@ public:
 	//todo relativizers?
 	uint64_t setTrialPrice(uint64_t curPrice, int128_t const& demand, uint64_t stepSize) const;
 
-	std::map<Asset, uint64_t>
-	setTrialPrices(std::map<Asset, uint64_t> const& curPrices, SupplyDemand const& demands, uint64_t stepSize) const;
+	// writes into trialPrices, which must be the same size as curPrices
+	void
+	setTrialPrices(PriceVector const& curPrices, SupplyDemand const& demands, uint64_t stepSize, PriceVector& trialPrices) const;
 
 	uint64_t imposePriceBounds(uint64_t candidatePrice) const;
 
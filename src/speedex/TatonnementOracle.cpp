@@ -7,6 +7,14 @@
 
 #include "speedex/DemandOracle.h"
 #include "speedex/DemandUtils.h"
+#include "speedex/IncrementalDemandOracle.h"
+
+#include "util/Logging.h"
+#include "util/Thread.h"
+
+#include <Tracy.hpp>
+
+#include <limits>
 
 
 namespace stellar
@@ -16,50 +24,171 @@ TatonnementOracle::TatonnementOracle(DemandOracle const& demandOracle)
 	: mDemandOracle(demandOracle)
 {}
 
-void 
-TatonnementOracle::computePrices(TatonnementControlParams const& params, std::map<Asset, uint64_t>& prices, const uint32_t printFrequency)
+TatonnementOracle::InstanceResult
+TatonnementOracle::runInstance(
+	TatonnementControlParams const& params,
+	PriceVector prices,
+	std::optional<TatonnementObjectiveFn> const& convergenceTarget,
+	size_t instanceIdx,
+	std::atomic<size_t>* winningInstance,
+	const uint32_t printFrequency) const
 {
 	TatonnementControlParamsWrapper controlParams(params);
 
-	SupplyDemand baselineDemand = mDemandOracle.demandQuery(prices, controlParams.smoothMult());
+	auto const& assetIndex = mDemandOracle.getAssetIndex();
 
-	TatonnementObjectiveFn baselineObjective = baselineDemand.getObjective();
+	// All allocation happens here; the loop below only swaps buffers.
+	PriceVector trialPrices(prices.size());
+
+	// Each round only re-evaluates the pairs whose prices moved,
+	// and a rejected trial is rolled back instead of recomputed.
+	IncrementalDemandOracle demand(mDemandOracle, controlParams.smoothMult());
+	demand.reset(prices);
+
+	TatonnementObjectiveFn baselineObjective = demand.getSupplyDemand().getObjective();
+	controlParams.recordObjective(baselineObjective);
 
 	uint64_t stepSize = controlParams.kStartingStepSize;
 
-	while (!controlParams.done()) {
+	auto hasConverged = [&] () -> bool {
+		return convergenceTarget && baselineObjective.isBetterThan(*convergenceTarget, 0, 1);
+	};
 
-		controlParams.incrementRound();
+	while (!controlParams.done() && !hasConverged()) {
+
+		if (winningInstance && winningInstance->load() < instanceIdx)
+		{
+			// a lower-indexed instance already won, so this one can never be chosen
+			return InstanceResult{};
+		}
 
-		std::map<Asset, uint64_t> trialPrices = controlParams.setTrialPrices(prices, baselineDemand, stepSize);
+		controlParams.incrementRound();
 
-		auto trialDemand = mDemandOracle.demandQuery(trialPrices, controlParams.smoothMult());
+		controlParams.setTrialPrices(prices, demand.getSupplyDemand(), stepSize, trialPrices);
 
-		TatonnementObjectiveFn trialObjective = trialDemand.getObjective();
+		TatonnementObjectiveFn trialObjective = demand.trialQuery(trialPrices).getObjective();
 
 		if (trialObjective.isBetterThan(baselineObjective, 1, 100) || stepSize < controlParams.kMinStepSize)
 		{
-			prices = trialPrices;
+			demand.accept();
+			std::swap(prices, trialPrices);
 
-			baselineDemand = trialDemand;
 			baselineObjective = trialObjective;
 
 			stepSize = controlParams.stepUp(std::max(stepSize, controlParams.kMinStepSize));
 		} else {
+			demand.reject();
 			stepSize = controlParams.stepDown(stepSize);
 		}
 
+		controlParams.recordObjective(baselineObjective);
+
 		if (printFrequency > 0 && controlParams.getRoundNumber() % printFrequency == 0)
 		{
-			std::printf("TATONNEMENT STEP: step size: %llu round number: %lu\n", stepSize, controlParams.getRoundNumber());
-			for (auto const& [asset, price] : prices)
+			CLOG_TRACE(Speedex, "tatonnement step size {} round {}", stepSize, controlParams.getRoundNumber());
+			for (uint32_t i = 0; i < prices.size(); i++)
 			{
-				int128_t demand = baselineDemand.getDelta(asset);
-				auto str = assetToString(asset);
-				std::printf("TATONNEMENT: %s\t%15llu\t%lf\n", str.c_str(), price, (double)demand);
+				double delta = demand.getSupplyDemand().getDelta(i);
+				CLOG_TRACE(Speedex, "tatonnement {} price {} excess demand {}",
+					assetToString(assetIndex.getAsset(i)), prices[i], delta);
 			}
 		}
 	}
+
+	InstanceResult out;
+	out.mConverged = hasConverged();
+	out.mRounds = controlParams.getRoundNumber();
+	out.mPrices = std::move(prices);
+	out.mObjective = baselineObjective;
+
+	if (out.mConverged && winningInstance)
+	{
+		// lower the shared winner index to ours, if we are the lowest so far
+		size_t cur = winningInstance->load();
+		while (cur > instanceIdx && !winningInstance->compare_exchange_weak(cur, instanceIdx)) {}
+	}
+	return out;
+}
+
+void
+TatonnementOracle::recordRunStats(InstanceResult const& result)
+{
+	mLastRunStats = RunStats{
+		.mRounds = result.mRounds,
+		.mConverged = result.mConverged,
+		.mObjective = result.mObjective
+	};
+}
+
+void 
+TatonnementOracle::computePrices(TatonnementControlParams const& params, PriceVector& prices, const uint32_t printFrequency)
+{
+	ZoneScoped;
+	auto res = runInstance(params, prices, std::nullopt, 0, nullptr, printFrequency);
+	recordRunStats(res);
+	prices = std::move(res.mPrices);
+}
+
+void 
+TatonnementOracle::computePrices(TatonnementControlParams const& params, std::map<Asset, uint64_t>& prices, const uint32_t printFrequency)
+{
+	auto const& assetIndex = mDemandOracle.getAssetIndex();
+	auto priceVector = PriceVector::fromMap(assetIndex, prices);
+	computePrices(params, priceVector, printFrequency);
+	for (auto const& [asset, price] : priceVector.toMap(assetIndex))
+	{
+		prices[asset] = price;
+	}
+}
+
+size_t
+TatonnementOracle::computePricesMultiStart(
+	std::vector<TatonnementInstanceParams> const& instances,
+	PriceVector& prices,
+	uint8_t tolN,
+	uint8_t tolD)
+{
+	ZoneScoped;
+	if (instances.empty())
+	{
+		throw std::runtime_error("multistart tatonnement needs at least one instance");
+	}
+
+	// All instances are measured against the same target, derived from the
+	// objective at the input prices, so that their results are comparable.
+	// The smoothMult of the first instance defines the target.
+	TatonnementControlParamsWrapper referenceParams(instances.front().mControls);
+	auto startObjective = mDemandOracle.demandQuery(prices, referenceParams.smoothMult()).getObjective();
+	auto convergenceTarget = startObjective.scaledBy(tolN, tolD);
+
+	std::atomic<size_t> winningInstance = std::numeric_limits<size_t>::max();
+
+	// Which instance wins doesn't depend on the order instances run in, so
+	// instances the helper budget leaves to this thread can run serially.
+	std::vector<InstanceResult> results(instances.size());
+	parallelFor(instances.size(), instances.size() - 1, [&](size_t i) {
+		auto const& instance = instances[i];
+		auto const& startingPrices = instance.mStartingPrices ? *instance.mStartingPrices : prices;
+		results[i] = runInstance(instance.mControls, startingPrices, convergenceTarget, i, &winningInstance, 0);
+	});
+
+	size_t winner = winningInstance.load();
+	if (winner >= results.size())
+	{
+		// nobody converged; take the best objective, lowest index on ties.
+		winner = 0;
+		for (size_t i = 1; i < results.size(); i++)
+		{
+			if (!results[winner].mObjective.value().isBetterThan(*results[i].mObjective, 0, 1))
+			{
+				winner = i;
+			}
+		}
+	}
+
+	recordRunStats(results[winner]);
+	prices = std::move(results[winner].mPrices);
+	return winner;
 }
 
 
@@ -8,9 +8,13 @@
 
 #include "ledger/LedgerHashUtils.h"
 
-#include  <cstdint>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <vector>
 
 #include "speedex/DemandOracle.h"
+#include "speedex/DemandUtils.h"
 
 namespace stellar
 {
@@ -18,13 +22,56 @@ namespace stellar
 class IOCOrderbookManager;
 class LiquidityPoolSetFrame;
 
+// One instance of a multi-start tatonnement run.
+// If mStartingPrices is unset, the instance starts from the prices
+// passed in by the caller.
+struct TatonnementInstanceParams
+{
+	TatonnementControlParams mControls;
+	std::optional<PriceVector> mStartingPrices;
+};
+
 class TatonnementOracle {
 
 	using int128_t = __int128;
 
 	DemandOracle mDemandOracle;
 
-	void demandQuery(std::map<Asset, uint64_t> const& prices, std::map<Asset, int128_t>& demands, uint8_t taxRate, uint8_t smoothMult) const;
+	struct InstanceResult
+	{
+		PriceVector mPrices;
+		std::optional<TatonnementObjectiveFn> mObjective;
+		bool mConverged = false;
+		uint32_t mRounds = 0;
+	};
+
+public:
+
+	// Describes the instance whose prices the last computePrices* call returned.
+	struct RunStats
+	{
+		uint32_t mRounds = 0;
+		bool mConverged = false;
+		std::optional<TatonnementObjectiveFn> mObjective;
+	};
+
+private:
+
+	RunStats mLastRunStats;
+
+	void recordRunStats(InstanceResult const& result);
+
+	// Runs one tatonnement instance.  Stops early (with mConverged set) once the objective
+	// drops below convergenceTarget, or (without a result) once a lower-indexed instance
+	// has converged, as recorded in winningInstance.  Also stops, unconverged, once the
+	// objective stagnates (see TatonnementControlParams::mStagnationRounds).
+	InstanceResult runInstance(
+		TatonnementControlParams const& params,
+		PriceVector prices,
+		std::optional<TatonnementObjectiveFn> const& convergenceTarget,
+		size_t instanceIdx,
+		std::atomic<size_t>* winningInstance,
+		const uint32_t printFrequency) const;
 
 public:
 
@@ -33,9 +80,29 @@ public:
 	TatonnementOracle(const TatonnementOracle&) = delete;
 	TatonnementOracle& operator=(const TatonnementOracle&) = delete;
 
-	//map, not UnorderedMap, for deterministic ordering
-	//caller's responsibility to initialize starting prices
+	//caller's responsibility to initialize starting prices.
+	//prices are indexed by the demand oracle's AssetIndex.
+	void computePrices(TatonnementControlParams const& params, PriceVector& prices, const uint32_t printFrequency = 0);
+
+	// Convenience wrapper; prices must contain every asset in the demand oracle's AssetIndex.
 	void computePrices(TatonnementControlParams const& params, std::map<Asset, uint64_t>& prices, const uint32_t printFrequency = 0);
+
+	// Runs every instance concurrently, one thread per instance.
+	// The winner is the lowest-indexed instance whose objective falls to within
+	// (tolN / tolD) of the objective at the input prices.  If no instance
+	// gets there, the winner is the instance with the best final objective
+	// (ties broken by lowest index).  Selection does not depend on thread timing,
+	// so every validator picks the same prices.
+	// Returns the index of the winning instance and writes its prices into prices.
+	size_t computePricesMultiStart(
+		std::vector<TatonnementInstanceParams> const& instances,
+		PriceVector& prices,
+		uint8_t tolN,
+		uint8_t tolD);
+
+	RunStats const& getLastRunStats() const {
+		return mLastRunStats;
+	}
 };
 
-} /* stellar */
\ No newline at end of file
+} /* stellar */
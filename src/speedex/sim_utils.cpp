@@ -1,5 +1,18 @@
+
 #include "speedex/sim_utils.h"
 
+#include "util/Math.h"
+#include "util/XDROperators.h"
+#include "util/types.h"
+
+#include <xdrpp/marshal.h>
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
 namespace stellar {
 
 Asset makeSimAsset(AssetCode12 const& code)
@@ -11,4 +24,138 @@ Asset makeSimAsset(AssetCode12 const& code)
     return out;
 }
 
+SpeedexSimulation
+generateSpeedexSimulation(uint32_t numAssets, uint32_t numOffers, uint32_t numAMMs, uint64_t seed)
+{
+    if (numAssets < 2)
+    {
+        throw std::runtime_error("need at least two assets");
+    }
+    if (numAMMs > (uint64_t) numAssets * (numAssets - 1) / 2)
+    {
+        throw std::runtime_error("more amms than asset pairs");
+    }
+
+    // Draw from gRandomEngine, seeded for this simulation, and put the
+    // engine back afterwards so the caller's random sequence is unaffected.
+    struct RestoreRandomEngine {
+        stellar_default_random_engine mSaved = gRandomEngine;
+        ~RestoreRandomEngine() { gRandomEngine = mSaved; }
+    } restoreRandomEngine;
+    gRandomEngine.seed(seed);
+
+    auto uniformInt = [] (uint64_t lo, uint64_t hi) -> uint64_t {
+        return rand_uniform<uint64_t>(lo, hi);
+    };
+    // 53 random bits, the precision of a double
+    auto uniformReal = [] (double lo, double hi) -> double {
+        constexpr uint64_t RESOLUTION = uint64_t(1) << 53;
+        double fraction = static_cast<double>(rand_uniform<uint64_t>(0, RESOLUTION - 1)) / RESOLUTION;
+        return lo + (hi - lo) * fraction;
+    };
+
+    SpeedexSimulation out;
+
+    std::vector<double> valuations;
+    for (uint32_t i = 0; i < numAssets; i++)
+    {
+        AssetCode12 code;
+        strToAssetCode(code, "SIM" + std::to_string(i));
+        out.config.assets.push_back(code);
+        valuations.push_back(uniformReal(0.5, 2.0));
+    }
+
+    auto randomPair = [&] () -> std::pair<uint32_t, uint32_t> {
+        uint32_t sell = uniformInt(0, numAssets - 1);
+        uint32_t buy = uniformInt(0, numAssets - 2);
+        if (buy >= sell)
+        {
+            buy++;
+        }
+        return {sell, buy};
+    };
+
+    // price denominator; leaves room in int32 for ratios up to ~200
+    constexpr int32_t PRICE_D = 10'000'000;
+
+    for (uint32_t i = 0; i < numOffers; i++)
+    {
+        auto [sell, buy] = randomPair();
+
+        // limit prices within 10% of the exchange rate at the valuations
+        double ratio = valuations[sell] / valuations[buy] * uniformReal(0.9, 1.1);
+
+        SpeedexOffer offer;
+        offer.offerID = i;
+        offer.selling = out.config.assets[sell];
+        offer.buying = out.config.assets[buy];
+        offer.amount = uniformInt(1, 10'000);
+        offer.minPrice.n = static_cast<int32_t>(ratio * PRICE_D);
+        offer.minPrice.d = PRICE_D;
+        out.offers.push_back(offer);
+    }
+
+    std::set<std::pair<uint32_t, uint32_t>> ammPairs;
+    while (ammPairs.size() < numAMMs)
+    {
+        auto [x, y] = randomPair();
+        uint32_t a = std::min(x, y);
+        uint32_t b = std::max(x, y);
+        if (!ammPairs.emplace(a, b).second)
+        {
+            continue;
+        }
+
+        // pool reserves are ordered by asset
+        if (makeSimAsset(out.config.assets[b]) < makeSimAsset(out.config.assets[a]))
+        {
+            std::swap(a, b);
+        }
+
+        // reserves priced at the valuations
+        int64_t amountA = uniformInt(100'000, 1'000'000);
+
+        AMMConfig amm;
+        amm.assetA = out.config.assets[a];
+        amm.assetB = out.config.assets[b];
+        amm.amountA = amountA;
+        amm.amountB = static_cast<int64_t>(amountA * valuations[a] / valuations[b]);
+        out.config.ammConfigs.push_back(amm);
+    }
+
+    return out;
+}
+
+SpeedexSimulation
+loadSpeedexSimulation(std::string const& fileName)
+{
+    std::ifstream file(fileName.c_str());
+    if (!file)
+    {
+        throw std::runtime_error(std::string("nonexistent file ") + fileName);
+    }
+    file.exceptions(std::ios::badbit);
+
+    std::ostringstream input;
+    input << file.rdbuf();
+    auto str = input.str();
+
+    xdr::opaque_vec<> v{str.begin(), str.end()};
+
+    SpeedexSimulation out;
+    xdr::xdr_from_opaque(v, out);
+    return out;
+}
+
+void
+saveSpeedexSimulation(SpeedexSimulation const& sim, std::string const& fileName)
+{
+    auto v = xdr::xdr_to_opaque(sim);
+
+    std::ofstream file;
+    file.exceptions(std::ios::failbit | std::ios::badbit);
+    file.open(fileName, std::ios::binary);
+    file.write(reinterpret_cast<char const*>(v.data()), v.size());
+}
+
 } /* stellar */
@@ -1,9 +1,25 @@
 #pragma once
 
 #include "xdr/Stellar-ledger-entries.h"
+#include "xdr/speedex-sim.h"
+
+#include <cstdint>
+#include <string>
 
 namespace stellar {
 
 Asset makeSimAsset(AssetCode12 const& code);
 
+// A random workload of numOffers offers and numAMMs pools (on distinct asset
+// pairs) over numAssets assets.  Offer prices and pool reserves are scattered
+// around a random valuation of each asset, so that batches trade a nontrivial
+// fraction of their offers.  The same arguments always produce the same
+// simulation.
+SpeedexSimulation
+generateSpeedexSimulation(uint32_t numAssets, uint32_t numOffers, uint32_t numAMMs, uint64_t seed);
+
+// XDR-encoded SpeedexSimulation files
+SpeedexSimulation loadSpeedexSimulation(std::string const& fileName);
+void saveSpeedexSimulation(SpeedexSimulation const& sim, std::string const& fileName);
+
 } /* stellar */
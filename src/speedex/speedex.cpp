@@ -1,8 +1,9 @@
 #include "speedex/speedex.h"
 
 #include "ledger/LedgerTxn.h"
-#include "simplex/solver.h"
+#include "simplex/circulation.h"
 #include "speedex/DemandOracle.h"
+#include "speedex/IOCOrderbookManager.h"
 #include "speedex/LiquidityPoolSetFrame.h"
 #include "speedex/TatonnementControls.h"
 #include "speedex/TatonnementOracle.h"
@@ -11,50 +12,134 @@
 
 #include "transactions/TransactionUtils.h"
 
+#include "util/Logging.h"
 #include "util/XDROperators.h"
 
+#include <Tracy.hpp>
+#include <memory>
+
 namespace stellar 
 {
 
+// Records the clearing prices in the config entry, so that the next ledger
+// warm-starts tatonnement from them.  The entry is ordinary ledger state: it is
+// stored in SQL, and restored from the BucketList on catchup.
+static void
+recordClearingValuations(AbstractLedgerTxn& ltx, SpeedexResults const& results)
+{
+    // Loading for write alone marks the entry as modified, so check first.
+    auto snapshot = ltx.loadSnapshotEntry(speedexConfigKey());
+    if (!snapshot || getLastValuations(snapshot->data.speedexConfig()) == results.valuations)
+    {
+        return;
+    }
+    auto config = loadSpeedexConfig(ltx);
+    prepareSpeedexConfigEntryExtensionV1(config.current().data.speedexConfig())
+        .lastValuations = results.valuations;
+}
+
+static void
+prefetchClearingData(AbstractLedgerTxn& ltx, IOCOrderbookManager const& orderbooks, std::vector<Asset> const& assets)
+{
+    ZoneScoped;
+    UnorderedSet<LedgerKey> keys;
+    orderbooks.insertKeysForClearing(keys);
+    LiquidityPoolSetFrame::insertKeysForPools(assets, keys);
+    auto loaded = ltx.prefetch(keys);
+    CLOG_DEBUG(Speedex, "prefetched {} of {} entries", loaded, keys.size());
+}
+
 SpeedexResults
-runSpeedex(AbstractLedgerTxn& ltx)
+runSpeedex(AbstractLedgerTxn& ltx, bool prefetch, SpeedexBatchMetrics* metrics)
 {
+    ZoneScoped;
+
+    SpeedexBatchMetrics localMetrics;
+    auto& m = metrics ? *metrics : localMetrics;
+
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
 
-    bool printDiagnostics = true;
     auto& speedexOrderbooks = ltx.getSpeedexIOCOffers();
-    speedexOrderbooks.sealBatch();
 
     auto speedexConfig = loadSpeedexConfigSnapshot(ltx);
 
+    AssetIndex assetIndex = speedexConfig.getAssetIndex();
+
+    {
+        ZoneNamedN(sealZone, "speedex seal", true);
+        speedexOrderbooks.sealBatch(assetIndex);
+    }
+
+    m.mNumOffers = speedexOrderbooks.numOffers();
+    m.mNumOrderbooks = speedexOrderbooks.numOpenOrderbooks();
+
+    if (prefetch)
+    {
+        prefetchClearingData(ltx, speedexOrderbooks, speedexConfig.getAssets());
+    }
+
     LiquidityPoolSetFrame liquidityPools(speedexConfig.getAssets(), ltx);
 
     DemandOracle demandOracle(speedexOrderbooks, liquidityPools);
 
+    auto sealed = clock::now();
+
     TatonnementOracle oracle(demandOracle);
 
-    TatonnementControlParams controls = speedexConfig.getControls();
     auto prices = speedexConfig.getStartingPrices();
 
-    oracle.computePrices(controls, prices, printDiagnostics ? 1 : 0);
+    auto winner = oracle.computePricesMultiStart(
+        speedexConfig.getTatonnementInstances(),
+        prices,
+        SpeedexConfigSnapshotFrame::kMultiStartTolN,
+        SpeedexConfigSnapshotFrame::kMultiStartTolD);
+
+    auto const& tatStats = oracle.getLastRunStats();
+    m.mTatonnementRounds = tatStats.mRounds;
+    m.mTatonnementConverged = tatStats.mConverged;
+    m.mObjectiveBits = tatStats.mObjective ? tatStats.mObjective->bitLength() : 0;
 
-    if (printDiagnostics)
+    CLOG_DEBUG(Speedex, "tatonnement instance {} won after {} rounds (converged: {})",
+               winner, tatStats.mRounds, tatStats.mConverged);
+    for (uint32_t i = 0; i < prices.size(); i++)
     {
-        std::printf("PRICES\n");
-        for (auto const& [asset, price] : prices)
-        {
-            std::printf("%llu\n", price);
-        }
+        CLOG_TRACE(Speedex, "price {}: {}",
+                   assetToString(assetIndex.getAsset(i)), prices[i]);
     }
 
-    TradeMaximizingSolver solver(speedexConfig.getAssets());
+    auto priced = clock::now();
 
-    demandOracle.setSolverUpperBounds(solver, prices);
+    MaxCirculationSolver solver(assetIndex);
 
-    solver.doSolve();
+    {
+        ZoneNamedN(solveZone, "speedex solve", true);
+        demandOracle.setSolverUpperBounds(solver, prices);
 
-    BatchSolution solution(solver.getSolution(), prices);
+        solver.doSolve();
+    }
+
+    auto solved = clock::now();
+
+    BatchSolution solution(solver.getSolution(), prices, assetIndex);
+
+    SpeedexResults results;
+    {
+        ZoneNamedN(clearZone, "speedex clear", true);
+        results = speedexOrderbooks.clearBatch(ltx, solution, liquidityPools, &m.mRoundingErrorReturned);
+    }
+
+    recordClearingValuations(ltx, results);
 
-    return speedexOrderbooks.clearBatch(ltx, solution, liquidityPools);
+    auto cleared = clock::now();
+
+    m.mTimings.mSealBatch = sealed - start;
+    m.mTimings.mTatonnement = priced - sealed;
+    m.mTimings.mSolver = solved - priced;
+    m.mTimings.mClearing = cleared - solved;
+
+    return results;
 }
 
 SpeedexConfigEntry
@@ -123,43 +208,67 @@ makeOrderbooks(SpeedexSimulation const& sim)
     return manager;
 }
 
-void
-runSpeedexSim(SpeedexSimulation const& sim)
+SpeedexResults
+runSpeedexSim(SpeedexSimulation const& sim, SpeedexPhaseTimings* timings)
 {
-    SpeedexConfigEntry speedexConfig = makeConfigSim(sim);
-    checkSimOffers(sim, speedexConfig);
+    auto configEntry = std::make_shared<LedgerEntry>();
+    configEntry->data.type(SPEEDEX_CONFIG);
+    configEntry->data.speedexConfig() = makeConfigSim(sim);
+    checkSimOffers(sim, configEntry->data.speedexConfig());
+
+    SpeedexConfigSnapshotFrame speedexConfig(configEntry);
 
     auto orderbooks = makeOrderbooks(sim);
 
-    LiquidityPoolSetFrame lps(sim);
+    LiquidityPoolSetFrame liquidityPools(sim.config);
 
-    DemandOracle demandOracle(speedexOrderbooks, liquidityPools);
+    SpeedexPhaseTimings localTimings;
+    auto& t = timings ? *timings : localTimings;
+
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+
+    AssetIndex assetIndex = speedexConfig.getAssetIndex();
+
+    orderbooks.sealBatch(assetIndex);
+
+    auto sealed = clock::now();
+
+    DemandOracle demandOracle(orderbooks, liquidityPools);
 
     TatonnementOracle oracle(demandOracle);
 
-    TatonnementControlParams controls = speedexConfig.getControls();
     auto prices = speedexConfig.getStartingPrices();
 
-    oracle.computePrices(controls, prices, printDiagnostics ? 1 : 0);
+    oracle.computePricesMultiStart(
+        speedexConfig.getTatonnementInstances(),
+        prices,
+        SpeedexConfigSnapshotFrame::kMultiStartTolN,
+        SpeedexConfigSnapshotFrame::kMultiStartTolD);
 
-    if (printDiagnostics)
-    {
-        std::printf("PRICES\n");
-        for (auto const& [asset, price] : prices)
-        {
-            std::printf("%llu\n", price);
-        }
-    }
+    auto priced = clock::now();
 
-    TradeMaximizingSolver solver(speedexConfig.getAssets());
+    MaxCirculationSolver solver(assetIndex);
 
     demandOracle.setSolverUpperBounds(solver, prices);
 
     solver.doSolve();
 
-    BatchSolution solution(solver.getSolution(), prices);
+    auto solved = clock::now();
+
+    BatchSolution solution(solver.getSolution(), prices, assetIndex);
+
+    auto results = orderbooks.clearSimBatch(solution, liquidityPools);
+
+    auto cleared = clock::now();
+
+    t.mSealBatch = sealed - start;
+    t.mTatonnement = priced - sealed;
+    t.mSolver = solved - priced;
+    t.mClearing = cleared - solved;
 
-    return orderbooks.clearSimBatch(solution, liquidityPools);
+    return results;
 }
 
-} /* stellar */
\ No newline at end of file
+} /* stellar */
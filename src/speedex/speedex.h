@@ -3,12 +3,50 @@
 #include "xdr/Stellar-ledger.h"
 #include "xdr/speedex-sim.h"
 
+#include <chrono>
+
 namespace stellar
 {
 
 class AbstractLedgerTxn;
 
+// Wall-clock time spent in each phase of a batch.
+struct SpeedexPhaseTimings
+{
+    // orderbook sorting and demand query preprocessing
+    std::chrono::nanoseconds mSealBatch{0};
+    std::chrono::nanoseconds mTatonnement{0};
+    std::chrono::nanoseconds mSolver{0};
+    std::chrono::nanoseconds mClearing{0};
+};
+
+// What a batch did, for monitoring (see SpeedexMetrics).
+struct SpeedexBatchMetrics
+{
+    SpeedexPhaseTimings mTimings;
+
+    // of the winning tatonnement instance
+    uint32_t mTatonnementRounds = 0;
+    bool mTatonnementConverged = false;
+    // TatonnementObjectiveFn::bitLength() of the final objective
+    uint32_t mObjectiveBits = 0;
+
+    size_t mNumOffers = 0;
+    size_t mNumOrderbooks = 0;
+
+    // summed across assets
+    int64_t mRoundingErrorReturned = 0;
+};
+
+// With prefetch, bulk-loads every account, trustline and pool that
+// clearing will touch, once the batch is sealed.
+// Fills in metrics, if given.
+SpeedexResults
+runSpeedex(AbstractLedgerTxn& ltx, bool prefetch = false, SpeedexBatchMetrics* metrics = nullptr);
+
+// Runs one batch over a SpeedexSimulation, without any ledger state.
+// Fills in timings, if given.
 SpeedexResults
-runSpeedex(AbstractLedgerTxn& ltx);
+runSpeedexSim(SpeedexSimulation const& sim, SpeedexPhaseTimings* timings = nullptr);
 
-} /* stellar */
\ No newline at end of file
+} /* stellar */
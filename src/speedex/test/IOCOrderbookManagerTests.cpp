@@ -70,19 +70,19 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 
 		std::map<Asset, uint64_t> prices;
 
-		SupplyDemand sd1;
+		SupplyDemand sd1(manager.getAssetIndex());
 
 		prices[assets[0]] = 400;
 		prices[assets[1]] = 100;
-		manager.demandQuery(prices, sd1, 0);
+		manager.demandQuery(PriceVector::fromMap(manager.getAssetIndex(), prices), sd1, 0);
 		REQUIRE(sd1.getDelta(assets[0]) == -400 * amount);
 		REQUIRE(sd1.getDelta(assets[1]) == 400 * amount);
 
 		prices[assets[0]] = 400;
 		prices[assets[1]] = 100;
 
-		SupplyDemand sd2;
-		manager.demandQuery(prices, sd2, 1);
+		SupplyDemand sd2(manager.getAssetIndex());
+		manager.demandQuery(PriceVector::fromMap(manager.getAssetIndex(), prices), sd2, 1);
 		REQUIRE(sd2.getDelta(assets[0]) == -200 * amount);
 		REQUIRE(sd2.getDelta(assets[1]) == 200 * amount);
 	}
@@ -95,13 +95,13 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 
 		std::map<Asset, uint64_t> prices;
 
-		SupplyDemand sd;
+		SupplyDemand sd(manager.getAssetIndex());
 
 		SECTION("eq")
 		{
 			prices[assets[0]] = 300;
 			prices[assets[1]] = 100;
-			manager.demandQuery(prices, sd, 0);
+			manager.demandQuery(PriceVector::fromMap(manager.getAssetIndex(), prices), sd, 0);
 			REQUIRE(sd.getDelta(assets[0]) == 0);
 			REQUIRE(sd.getDelta(assets[1]) == 0);
 		}
@@ -109,7 +109,7 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 		{
 			prices[assets[0]] = 400;
 			prices[assets[1]] = 100;
-			manager.demandQuery(prices, sd, 0);
+			manager.demandQuery(PriceVector::fromMap(manager.getAssetIndex(), prices), sd, 0);
 			REQUIRE(sd.getDelta(assets[0]) == -400 * amount);
 			REQUIRE(sd.getDelta(assets[1]) == 400 * amount);
 		}
@@ -118,7 +118,7 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 		{
 			prices[assets[0]] = 200;
 			prices[assets[1]] = 100;
-			manager.demandQuery(prices, sd, 0);
+			manager.demandQuery(PriceVector::fromMap(manager.getAssetIndex(), prices), sd, 0);
 			REQUIRE(sd.getDelta(assets[0]) == 100 * 3 * amount);
 			REQUIRE(sd.getDelta(assets[1]) == -100 * 3 * amount);
 		}
@@ -133,11 +133,11 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 
 		std::map<Asset, uint64_t> prices;
 
-		SupplyDemand sd1;
+		SupplyDemand sd1(manager.getAssetIndex());
 
 		prices[assets[0]] = 100;
 		prices[assets[1]] = 100;
-		manager.demandQuery(prices, sd1, 0);
+		manager.demandQuery(PriceVector::fromMap(manager.getAssetIndex(), prices), sd1, 0);
 		REQUIRE(sd1.getDelta(assets[0]) == 0);
 		REQUIRE(sd1.getDelta(assets[1]) == 0);
 
@@ -145,8 +145,8 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 		prices[assets[0]] = 500;
 		prices[assets[1]] = 100;
 
-		SupplyDemand sd2;
-		manager.demandQuery(prices, sd2, 0);
+		SupplyDemand sd2(manager.getAssetIndex());
+		manager.demandQuery(PriceVector::fromMap(manager.getAssetIndex(), prices), sd2, 0);
 		REQUIRE(sd2.getDelta(assets[0]) == -500 * amount);
 		REQUIRE(sd2.getDelta(assets[1]) == 500 * amount);
 	}
@@ -159,7 +159,7 @@ TEST_CASE("two asset orderbook manager demand query", "[speedex]")
 
 		std::map<Asset, uint64_t> prices;
 
-		SupplyDemand sd;
+		SupplyDemand sd(manager.getAssetIndex());
 
 		prices[assets[0]] = 200;
 		prices[assets[1]] = 100;
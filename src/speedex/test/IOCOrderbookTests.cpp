@@ -3,12 +3,17 @@
 #include "speedex/IOCOrderbook.h"
 #include "speedex/IOCOffer.h"
 
+#include "crypto/SHA.h"
+
 #include "ledger/AssetPair.h"
 
 #include "test/TxTests.h"
 
 #include "xdr/Stellar-types.h"
 #include "xdr/Stellar-ledger-entries.h"
+#include "xdr/Stellar-transaction.h"
+
+#include <xdrpp/marshal.h>
 
 using namespace stellar;
 using namespace stellar::txtest;
@@ -158,3 +163,78 @@ TEST_CASE("attempt overflow demand query", "[speedex]")
 	REQUIRE(orderbook.cumulativeOfferedForSaleTimesPrice(UINT64_MAX>>2, (UINT64_MAX / INT32_MAX) >> 2, 1) == 0);
 }
 
+
+TEST_CASE("commit child orderbook", "[speedex]")
+{
+	IOCOrderbook expected(genericAssetPair());
+	IOCOrderbook parent(genericAssetPair());
+	IOCOrderbook child(genericAssetPair());
+
+	int64_t amount = 10000;
+
+	for (uint64_t i = 1; i <= 4; i++)
+	{
+		addOffer(expected, 100 + 10 * (i % 3), 100, amount * i, i);
+	}
+
+	addOffer(parent, 110, 100, amount, 1);
+	addOffer(parent, 120, 100, 2 * amount, 2);
+
+	addOffer(child, 100, 100, 3 * amount, 3);
+	addOffer(child, 110, 100, 4 * amount, 4);
+	// same offer as in parent, so counted once
+	addOffer(child, 110, 100, amount, 1);
+
+	parent.commitChild(child);
+
+	expected.doPriceComputationPreprocessing();
+	parent.doPriceComputationPreprocessing();
+
+	auto const& expectedStats = expected.getPrecomputedTatonnementData();
+	auto const& stats = parent.getPrecomputedTatonnementData();
+
+	REQUIRE(stats.size() == expectedStats.size());
+	for (size_t i = 0; i < stats.size(); i++)
+	{
+		REQUIRE(stats[i].marginalPrice == expectedStats[i].marginalPrice);
+		REQUIRE(stats[i].cumulativeOfferedForSale == expectedStats[i].cumulativeOfferedForSale);
+		REQUIRE(stats[i].cumulativeOfferedForSaleTimesPrice == expectedStats[i].cumulativeOfferedForSaleTimesPrice);
+	}
+	REQUIRE(stats.back().cumulativeOfferedForSale == 10 * amount);
+
+	child.doPriceComputationPreprocessing();
+	REQUIRE(child.getPrecomputedTatonnementData().back().cumulativeOfferedForSale == 0);
+}
+
+TEST_CASE("offer ordering hash", "[speedex]")
+{
+	Price p;
+	p.n = 3;
+	p.d = 7;
+
+	AccountID acct = getAccount("blah").getPublicKey();
+
+	SpeedexIOCOfferHashContents contents(acct, p, 5, 2);
+	REQUIRE(IOCOffer::offerHash(p, acct, 5, 2) == sha256(xdr::xdr_to_opaque(contents)));
+
+	IOCOffer o1(100, p, acct, 5, 2);
+	IOCOffer o2(100, p, acct, 6, 2);
+
+	REQUIRE(o1.getTotalOrderingHash() == IOCOffer::offerHash(p, acct, 5, 2));
+	REQUIRE((o1 < o2) == (o1.getTotalOrderingHash() < o2.getTotalOrderingHash()));
+
+	SECTION("price ties keep every offer")
+	{
+		IOCOrderbook orderbook(genericAssetPair());
+		for (uint64_t i = 0; i < 20; i++) {
+			addOffer(orderbook, 1, 1, 10, i);
+			addOffer(orderbook, 1, 2, 10, i);
+		}
+		addOffer(orderbook, 2, 1, 10, 0);
+
+		orderbook.doPriceComputationPreprocessing();
+
+		auto const& stats = orderbook.getPrecomputedTatonnementData();
+		REQUIRE(stats.back().cumulativeOfferedForSale == 410);
+	}
+}
@@ -0,0 +1,97 @@
+#include "lib/catch.hpp"
+
+#include "speedex/LiquidityPoolDemandKernel.h"
+
+#include "util/Math.h"
+#include "util/numeric.h"
+
+#include <limits>
+
+using namespace stellar;
+
+using int128_t = __int128_t;
+using uint128_t = unsigned __int128;
+
+// Same formula as the kernel, with every square root from bigSquareRoot.
+static int128_t
+referenceOffered(int64_t sellReserve, int64_t buyReserve, uint32_t fee, uint64_t sellPrice, uint64_t buyPrice)
+{
+	auto sqrtCeil = [] (uint64_t a, uint64_t b) -> uint64_t {
+		return bigSquareRoot(a, b);
+	};
+	auto sqrtFloor = [&] (uint64_t a, uint64_t b) -> uint64_t {
+		uint64_t x = sqrtCeil(a, b);
+		if (((uint128_t) x) * x > ((uint128_t) a) * b) {
+			return x - 1;
+		}
+		return x;
+	};
+
+	uint64_t tax = (((uint128_t) sellReserve) * fee) / 10000;
+	if (sellReserve == 0 || tax >= (uint64_t) sellReserve) {
+		return 0;
+	}
+	uint64_t afterFee = sellReserve - tax;
+
+	if (((uint128_t) sellPrice) * afterFee < ((uint128_t) buyReserve) * buyPrice) {
+		return 0;
+	}
+
+	uint128_t top = ((uint128_t) sellPrice) * sqrtFloor(sellReserve, afterFee);
+	uint128_t bot = ((uint128_t) sqrtCeil(buyReserve, buyPrice)) * sqrtCeil(sellReserve, sellPrice);
+	if (top <= bot) {
+		return 0;
+	}
+	uint128_t total = top - bot;
+	total -= total % sellPrice;
+	return total;
+}
+
+TEST_CASE("lp demand kernel is exact", "[speedex]")
+{
+	SECTION("random pools")
+	{
+		for (auto trial = 0; trial < 1000; trial++)
+		{
+			int64_t sellReserve = rand_uniform<int64_t>(0, std::numeric_limits<int64_t>::max());
+			int64_t buyReserve = rand_uniform<int64_t>(1, std::numeric_limits<int64_t>::max());
+			uint32_t fee = rand_uniform<uint32_t>(0, 100);
+			uint64_t sellPrice = rand_uniform<uint64_t>(1, std::numeric_limits<uint64_t>::max());
+			uint64_t buyPrice = rand_uniform<uint64_t>(1, std::numeric_limits<uint64_t>::max());
+
+			auto params = LiquidityPoolDemandKernel::makePoolParams(sellReserve, buyReserve, fee);
+			REQUIRE(LiquidityPoolDemandKernel::offeredForSaleTimesSellPrice(params, sellPrice, buyPrice)
+				== referenceOffered(sellReserve, buyReserve, fee, sellPrice, buyPrice));
+		}
+	}
+
+	SECTION("small pools")
+	{
+		for (int64_t sellReserve = 0; sellReserve < 50; sellReserve++)
+		{
+			for (int64_t buyReserve = 1; buyReserve < 50; buyReserve++)
+			{
+				auto params = LiquidityPoolDemandKernel::makePoolParams(sellReserve, buyReserve, 30);
+				for (uint64_t sellPrice = 1; sellPrice < 20; sellPrice++)
+				{
+					auto offered = LiquidityPoolDemandKernel::offeredForSaleTimesSellPrice(params, sellPrice, 3);
+					REQUIRE(offered == referenceOffered(sellReserve, buyReserve, 30, sellPrice, 3));
+					REQUIRE(offered % sellPrice == 0);
+					REQUIRE(offered <= ((int128_t) sellReserve) * sellPrice);
+				}
+			}
+		}
+	}
+
+	SECTION("nothing offered below the pool price")
+	{
+		auto params = LiquidityPoolDemandKernel::makePoolParams(1000, 1000, 0);
+		REQUIRE(LiquidityPoolDemandKernel::offeredForSaleTimesSellPrice(params, 99, 100) == 0);
+		REQUIRE(LiquidityPoolDemandKernel::offeredForSaleTimesSellPrice(params, 100, 100) == 0);
+
+		// exactly 500 at real precision, less after rounding
+		auto offered = LiquidityPoolDemandKernel::offeredForSaleTimesSellPrice(params, 400, 100);
+		REQUIRE(offered > 400 * 490);
+		REQUIRE(offered <= 400 * 500);
+	}
+}
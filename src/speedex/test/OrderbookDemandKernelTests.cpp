@@ -0,0 +1,106 @@
+#include "lib/catch.hpp"
+#include "speedex/IOCOrderbook.h"
+#include "speedex/IOCOffer.h"
+#include "speedex/OrderbookDemandKernel.h"
+#include "speedex/DemandUtils.h"
+#include "speedex/PriceVector.h"
+
+#include "ledger/AssetPair.h"
+
+#include "test/TxTests.h"
+
+#include "util/Math.h"
+
+#include "xdr/Stellar-types.h"
+#include "xdr/Stellar-ledger-entries.h"
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+using int128_t = __int128_t;
+
+static std::vector<Asset> makeAssets(size_t numAssets)
+{
+	auto acct = getAccount("asdf");
+
+	std::vector<Asset> out;
+
+	for (auto i = 0u; i < numAssets; i++)
+	{
+		out.push_back(makeAsset(acct, fmt::format("A{}", i)));
+	}
+
+	return out;
+}
+
+TEST_CASE("demand kernel matches per-orderbook queries", "[speedex]")
+{
+	auto assets = makeAssets(5);
+
+	UnorderedMap<AssetPair, IOCOrderbook, AssetPairHash> orderbooks;
+
+	AccountID acct = getAccount("blah").getPublicKey();
+
+	uint64_t idx = 0;
+	for (auto const& sell : assets)
+	{
+		for (auto const& buy : assets)
+		{
+			if (sell == buy || rand_flip())
+			{
+				continue;
+			}
+			AssetPair tradingPair {
+				.selling = sell,
+				.buying = buy
+			};
+			auto& orderbook = orderbooks.emplace(tradingPair, tradingPair).first->second;
+			auto numOffers = rand_uniform<uint32_t>(0, 50);
+			for (auto i = 0u; i < numOffers; i++)
+			{
+				Price p;
+				p.n = rand_uniform<int32_t>(1, 1000);
+				p.d = rand_uniform<int32_t>(1, 1000);
+				orderbook.addOffer(IOCOffer(rand_uniform<int64_t>(1, 100000), p, acct, idx++, 0));
+			}
+			orderbook.doPriceComputationPreprocessing();
+		}
+	}
+
+	AssetIndex assetIndex(assets);
+
+	OrderbookDemandKernel kernel;
+	kernel.build(orderbooks, assetIndex);
+
+	REQUIRE(kernel.numOrderbooks() == orderbooks.size());
+
+	for (auto trial = 0; trial < 20; trial++)
+	{
+		std::map<Asset, uint64_t> prices;
+		PriceVector kernelPrices(assets.size());
+		for (uint32_t i = 0; i < assets.size(); i++)
+		{
+			prices[assets[i]] = rand_uniform<uint64_t>(1, 1'000'000);
+			kernelPrices[i] = prices[assets[i]];
+		}
+
+		for (uint8_t smoothMult = 0; smoothMult < 8; smoothMult += 3)
+		{
+			SupplyDemand expected(assetIndex);
+			for (auto const& [tradingPair, orderbook] : orderbooks)
+			{
+				auto amount = orderbook.cumulativeOfferedForSaleTimesPrice(prices.at(tradingPair.selling), prices.at(tradingPair.buying), smoothMult);
+				expected.addSupplyDemand(tradingPair, amount);
+
+				auto sellIdx = assetIndex.getIndex(tradingPair.selling);
+				auto buyIdx = assetIndex.getIndex(tradingPair.buying);
+				REQUIRE(kernel.demandQueryOneAssetPair(sellIdx, buyIdx, kernelPrices, smoothMult) == amount);
+			}
+
+			SupplyDemand res(assetIndex);
+			kernel.demandQuery(kernelPrices, res, smoothMult);
+
+			REQUIRE(res.mSupplyDemand == expected.mSupplyDemand);
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#include "lib/catch.hpp"
+
+#include "speedex/sim_utils.h"
+#include "speedex/speedex.h"
+
+#include "util/XDROperators.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace stellar;
+
+TEST_CASE("speedex simulation", "[speedex]")
+{
+	auto sim = generateSpeedexSimulation(5, 1000, 3, 1);
+
+	REQUIRE(sim.config.assets.size() == 5);
+	REQUIRE(sim.offers.size() == 1000);
+	REQUIRE(sim.config.ammConfigs.size() == 3);
+
+	SECTION("generation is deterministic")
+	{
+		REQUIRE(generateSpeedexSimulation(5, 1000, 3, 1) == sim);
+		REQUIRE(!(generateSpeedexSimulation(5, 1000, 3, 2) == sim));
+	}
+
+	SECTION("batch results")
+	{
+		SpeedexPhaseTimings timings;
+		auto results = runSpeedexSim(sim, &timings);
+
+		REQUIRE(results.valuations.size() == 5);
+		REQUIRE(results.offerStatuses.size() > 0);
+
+		for (auto const& status : results.offerStatuses)
+		{
+			auto const& offer = sim.offers.at(status.seqNum);
+			REQUIRE(status.soldAmount >= 0);
+			REQUIRE(status.soldAmount <= offer.amount);
+			REQUIRE(status.boughtAmount >= 0);
+		}
+
+		REQUIRE(runSpeedexSim(sim) == results);
+	}
+}
+
+TEST_CASE("speedex batch bench", "[speedex][bench][!hide]")
+{
+	for (auto [numAssets, numOffers] : std::vector<std::pair<uint32_t, uint32_t>>{{10, 100'000}, {20, 100'000}, {50, 500'000}})
+	{
+		auto sim = generateSpeedexSimulation(numAssets, numOffers, numAssets, 0);
+
+		SpeedexPhaseTimings timings;
+		runSpeedexSim(sim, &timings);
+
+		auto ms = [] (std::chrono::nanoseconds t) {
+			return std::chrono::duration<double, std::milli>(t).count();
+		};
+
+		std::printf("%u assets %u offers: seal %lf ms, tatonnement %lf ms, solver %lf ms, clearing %lf ms\n",
+			numAssets,
+			numOffers,
+			ms(timings.mSealBatch),
+			ms(timings.mTatonnement),
+			ms(timings.mSolver),
+			ms(timings.mClearing));
+	}
+}
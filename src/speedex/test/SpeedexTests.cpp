@@ -8,6 +8,7 @@
 #include "main/Config.h"
 
 #include "speedex/speedex.h"
+#include "speedex/SpeedexConfigEntryFrame.h"
 
 #include "test/TestAccount.h"
 #include "test/TestUtils.h"
@@ -58,7 +59,13 @@ TEST_CASE("3 asset demo", "[speedex]")
 		addOffer(ltx, acct, i, 600, 600, assets[2], assets[0], i);   //  100 / 600
 	}
 
-	auto res = runSpeedex(ltx);
+	SpeedexBatchMetrics metrics;
+	auto res = runSpeedex(ltx, false, &metrics);
+
+	REQUIRE(metrics.mNumOffers == 60);
+	REQUIRE(metrics.mNumOrderbooks == 3);
+	REQUIRE(metrics.mTatonnementRounds > 0);
+	REQUIRE(metrics.mRoundingErrorReturned >= 0);
 }
 
 TEST_CASE("orderbook against lp", "[speedex]")
@@ -230,3 +237,208 @@ TEST_CASE("orderbook against lp", "[speedex]")
 		REQUIRE((bool) !lpRes);
 	} 
 }
+
+TEST_CASE("clearing prices warm start the next batch", "[speedex]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+
+    auto issuer = getIssuanceLimitedAccount(root, "issuer", app->getLedgerManager().getLastMinBalance(2));
+
+    auto trader = root.create("trader", app -> getLedgerManager().getLastMinBalance(10));
+
+    auto assets = makeAssets(2, issuer);
+
+    setNonIssuerTrustlines(trader, assets);
+
+    fundTrader(trader, issuer, assets);
+
+    {
+	    LedgerTxn ltx(app->getLedgerTxnRoot());
+
+		createLiquidityPool(assets[0], assets[1], 1000, 4000, ltx);
+
+		setSpeedexAssets(ltx, assets);
+
+		ltx.commit();
+	}
+
+	{
+		LedgerTxn ltx(app->getLedgerTxnRoot());
+		auto config = loadSpeedexConfigSnapshot(ltx);
+		REQUIRE(!config.hasWarmStart());
+		REQUIRE(config.getStartingPrices() == config.getColdStartingPrices());
+	}
+
+	SpeedexResults res;
+	{
+		LedgerTxn ltx(app -> getLedgerTxnRoot());
+
+		auto acct = trader.getPublicKey();
+		for (int32_t i = 91; i <= 110; i++) {
+			addOffer(ltx, acct, i, 100, 1000, assets[0], assets[1], i);
+		}
+
+		res = runSpeedex(ltx);
+		ltx.commit();
+	}
+
+	REQUIRE(res.valuations.size() == assets.size());
+
+	LedgerTxn ltx(app->getLedgerTxnRoot());
+	auto config = loadSpeedexConfigSnapshot(ltx);
+
+	REQUIRE(config.hasWarmStart());
+
+	auto assetIndex = config.getAssetIndex();
+	auto startingPrices = config.getStartingPrices();
+	for (auto const& valuation : res.valuations)
+	{
+		REQUIRE(startingPrices[assetIndex.getIndex(valuation.asset)] == valuation.price);
+	}
+
+	auto instances = config.getTatonnementInstances();
+	REQUIRE(instances.back().mStartingPrices == config.getColdStartingPrices());
+}
+
+TEST_CASE("speedex config stagnation params", "[speedex]")
+{
+	auto configEntry = std::make_shared<LedgerEntry>();
+	configEntry->data.type(SPEEDEX_CONFIG);
+	auto& sce = configEntry->data.speedexConfig();
+
+	SECTION("defaults")
+	{
+		auto controls = SpeedexConfigSnapshotFrame(configEntry).getControls();
+		REQUIRE(controls.mStagnationRounds == 100);
+		REQUIRE(controls.mStagnationTolN == 1);
+		REQUIRE(controls.mStagnationTolD == 100);
+	}
+	SECTION("set in config")
+	{
+		prepareSpeedexConfigEntryExtensionV2(sce).stagnation = SpeedexStagnationParams{20, 3, 50};
+		auto controls = SpeedexConfigSnapshotFrame(configEntry).getControls();
+		REQUIRE(controls.mStagnationRounds == 20);
+		REQUIRE(controls.mStagnationTolN == 3);
+		REQUIRE(controls.mStagnationTolD == 50);
+	}
+	SECTION("invalid tolerance disables the check")
+	{
+		prepareSpeedexConfigEntryExtensionV2(sce).stagnation = SpeedexStagnationParams{20, 3, 256};
+		REQUIRE(SpeedexConfigSnapshotFrame(configEntry).getControls().mStagnationRounds == 0);
+		prepareSpeedexConfigEntryExtensionV2(sce).stagnation = SpeedexStagnationParams{20, 3, 0};
+		REQUIRE(SpeedexConfigSnapshotFrame(configEntry).getControls().mStagnationRounds == 0);
+		prepareSpeedexConfigEntryExtensionV2(sce).stagnation = SpeedexStagnationParams{20, 4, 3};
+		REQUIRE(SpeedexConfigSnapshotFrame(configEntry).getControls().mStagnationRounds == 0);
+	}
+}
+
+TEST_CASE("speedex config is stored in the database", "[speedex]")
+{
+	Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+
+	std::vector<Asset> assets;
+	xdr::xvector<SpeedexClearingValuation> valuations;
+	{
+		VirtualClock clock;
+		Application::pointer app = createTestApplication(clock, cfg);
+
+		assets = makeAssets(2);
+		for (auto const& asset : assets)
+		{
+			valuations.push_back(SpeedexClearingValuation{asset, 0x200000000});
+		}
+
+		LedgerTxn ltx(app->getLedgerTxnRoot());
+		setSpeedexAssets(ltx, assets);
+		prepareSpeedexConfigEntryExtensionV1(loadSpeedexConfig(ltx).current().data.speedexConfig()).lastValuations = valuations;
+		ltx.commit();
+	}
+
+	SECTION("config survives a restart")
+	{
+		VirtualClock clock;
+		Application::pointer app = createTestApplication(clock, cfg, /*newDB=*/false);
+
+		LedgerTxn ltx(app->getLedgerTxnRoot());
+		auto config = loadSpeedexConfigSnapshot(ltx);
+		REQUIRE(config.getAssets() == assets);
+		REQUIRE(config.hasWarmStart());
+		REQUIRE(getLastValuations(loadSpeedexConfig(ltx).current().data.speedexConfig()) == valuations);
+	}
+
+	SECTION("config is not shared with other nodes")
+	{
+		VirtualClock clock;
+		Application::pointer app = createTestApplication(clock, getTestConfig(1));
+
+		LedgerTxn ltx(app->getLedgerTxnRoot());
+		auto config = loadSpeedexConfigSnapshot(ltx);
+		REQUIRE(config.getAssets().empty());
+		REQUIRE(!config.hasWarmStart());
+	}
+}
+
+TEST_CASE("parallel clearing is deterministic", "[speedex]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+
+    auto issuer = getIssuanceLimitedAccount(root, "issuer", app->getLedgerManager().getLastMinBalance(2));
+
+    auto trader = root.create("trader", app -> getLedgerManager().getLastMinBalance(10));
+
+    auto assets = makeAssets(4, issuer);
+
+    setNonIssuerTrustlines(trader, assets);
+
+    fundTrader(trader, issuer, assets);
+
+    {
+	    LedgerTxn ltx(app->getLedgerTxnRoot());
+
+		createLiquidityPool(assets[0], assets[1], 10000, 10000, ltx);
+
+		setSpeedexAssets(ltx, assets);
+
+		ltx.commit();
+	}
+
+	auto acct = trader.getPublicKey();
+
+	auto runBatch = [&] (bool prefetch) {
+		LedgerTxn ltx(app -> getLedgerTxnRoot());
+
+		uint64_t idx = 0;
+		for (int32_t i = 91; i <= 110; i++) {
+			for (size_t sell = 0; sell < assets.size(); sell++) {
+				for (size_t buy = 0; buy < assets.size(); buy++) {
+					if (sell != buy) {
+						addOffer(ltx, acct, i, 100, 100, assets[sell], assets[buy], idx++);
+					}
+				}
+			}
+		}
+		return runSpeedex(ltx, prefetch);
+	};
+
+	auto res1 = runBatch(false);
+	auto res2 = runBatch(false);
+
+	REQUIRE(res1.offerStatuses.size() > 0);
+	REQUIRE(res1 == res2);
+
+	SECTION("prefetching doesn't change results")
+	{
+		REQUIRE(runBatch(true) == res1);
+	}
+}
@@ -35,12 +35,14 @@ TEST_CASE("objective function", "[speedex]")
 {
 	using int128_t = __int128;
 
-	SupplyDemand demands1, demands2;
-
 	auto assets = makeAssets(10);
 
-	demands1.mSupplyDemand[assets[0]] = {10000, 0};
-	demands2.mSupplyDemand[assets[0]] = {10001, 0};
+	AssetIndex assetIndex(assets);
+
+	SupplyDemand demands1(assetIndex), demands2(assetIndex);
+
+	demands1.mSupplyDemand[assetIndex.getIndex(assets[0])] = {10000, 0};
+	demands2.mSupplyDemand[assetIndex.getIndex(assets[0])] = {10001, 0};
 
 	TatonnementObjectiveFn obj1 = demands1.getObjective(), obj2 = demands2.getObjective();
 
@@ -90,3 +92,72 @@ TEST_CASE("price adjust", "[speedex]")
 
 	REQUIRE(wrapper.setTrialPrice(startingPrice, demand, 0) > 0);
 }
+
+TEST_CASE("stagnation stops tatonnement", "[speedex]")
+{
+	auto assets = makeAssets(2);
+	AssetIndex assetIndex(assets);
+
+	auto objectiveWithSupply = [&] (int64_t supply) {
+		SupplyDemand demands(assetIndex);
+		demands.mSupplyDemand[0] = {supply, 0};
+		return demands.getObjective();
+	};
+
+	TatonnementControlParams params;
+	params.mMaxRounds = 1000;
+	params.mStagnationRounds = 10;
+	params.mStagnationTolN = 1;
+	params.mStagnationTolD = 10;
+
+	TatonnementControlParamsWrapper wrapper(params);
+
+	auto runRound = [&] (int64_t supply) {
+		wrapper.incrementRound();
+		wrapper.recordObjective(objectiveWithSupply(supply));
+	};
+
+	wrapper.recordObjective(objectiveWithSupply(100000));
+
+	SECTION("flat objective")
+	{
+		for (int i = 0; i < 9; i++) {
+			runRound(100000);
+			REQUIRE(!wrapper.done());
+		}
+		runRound(100000);
+		REQUIRE(wrapper.done());
+		REQUIRE(wrapper.stagnated());
+	}
+
+	SECTION("small improvements don't reset the clock")
+	{
+		int64_t supply = 100000;
+		for (int i = 0; i < 10; i++) {
+			supply -= 100;
+			runRound(supply);
+		}
+		REQUIRE(wrapper.stagnated());
+	}
+
+	SECTION("large improvements reset the clock")
+	{
+		int64_t supply = 100000;
+		for (int i = 0; i < 15; i++) {
+			supply = supply / 2;
+			runRound(supply);
+			REQUIRE(!wrapper.done());
+		}
+	}
+
+	SECTION("disabled")
+	{
+		params.mStagnationRounds = 0;
+		TatonnementControlParamsWrapper disabled(params);
+		for (int i = 0; i < 100; i++) {
+			disabled.incrementRound();
+			disabled.recordObjective(objectiveWithSupply(100000));
+		}
+		REQUIRE(!disabled.done());
+	}
+}
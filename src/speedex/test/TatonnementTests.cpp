@@ -4,6 +4,8 @@
 #include "speedex/IOCOrderbookManager.h"
 
 #include "speedex/DemandOracle.h"
+#include "speedex/DemandUtils.h"
+#include "speedex/IncrementalDemandOracle.h"
 #include "speedex/TatonnementOracle.h"
 #include "speedex/TatonnementControls.h"
 
@@ -19,6 +21,8 @@
 
 #include "transactions/TransactionUtils.h"
 
+#include "util/Math.h"
+
 #include "xdr/Stellar-types.h"
 #include "xdr/Stellar-ledger-entries.h"
 
@@ -126,3 +130,181 @@ TEST_CASE("trade offers against a liquidity pool", "[speedex][tatonnement]")
 }
 
 
+
+TEST_CASE("multistart tatonnement is deterministic", "[speedex][tatonnement]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+
+	auto assets = makeAssets(2);
+
+	LiquidityPoolSetFrame lpFrame({}, ltx);
+
+	auto acct = getAccount("blah").getPublicKey();
+	for (int32_t i = 90; i < 110; i++) {
+		addOffer(ltx, acct, i, 100, 1000, assets[0], assets[1], i);
+		addOffer(ltx, acct, i, 100, 1000, assets[1], assets[0], i+100);
+	}
+
+	auto& manager = ltx.getSpeedexIOCOffers();
+
+	manager.sealBatch();
+
+	TatonnementControlParams controls
+	{
+		.mTaxRate = 5,
+		.mSmoothMult = 5,
+		.mMaxRounds = 1000,
+		.mStepUp = 45,
+		.mStepDown = 25,
+		.mStepSizeRadix = 5,
+		.mStepRadix = 65
+	};
+
+	std::vector<TatonnementInstanceParams> instances;
+	for (auto const& [stepUp, stepDown] : std::vector<std::pair<uint8_t, uint8_t>>{{45, 25}, {38, 28}, {56, 20}})
+	{
+		auto instanceControls = controls;
+		instanceControls.mStepUp = stepUp;
+		instanceControls.mStepDown = stepDown;
+		instances.push_back({instanceControls, std::nullopt});
+	}
+
+	DemandOracle demandOracle(manager, lpFrame);
+
+	std::map<Asset, uint64_t> startingPriceMap;
+	startingPriceMap[assets[0]] = 100000;
+	startingPriceMap[assets[1]] = 100;
+
+	auto startingPrices = PriceVector::fromMap(demandOracle.getAssetIndex(), startingPriceMap);
+
+	auto run = [&] (uint8_t tolN, uint8_t tolD) {
+		TatonnementOracle oracle(demandOracle);
+		auto prices = startingPrices;
+		auto winner = oracle.computePricesMultiStart(instances, prices, tolN, tolD);
+		return std::make_pair(winner, prices);
+	};
+
+	SECTION("with tolerance")
+	{
+		auto res1 = run(1, 200);
+		auto res2 = run(1, 200);
+		REQUIRE(res1 == res2);
+
+		auto startObjective = demandOracle.demandQuery(startingPrices, controls.mSmoothMult).getObjective();
+		auto endObjective = demandOracle.demandQuery(res1.second, controls.mSmoothMult).getObjective();
+		REQUIRE(endObjective.isBetterThan(startObjective, 0, 1));
+	}
+	SECTION("no instance converges")
+	{
+		auto res1 = run(0, 1);
+		auto res2 = run(0, 1);
+		REQUIRE(res1 == res2);
+	}
+	SECTION("single instance matches serial tatonnement")
+	{
+		instances.resize(1);
+		auto res = run(0, 1);
+		REQUIRE(res.first == 0);
+
+		TatonnementOracle oracle(demandOracle);
+		auto prices = startingPrices;
+		oracle.computePrices(controls, prices);
+		REQUIRE(prices == res.second);
+	}
+}
+
+TEST_CASE("incremental demand oracle matches full queries", "[speedex][tatonnement]")
+{
+	Config cfg(getTestConfig());
+	cfg.LEDGER_PROTOCOL_VERSION = 17;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg);
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+
+	auto assets = makeAssets(4);
+
+	createLiquidityPool(assets[0], assets[1], 10000, 100000, ltx);
+	createLiquidityPool(assets[2], assets[3], 5000, 20000, ltx);
+
+	LiquidityPoolSetFrame lpFrame(assets, ltx);
+
+	auto acct = getAccount("blah").getPublicKey();
+	uint64_t offerIdx = 0;
+	for (int32_t i = 90; i < 110; i++) {
+		addOffer(ltx, acct, i, 100, 1000, assets[0], assets[1], offerIdx++);
+		addOffer(ltx, acct, i, 100, 1000, assets[1], assets[2], offerIdx++);
+		addOffer(ltx, acct, i, 100, 1000, assets[3], assets[0], offerIdx++);
+	}
+
+	auto& manager = ltx.getSpeedexIOCOffers();
+	manager.sealBatch(AssetIndex(assets));
+
+	DemandOracle demandOracle(manager, lpFrame);
+
+	const uint8_t smoothMult = 5;
+	IncrementalDemandOracle incremental(demandOracle, smoothMult);
+
+	PriceVector prices(assets.size(), 1000);
+	incremental.reset(prices);
+	REQUIRE(incremental.getSupplyDemand().mSupplyDemand 
+		== demandOracle.demandQuery(prices, smoothMult).mSupplyDemand);
+
+	for (auto round = 0; round < 100; round++)
+	{
+		// move a random subset of prices
+		PriceVector trial = prices;
+		for (uint32_t i = 0; i < trial.size(); i++)
+		{
+			if (rand_flip())
+			{
+				trial[i] = rand_uniform<uint64_t>(100, 10000);
+			}
+		}
+
+		auto const& trialDemand = incremental.trialQuery(trial);
+		REQUIRE(trialDemand.mSupplyDemand 
+			== demandOracle.demandQuery(trial, smoothMult).mSupplyDemand);
+
+		if (rand_flip())
+		{
+			incremental.accept();
+			prices = trial;
+		} 
+		else
+		{
+			incremental.reject();
+		}
+
+		REQUIRE(incremental.getSupplyDemand().mSupplyDemand 
+			== demandOracle.demandQuery(prices, smoothMult).mSupplyDemand);
+	}
+
+	SECTION("unchanged prices recompute nothing")
+	{
+		incremental.trialQuery(prices);
+		REQUIRE(incremental.numRecomputedPairs() == 0);
+		incremental.reject();
+	}
+	SECTION("one price change recomputes only adjacent pairs")
+	{
+		PriceVector trial = prices;
+		trial[2] += 1;
+		incremental.trialQuery(trial);
+
+		size_t adjacentPairs = 0;
+		for (auto const& [sellIdx, buyIdx] : demandOracle.getActivePairs())
+		{
+			if (sellIdx == 2 || buyIdx == 2)
+			{
+				adjacentPairs++;
+			}
+		}
+		REQUIRE(adjacentPairs < demandOracle.getActivePairs().size());
+		REQUIRE(incremental.numRecomputedPairs() == adjacentPairs);
+		incremental.accept();
+	}
+}
@@ -328,6 +328,25 @@ FeeBumpTransactionFrame::getResult()
     return mResult;
 }
 
+TransactionFrameBase::ApplyState
+FeeBumpTransactionFrame::saveApplyState() const
+{
+    ApplyState state;
+    state.mResult = mResult;
+    state.mInnerResult = mInnerTx->saveApplyState().mResult;
+    return state;
+}
+
+void
+FeeBumpTransactionFrame::restoreApplyState(ApplyState const& state)
+{
+    releaseAssert(state.mInnerResult);
+    mResult = state.mResult;
+    ApplyState inner;
+    inner.mResult = *state.mInnerResult;
+    mInnerTx->restoreApplyState(inner);
+}
+
 TransactionResultCode
 FeeBumpTransactionFrame::getResultCode() const
 {
@@ -498,4 +517,17 @@ FeeBumpTransactionFrame::toStellarMessage() const
     msg.transaction() = mEnvelope;
     return msg;
 }
+
+void
+FeeBumpTransactionFrame::appendSignedPayloads(
+    std::vector<SignedPayload>& out) const
+{
+    SignedPayload payload;
+    payload.mContentsHash = getContentsHash();
+    payload.mSignatures = mEnvelope.feeBump().signatures;
+    payload.mSigningAccounts.push_back(getFeeSourceID());
+    out.push_back(std::move(payload));
+
+    mInnerTx->appendSignedPayloads(out);
+}
 }
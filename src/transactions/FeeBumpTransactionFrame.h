@@ -78,6 +78,8 @@ class FeeBumpTransactionFrame : public TransactionFrameBase
     uint32_t getNumOperations() const override;
 
     TransactionResult& getResult() override;
+    ApplyState saveApplyState() const override;
+    void restoreApplyState(ApplyState const& state) override;
     TransactionResultCode getResultCode() const override;
 
     SequenceNumber getSeqNum() const override;
@@ -114,6 +116,8 @@ class FeeBumpTransactionFrame : public TransactionFrameBase
 
     StellarMessage toStellarMessage() const override;
 
+    void appendSignedPayloads(std::vector<SignedPayload>& out) const override;
+
     static TransactionEnvelope
     convertInnerTxToV1(TransactionEnvelope const& envelope);
 };
@@ -0,0 +1,150 @@
+#include "transactions/SignatureVerificationBatch.h"
+
+#include "crypto/ByteSlice.h"
+#include "crypto/KeyUtils.h"
+#include "crypto/SecretKey.h"
+#include "crypto/SignerKey.h"
+#include "ledger/LedgerTxn.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "transactions/SignatureUtils.h"
+#include "transactions/TransactionUtils.h"
+
+#include <Tracy.hpp>
+
+#include <algorithm>
+
+namespace stellar
+{
+
+std::vector<PublicKey> const&
+SignatureVerificationBatch::getSignerKeys(AccountID const& accountID,
+                                          AbstractLedgerTxn& ltx)
+{
+    auto iter = mSignerKeys.find(accountID);
+    if (iter != mSignerKeys.end())
+    {
+        return iter->second;
+    }
+
+    // Mirrors the signers TransactionFrame::checkSignature() considers,
+    // except that weights are ignored.
+    std::vector<PublicKey> keys;
+    auto account = ltx.loadWithoutRecord(accountKey(accountID));
+    if (!account)
+    {
+        keys.push_back(accountID);
+    }
+    else
+    {
+        auto const& acc = account.current().data.account();
+        if (acc.thresholds[0])
+        {
+            keys.push_back(acc.accountID);
+        }
+        for (auto const& signer : acc.signers)
+        {
+            if (signer.key.type() == SIGNER_KEY_TYPE_ED25519)
+            {
+                keys.push_back(KeyUtils::convertKey<PublicKey>(signer.key));
+            }
+        }
+    }
+    return mSignerKeys.emplace(accountID, std::move(keys)).first->second;
+}
+
+void
+SignatureVerificationBatch::addPayloads(
+    std::vector<SignedPayload> const& payloads, AbstractLedgerTxn& ltx)
+{
+    for (auto const& payload : payloads)
+    {
+        for (auto const& accountID : payload.mSigningAccounts)
+        {
+            for (auto const& key : getSignerKeys(accountID, ltx))
+            {
+                for (auto const& sig : payload.mSignatures)
+                {
+                    if (SignatureUtils::doesHintMatch(key.ed25519(), sig.hint))
+                    {
+                        mItems.push_back(Item{key, sig.signature,
+                                              payload.mContentsHash});
+                    }
+                }
+            }
+        }
+    }
+}
+
+void
+SignatureVerificationBatch::addTransaction(TransactionFrameBase const& tx,
+                                           AbstractLedgerTxn& ltx)
+{
+    std::vector<SignedPayload> payloads;
+    tx.appendSignedPayloads(payloads);
+    addPayloads(payloads, ltx);
+}
+
+void
+SignatureVerificationBatch::addTransactions(
+    std::vector<TransactionFrameBasePtr> const& txs, AbstractLedgerTxn& ltx)
+{
+    ZoneScoped;
+
+    std::vector<std::vector<SignedPayload>> payloads(txs.size());
+    UnorderedSet<LedgerKey> keys;
+    for (size_t i = 0; i < txs.size(); i++)
+    {
+        txs[i]->appendSignedPayloads(payloads[i]);
+        for (auto const& payload : payloads[i])
+        {
+            for (auto const& accountID : payload.mSigningAccounts)
+            {
+                if (mSignerKeys.find(accountID) == mSignerKeys.end())
+                {
+                    keys.emplace(accountKey(accountID));
+                }
+            }
+        }
+    }
+
+    // load every signing account in one go, rather than one at a time in
+    // getSignerKeys()
+    ltx.prefetch(keys);
+
+    for (auto const& p : payloads)
+    {
+        addPayloads(p, ltx);
+    }
+}
+
+void
+SignatureVerificationBatch::verifyInBackground(Application& app)
+{
+    ZoneScoped;
+
+    size_t numJobs = std::min<size_t>(
+        std::max(1, app.getConfig().WORKER_THREADS), mItems.size());
+
+    for (size_t j = 0; j < numJobs; j++)
+    {
+        auto chunk = std::make_shared<std::vector<Item>>();
+        for (size_t i = j; i < mItems.size(); i += numJobs)
+        {
+            chunk->push_back(mItems[i]);
+        }
+        app.postOnBackgroundThread(
+            [chunk]() {
+                ZoneNamedN(verifyZone, "background signature verify", true);
+                for (auto const& item : *chunk)
+                {
+                    PubKeyUtils::verifySig(item.mKey, item.mSignature,
+                                           item.mContentsHash);
+                }
+            },
+            "SignatureVerificationBatch");
+    }
+    mItems.clear();
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "transactions/TransactionFrameBase.h"
+
+#include "util/UnorderedMap.h"
+
+#include <vector>
+
+namespace stellar
+{
+
+class AbstractLedgerTxn;
+class Application;
+
+/*
+ Verifies the ed25519 signatures of many transactions at once, ahead of
+ the serial SignatureChecker pass.
+
+ Gathering candidate signers reads ledger state, so addTransaction() runs
+ on the calling thread.  The signature checks themselves are independent,
+ and verifyInBackground() hands them to worker threads.  Results only go
+ into the process-wide verify cache (see PubKeyUtils::verifySig), so the
+ serial checks that follow see cache hits, and behave exactly as without
+ the batch.
+*/
+class SignatureVerificationBatch
+{
+    struct Item
+    {
+        PublicKey mKey;
+        Signature mSignature;
+        Hash mContentsHash;
+    };
+
+    std::vector<Item> mItems;
+
+    // candidate ed25519 signer keys, by account
+    UnorderedMap<AccountID, std::vector<PublicKey>> mSignerKeys;
+
+    std::vector<PublicKey> const& getSignerKeys(AccountID const& accountID,
+                                                AbstractLedgerTxn& ltx);
+
+    void addPayloads(std::vector<SignedPayload> const& payloads,
+                     AbstractLedgerTxn& ltx);
+
+  public:
+    // Queues each signature of tx against every candidate signer with a
+    // matching hint.  Only reads from ltx.
+    void addTransaction(TransactionFrameBase const& tx, AbstractLedgerTxn& ltx);
+
+    // Same as addTransaction() for each of txs, but prefetches all of their
+    // signing accounts first.
+    void addTransactions(std::vector<TransactionFrameBasePtr> const& txs,
+                         AbstractLedgerTxn& ltx);
+
+    // Hands the queued signatures to app's worker threads, and returns
+    // without waiting.  For work the main thread will get to later (e.g.
+    // validating a tx set just received from a peer): whatever has been
+    // verified by then is a cache hit, and the rest is verified inline as
+    // usual.  Clears the queue.
+    void verifyInBackground(Application& app);
+
+    size_t
+    size() const
+    {
+        return mItems.size();
+    }
+};
+
+}
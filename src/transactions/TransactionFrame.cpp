@@ -459,6 +459,36 @@ TransactionFrame::resetResults(LedgerHeader const& header, int64_t baseFee,
     getResult().feeCharged = getFee(header, baseFee, applying);
 }
 
+TransactionFrameBase::ApplyState
+TransactionFrame::saveApplyState() const
+{
+    ApplyState state;
+    state.mResult = mResult;
+    return state;
+}
+
+void
+TransactionFrame::restoreApplyState(ApplyState const& state)
+{
+    mCachedAccount.reset();
+    mResult = state.mResult;
+
+    // the operations hold references into the op results, which the
+    // assignment may have reallocated
+    auto code = mResult.result.code();
+    if (code == txSUCCESS || code == txFAILED)
+    {
+        auto& ops = getXDROperations();
+        releaseAssert(mResult.result.results().size() == ops.size());
+        mOperations.clear();
+        for (size_t i = 0; i < ops.size(); i++)
+        {
+            mOperations.push_back(
+                makeOperation(ops[i], mResult.result.results()[i], i));
+        }
+    }
+}
+
 xdr::pointer<TimeBounds> const&
 TransactionFrame::getTimeBounds() const
 {
@@ -1087,4 +1117,22 @@ TransactionFrame::toStellarMessage() const
     msg.transaction() = mEnvelope;
     return msg;
 }
+
+void
+TransactionFrame::appendSignedPayloads(std::vector<SignedPayload>& out) const
+{
+    SignedPayload payload;
+    payload.mContentsHash = getContentsHash();
+    payload.mSignatures = getSignatures(mEnvelope);
+    payload.mSigningAccounts.push_back(getSourceID());
+    for (auto const& op : mOperations)
+    {
+        payload.mSigningAccounts.push_back(op->getSourceID());
+    }
+    std::sort(payload.mSigningAccounts.begin(), payload.mSigningAccounts.end());
+    payload.mSigningAccounts.erase(std::unique(payload.mSigningAccounts.begin(),
+                                               payload.mSigningAccounts.end()),
+                                   payload.mSigningAccounts.end());
+    out.push_back(std::move(payload));
+}
 }
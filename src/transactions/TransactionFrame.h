@@ -157,6 +157,9 @@ class TransactionFrame : public TransactionFrameBase
         return getResult().result.code();
     }
 
+    ApplyState saveApplyState() const override;
+    void restoreApplyState(ApplyState const& state) override;
+
     void resetResults(LedgerHeader const& header, int64_t baseFee,
                       bool applying);
 
@@ -235,6 +238,8 @@ class TransactionFrame : public TransactionFrameBase
 
     StellarMessage toStellarMessage() const override;
 
+    void appendSignedPayloads(std::vector<SignedPayload>& out) const override;
+
     LedgerTxnEntry loadAccount(AbstractLedgerTxn& ltx,
                                LedgerTxnHeader const& header,
                                AccountID const& accountID);
@@ -8,6 +8,7 @@
 #include "overlay/StellarXDR.h"
 #include "util/UnorderedSet.h"
 #include "herder/TransactionCommutativityRequirements.h"
+#include <optional>
 
 namespace stellar
 {
@@ -19,9 +20,27 @@ class OperationFrame;
 class TransactionFrameBase;
 using TransactionFrameBasePtr = std::shared_ptr<TransactionFrameBase>;
 
+// A list of signatures on a transaction, with the hash they sign and the
+// accounts whose signers may have produced them.
+struct SignedPayload
+{
+    Hash mContentsHash;
+    xdr::xvector<DecoratedSignature, 20> mSignatures;
+    std::vector<AccountID> mSigningAccounts;
+};
+
 class TransactionFrameBase
 {
   public:
+    // Everything apply changes on the frame itself, so that an apply whose
+    // ledger changes are thrown away can be undone.
+    struct ApplyState
+    {
+        TransactionResult mResult;
+        // result of the inner transaction, for fee bumps
+        std::optional<TransactionResult> mInnerResult;
+    };
+
     static TransactionFrameBasePtr
     makeTransactionFromWire(Hash const& networkID,
                             TransactionEnvelope const& env);
@@ -46,6 +65,8 @@ class TransactionFrameBase
     virtual uint32_t getNumOperations() const = 0;
 
     virtual TransactionResult& getResult() = 0;
+    virtual ApplyState saveApplyState() const = 0;
+    virtual void restoreApplyState(ApplyState const& state) = 0;
     virtual TransactionResultCode getResultCode() const = 0;
 
     virtual SequenceNumber getSeqNum() const = 0;
@@ -78,5 +99,8 @@ class TransactionFrameBase
     virtual void processFeeSeqNum(AbstractLedgerTxn& ltx, int64_t baseFee) = 0;
 
     virtual StellarMessage toStellarMessage() const = 0;
+
+    // Appends every SignedPayload of this transaction (two for fee bumps).
+    virtual void appendSignedPayloads(std::vector<SignedPayload>& out) const = 0;
 };
 }
@@ -89,6 +89,34 @@ prepareLedgerEntryExtensionV1(LedgerEntry& le)
     return le.ext.v1();
 }
 
+SpeedexConfigEntryExtensionV1&
+prepareSpeedexConfigEntryExtensionV1(SpeedexConfigEntry& sce)
+{
+    if (sce.ext.v() == 0)
+    {
+        sce.ext.v(1);
+    }
+    return sce.ext.v1();
+}
+
+SpeedexConfigEntryExtensionV2&
+prepareSpeedexConfigEntryExtensionV2(SpeedexConfigEntry& sce)
+{
+    auto& extV1 = prepareSpeedexConfigEntryExtensionV1(sce);
+    if (extV1.ext.v() == 0)
+    {
+        extV1.ext.v(2);
+    }
+    return extV1.ext.v2();
+}
+
+xdr::xvector<SpeedexClearingValuation> const&
+getLastValuations(SpeedexConfigEntry const& sce)
+{
+    static xdr::xvector<SpeedexClearingValuation> const noValuations;
+    return sce.ext.v() == 0 ? noValuations : sce.ext.v1().lastValuations;
+}
+
 AccountEntryExtensionV2&
 getAccountEntryExtensionV2(AccountEntry& ae)
 {
@@ -44,6 +44,14 @@ TrustLineEntry::_ext_t::_v1_t&
 prepareTrustLineEntryExtensionV1(TrustLineEntry& tl);
 TrustLineEntryExtensionV2& prepareTrustLineEntryExtensionV2(TrustLineEntry& tl);
 LedgerEntryExtensionV1& prepareLedgerEntryExtensionV1(LedgerEntry& le);
+SpeedexConfigEntryExtensionV1&
+prepareSpeedexConfigEntryExtensionV1(SpeedexConfigEntry& sce);
+SpeedexConfigEntryExtensionV2&
+prepareSpeedexConfigEntryExtensionV2(SpeedexConfigEntry& sce);
+
+// empty if sce has no v1 extension
+xdr::xvector<SpeedexClearingValuation> const&
+getLastValuations(SpeedexConfigEntry const& sce);
 
 AccountEntryExtensionV2& getAccountEntryExtensionV2(AccountEntry& ae);
 AccountEntryExtensionV3& getAccountEntryExtensionV3(AccountEntry& ae);
@@ -0,0 +1,98 @@
+#include "transactions/SignatureVerificationBatch.h"
+
+#include "crypto/SecretKey.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "transactions/TransactionFrame.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+TEST_CASE("signature verification batch in background", "[tx][signature]")
+{
+    Config cfg = getTestConfig();
+
+    VirtualClock clock;
+    auto app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+    const int64_t paymentAmount = app->getLedgerManager().getLastReserve() * 10;
+
+    auto a1 = root.create("a1", paymentAmount);
+    auto b1 = root.create("b1", paymentAmount);
+
+    auto tx = a1.tx({b1.op(payment(root, 110))});
+    tx->addSignature(b1.getSecretKey());
+
+    PubKeyUtils::clearVerifySigCache();
+    uint64_t hits, misses;
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        SignatureVerificationBatch batch;
+        batch.addTransaction(*tx, ltx);
+        REQUIRE(batch.size() == 2);
+        batch.verifyInBackground(*app);
+        REQUIRE(batch.size() == 0);
+    }
+
+    uint64_t totalMisses = 0;
+    for (int i = 0; i < 500 && totalMisses < 2; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+        totalMisses += misses;
+    }
+    REQUIRE(totalMisses == 2);
+
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+    REQUIRE(tx->checkValid(ltx, 0, 0, 0));
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(misses == 0);
+}
+
+TEST_CASE("signature verification batch of transactions", "[tx][signature]")
+{
+    Config cfg = getTestConfig();
+
+    VirtualClock clock;
+    auto app = createTestApplication(clock, cfg);
+
+    auto root = TestAccount::createRoot(*app);
+    const int64_t paymentAmount = app->getLedgerManager().getLastReserve() * 10;
+
+    auto a1 = root.create("a1", paymentAmount);
+    auto b1 = root.create("b1", paymentAmount);
+
+    auto tx1 = a1.tx({b1.op(payment(root, 110))});
+    tx1->addSignature(b1.getSecretKey());
+    auto tx2 = b1.tx({payment(root, 120)});
+    std::vector<TransactionFrameBasePtr> txs{tx1, tx2};
+
+    size_t expected = 0;
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        SignatureVerificationBatch batch;
+        for (auto const& tx : txs)
+        {
+            batch.addTransaction(*tx, ltx);
+        }
+        expected = batch.size();
+    }
+    REQUIRE(expected == 3);
+
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+    SignatureVerificationBatch batch;
+    batch.addTransactions(txs, ltx);
+    REQUIRE(batch.size() == expected);
+}
@@ -21,6 +21,7 @@
 #include <io.h>
 #else
 #include <dirent.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
 #endif
@@ -409,6 +410,63 @@ size(std::string const& filename)
 
 #ifdef _WIN32
 
+MappedFile::MappedFile(std::string const& path)
+{
+    ZoneScoped;
+    mFile = ::CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (mFile == INVALID_HANDLE_VALUE)
+    {
+        FileSystemException::failWithGetLastError(
+            std::string("fs::MappedFile() failed on CreateFile(\"") + path +
+            std::string("\"): "));
+    }
+    LARGE_INTEGER sz;
+    if (!::GetFileSizeEx(mFile, &sz))
+    {
+        ::CloseHandle(mFile);
+        FileSystemException::failWithGetLastError(
+            "fs::MappedFile() failed on GetFileSizeEx(): ");
+    }
+    mSize = static_cast<size_t>(sz.QuadPart);
+    if (mSize == 0)
+    {
+        return;
+    }
+    mMapping = ::CreateFileMapping(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mMapping == NULL)
+    {
+        ::CloseHandle(mFile);
+        FileSystemException::failWithGetLastError(
+            "fs::MappedFile() failed on CreateFileMapping(): ");
+    }
+    mData = static_cast<char const*>(
+        ::MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if (mData == nullptr)
+    {
+        ::CloseHandle(mMapping);
+        ::CloseHandle(mFile);
+        FileSystemException::failWithGetLastError(
+            "fs::MappedFile() failed on MapViewOfFile(): ");
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData)
+    {
+        ::UnmapViewOfFile(mData);
+    }
+    if (mMapping != NULL)
+    {
+        ::CloseHandle(mMapping);
+    }
+    if (mFile != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(mFile);
+    }
+}
+
 int
 getMaxConnections()
 {
@@ -418,6 +476,51 @@ getMaxConnections()
 }
 
 #else
+MappedFile::MappedFile(std::string const& path)
+{
+    ZoneScoped;
+    int fd;
+    while ((fd = ::open(path.c_str(), O_RDONLY)) == -1)
+    {
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        FileSystemException::failWithErrno(
+            std::string("fs::MappedFile(\"") + path + "\") failed: ");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        FileSystemException::failWithErrno("fs::MappedFile() fstat failed: ");
+    }
+    mSize = static_cast<size_t>(st.st_size);
+    if (mSize != 0)
+    {
+        void* p = ::mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close(fd);
+            FileSystemException::failWithErrno(
+                "fs::MappedFile() mmap failed: ");
+        }
+        // Only a hint, so failure is harmless.
+        ::madvise(p, mSize, MADV_SEQUENTIAL);
+        mData = static_cast<char const*>(p);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData)
+    {
+        ::munmap(const_cast<char*>(mData), mSize);
+    }
+}
+
 int
 getMaxConnections()
 {
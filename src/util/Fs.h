@@ -89,6 +89,37 @@ size_t size(std::ifstream& ifs);
 
 size_t size(std::string const& path);
 
+// A read-only memory map of a whole file, unmapped on destruction. The kernel
+// is told the map will be read sequentially, so it reads ahead aggressively.
+// An empty file maps to a null, zero-length region.
+class MappedFile
+{
+    char const* mData{nullptr};
+    size_t mSize{0};
+#ifdef _WIN32
+    HANDLE mFile{INVALID_HANDLE_VALUE};
+    HANDLE mMapping{NULL};
+#endif
+
+  public:
+    explicit MappedFile(std::string const& path);
+    ~MappedFile();
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    char const*
+    data() const
+    {
+        return mData;
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+};
+
 ////
 // Utility functions for constructing path names
 ////
@@ -19,7 +19,7 @@
 namespace stellar
 {
 
-std::array<std::string const, 14> const Logging::kPartitionNames = {
+std::array<std::string const, 15> const Logging::kPartitionNames = {
 #define LOG_PARTITION(name) #name,
 #include "util/LogPartitions.def"
 #undef LOG_PARTITION
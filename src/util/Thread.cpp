@@ -4,6 +4,11 @@
 
 #include "util/Thread.h"
 #include "util/Logging.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <vector>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -79,4 +84,72 @@ runCurrentThreadWithLowPriority()
 }
 
 #endif
+
+static std::atomic<size_t> gParallelForHelpersAvailable{
+    std::max(1u, std::thread::hardware_concurrency())};
+
+static size_t
+reserveParallelForHelpers(size_t wanted)
+{
+    size_t available = gParallelForHelpersAvailable.load();
+    size_t taken;
+    do
+    {
+        taken = std::min(wanted, available);
+    } while (taken != 0 && !gParallelForHelpersAvailable.compare_exchange_weak(
+                               available, available - taken));
+    return taken;
+}
+
+void
+parallelFor(size_t n, size_t maxHelpers, std::function<void(size_t)> const& f)
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr firstError;
+    std::mutex errorMutex;
+
+    auto work = [&]() {
+        for (size_t i = next++; i < n && !failed; i = next++)
+        {
+            try
+            {
+                f(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError)
+                {
+                    firstError = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    size_t numHelpers = reserveParallelForHelpers(std::min(maxHelpers, n - 1));
+    std::vector<std::future<void>> helpers;
+    helpers.reserve(numHelpers);
+    for (size_t i = 0; i < numHelpers; ++i)
+    {
+        helpers.emplace_back(std::async(std::launch::async, work));
+    }
+    work();
+    for (auto& helper : helpers)
+    {
+        helper.wait();
+    }
+    gParallelForHelpersAvailable += numHelpers;
+
+    if (firstError)
+    {
+        std::rethrow_exception(firstError);
+    }
+}
 }
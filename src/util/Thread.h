@@ -5,6 +5,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include <chrono>
+#include <functional>
 #include <future>
 #include <thread>
 
@@ -13,6 +14,15 @@ namespace stellar
 
 void runCurrentThreadWithLowPriority();
 
+// Runs f(0), ..., f(n - 1) on the calling thread and up to maxHelpers helper
+// threads. Helpers are drawn from one process-wide budget of
+// hardware_concurrency threads, so concurrent or nested callers cannot
+// oversubscribe the machine: once the budget is spent, the calling thread does
+// the work alone. Blocks until every call has returned, then rethrows the
+// first exception any of them threw.
+void parallelFor(size_t n, size_t maxHelpers,
+                 std::function<void(size_t)> const& f);
+
 template <typename T>
 bool
 futureIsReady(std::future<T> const& fut)
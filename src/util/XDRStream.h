@@ -14,6 +14,7 @@
 #include <Tracy.hpp>
 
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 #ifdef _WIN32
@@ -84,6 +85,40 @@ class XDRInputFileStream
         return mIn.tellg();
     }
 
+    void
+    seek(size_t pos)
+    {
+        mIn.clear();
+        mIn.seekg(pos);
+    }
+
+    // Advances past the next record without decoding it. Returns false at the
+    // end of the stream.
+    bool
+    skipOne()
+    {
+        ZoneScoped;
+        char szBuf[4];
+        if (!mIn.read(szBuf, 4))
+        {
+            return false;
+        }
+        uint32_t sz = 0;
+        sz |= static_cast<uint8_t>(szBuf[0] & '\x7f');
+        sz <<= 8;
+        sz |= static_cast<uint8_t>(szBuf[1]);
+        sz <<= 8;
+        sz |= static_cast<uint8_t>(szBuf[2]);
+        sz <<= 8;
+        sz |= static_cast<uint8_t>(szBuf[3]);
+        mIn.ignore(sz);
+        if (static_cast<uint32_t>(mIn.gcount()) != sz)
+        {
+            throw xdr::xdr_runtime_error("malformed XDR file");
+        }
+        return true;
+    }
+
     template <typename T>
     bool
     readOne(T& out)
@@ -124,6 +159,123 @@ class XDRInputFileStream
     }
 };
 
+/**
+ * Reads XDR records straight out of a read-only memory map of the file: there
+ * is no read syscall per record, and records are decoded from the mapped pages
+ * without first being copied into a buffer.
+ */
+class XDRMappedInputFileStream
+{
+    std::unique_ptr<fs::MappedFile> mFile;
+    size_t mSizeLimit;
+    size_t mPos{0};
+    bool mGood{false};
+
+    // Reads the size prefix of the record at mPos and checks that the whole
+    // record is in the file. Returns false at the end of the file, or if the
+    // record is larger than mSizeLimit (when set), like XDRInputFileStream.
+    bool
+    readSize(uint32_t& sz)
+    {
+        if (!mFile || mPos + 4 > mFile->size())
+        {
+            mGood = false;
+            return false;
+        }
+        auto const* p =
+            reinterpret_cast<unsigned char const*>(mFile->data() + mPos);
+        sz = (static_cast<uint32_t>(p[0] & 0x7f) << 24) |
+             (static_cast<uint32_t>(p[1]) << 16) |
+             (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+        if (mSizeLimit != 0 && sz > mSizeLimit)
+        {
+            mGood = false;
+            return false;
+        }
+        if (mPos + 4 + sz > mFile->size())
+        {
+            throw xdr::xdr_runtime_error("malformed XDR file");
+        }
+        return true;
+    }
+
+  public:
+    XDRMappedInputFileStream(unsigned int sizeLimit = 0)
+        : mSizeLimit{sizeLimit}
+    {
+    }
+
+    void
+    open(std::string const& filename)
+    {
+        ZoneScoped;
+        mFile = std::make_unique<fs::MappedFile>(filename);
+        mPos = 0;
+        mGood = true;
+    }
+
+    void
+    close()
+    {
+        mFile.reset();
+        mGood = false;
+    }
+
+    operator bool() const
+    {
+        return mGood;
+    }
+
+    size_t
+    size() const
+    {
+        return mFile ? mFile->size() : 0;
+    }
+
+    size_t
+    pos() const
+    {
+        return mPos;
+    }
+
+    void
+    seek(size_t pos)
+    {
+        releaseAssertOrThrow(pos <= size());
+        mPos = pos;
+        mGood = true;
+    }
+
+    bool
+    skipOne()
+    {
+        uint32_t sz;
+        if (!readSize(sz))
+        {
+            return false;
+        }
+        mPos += 4 + sz;
+        return true;
+    }
+
+    template <typename T>
+    bool
+    readOne(T& out)
+    {
+        ZoneScoped;
+        uint32_t sz;
+        if (!readSize(sz))
+        {
+            return false;
+        }
+        char const* body = mFile->data() + mPos + 4;
+        xdr::xdr_get g(body, body + sz);
+        xdr::xdr_argpack_archive(g, out);
+        mPos += 4 + sz;
+        return true;
+    }
+};
+
 // XDROutputFileStream needs access to a file descriptor to do fsync, so we use
 // asio's synchronous stream types here rather than fstreams.
 class XDROutputFileStream
@@ -279,40 +431,22 @@ class XDROutputFileStream
         return isOpen();
     }
 
-    template <typename T>
+    // Writes already-serialized bytes, such as records copied verbatim from
+    // another XDR stream.
     void
-    writeOne(T const& t, SHA256* hasher = nullptr, size_t* bytesPut = nullptr)
+    writeBytes(char const* data, size_t len)
     {
         ZoneScoped;
         if (!isOpen())
         {
             FileSystemException::failWith(
-                "XDROutputFileStream::writeOne() on non-open stream");
+                "XDROutputFileStream::writeBytes() on non-open stream");
         }
-
-        uint32_t sz = (uint32_t)xdr::xdr_size(t);
-        releaseAssertOrThrow(sz < 0x80000000);
-
-        if (mBuf.size() < sz + 4)
-        {
-            mBuf.resize(sz + 4);
-        }
-
-        // Write 4 bytes of size, big-endian, with XDR 'continuation' bit set on
-        // high bit of high byte.
-        mBuf[0] = static_cast<char>((sz >> 24) & 0xFF) | '\x80';
-        mBuf[1] = static_cast<char>((sz >> 16) & 0xFF);
-        mBuf[2] = static_cast<char>((sz >> 8) & 0xFF);
-        mBuf[3] = static_cast<char>(sz & 0xFF);
-        xdr::xdr_put p(mBuf.data() + 4, mBuf.data() + 4 + sz);
-        xdr_argpack_archive(p, t);
-
-        size_t const to_write = sz + 4;
         size_t written = 0;
-        while (written < to_write)
+        while (written < len)
         {
             asio::error_code ec;
-            auto buf = asio::buffer(mBuf.data() + written, to_write - written);
+            auto buf = asio::buffer(data + written, len - written);
 #ifdef _WIN32
             // Calling asio::write_at on the asio::posix::stream_descriptor
             // will not even compile; so this one bit has to also be platform
@@ -339,11 +473,42 @@ class XDROutputFileStream
                 {
                     FileSystemException::failWith(
                         std::string(
-                            "XDROutputFileStream::writeOne() failed: ") +
+                            "XDROutputFileStream::writeBytes() failed: ") +
                         ec.message());
                 }
             }
         }
+    }
+
+    template <typename T>
+    void
+    writeOne(T const& t, SHA256* hasher = nullptr, size_t* bytesPut = nullptr)
+    {
+        ZoneScoped;
+        if (!isOpen())
+        {
+            FileSystemException::failWith(
+                "XDROutputFileStream::writeOne() on non-open stream");
+        }
+
+        uint32_t sz = (uint32_t)xdr::xdr_size(t);
+        releaseAssertOrThrow(sz < 0x80000000);
+
+        if (mBuf.size() < sz + 4)
+        {
+            mBuf.resize(sz + 4);
+        }
+
+        // Write 4 bytes of size, big-endian, with XDR 'continuation' bit set on
+        // high bit of high byte.
+        mBuf[0] = static_cast<char>((sz >> 24) & 0xFF) | '\x80';
+        mBuf[1] = static_cast<char>((sz >> 16) & 0xFF);
+        mBuf[2] = static_cast<char>((sz >> 8) & 0xFF);
+        mBuf[3] = static_cast<char>(sz & 0xFF);
+        xdr::xdr_put p(mBuf.data() + 4, mBuf.data() + 4 + sz);
+        xdr_argpack_archive(p, t);
+
+        writeBytes(mBuf.data(), sz + 4);
         if (hasher)
         {
             hasher->add(ByteSlice(mBuf.data(), sz + 4));
@@ -11,6 +11,7 @@
 #include <fmt/format.h>
 
 #include <chrono>
+#include <filesystem>
 
 using namespace stellar;
 
@@ -44,6 +45,91 @@ TEST_CASE("XDROutputFileStream fail modes", "[xdrstream]")
     }
 }
 
+TEST_CASE("XDRMappedInputFileStream reads what was written", "[xdrstream]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig(0);
+    fs::mkpath(cfg.BUCKET_DIR_PATH);
+    auto filename = fmt::format("{}/mapped.xdr", cfg.BUCKET_DIR_PATH);
+
+    auto ledgerEntries = LedgerTestUtils::generateValidLedgerEntries(100);
+    auto bucketEntries =
+        Bucket::convertToBucketEntry(false, {}, ledgerEntries, {});
+
+    std::vector<size_t> offsets;
+    {
+        XDROutputFileStream out(clock.getIOContext(), /*doFsync=*/false);
+        out.open(filename);
+        size_t bytes = 0;
+        for (auto const& e : bucketEntries)
+        {
+            offsets.emplace_back(bytes);
+            out.writeOne(e, nullptr, &bytes);
+        }
+        out.close();
+    }
+
+    XDRMappedInputFileStream in;
+    in.open(filename);
+    REQUIRE(in.size() == fs::size(filename));
+
+    SECTION("sequential reads")
+    {
+        BucketEntry be;
+        for (size_t i = 0; i < bucketEntries.size(); ++i)
+        {
+            REQUIRE(in.pos() == offsets[i]);
+            REQUIRE(in.readOne(be));
+            REQUIRE(be == bucketEntries[i]);
+        }
+        REQUIRE(in.pos() == in.size());
+        REQUIRE(!in.readOne(be));
+        REQUIRE(!in);
+    }
+    SECTION("seek and skip")
+    {
+        BucketEntry be;
+        in.seek(offsets[50]);
+        REQUIRE(in.skipOne());
+        REQUIRE(in.pos() == offsets[51]);
+        REQUIRE(in.readOne(be));
+        REQUIRE(be == bucketEntries[51]);
+        in.seek(offsets[0]);
+        REQUIRE(in.readOne(be));
+        REQUIRE(be == bucketEntries[0]);
+    }
+    SECTION("size limit")
+    {
+        // every record is larger than 4 bytes
+        XDRMappedInputFileStream limited(4);
+        limited.open(filename);
+        BucketEntry be;
+        REQUIRE(!limited.readOne(be));
+        REQUIRE(!limited);
+        REQUIRE(limited.pos() == 0);
+    }
+    SECTION("truncated record throws")
+    {
+        in.close();
+        std::filesystem::resize_file(filename, offsets.back() + 6);
+        in.open(filename);
+        in.seek(offsets.back());
+        BucketEntry be;
+        REQUIRE_THROWS_AS(in.readOne(be), xdr::xdr_runtime_error);
+    }
+    SECTION("empty file")
+    {
+        in.close();
+        std::filesystem::resize_file(filename, 0);
+        in.open(filename);
+        BucketEntry be;
+        REQUIRE(in.size() == 0);
+        REQUIRE(!in.readOne(be));
+    }
+    in.close();
+    std::remove(filename.c_str());
+}
+
 TEST_CASE("XDROutputFileStream fsync bench", "[!hide][xdrstream][bench]")
 {
     VirtualClock clock;
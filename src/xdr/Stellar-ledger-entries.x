@@ -497,9 +497,64 @@ struct LiquidityPoolEntry
     body;
 };
 
+struct SpeedexClearingValuation
+{
+    Asset asset;
+    uint64 price;
+};
+
+// Tatonnement stops once its objective has gone stagnationRounds rounds
+// without improving on its best value by more than tolN / tolD.
+// stagnationRounds = 0 disables the check, as does tolD outside 1..255 or
+// tolN > tolD.
+struct SpeedexStagnationParams
+{
+    uint32 stagnationRounds;
+    uint32 tolN;
+    uint32 tolD;
+};
+
+struct SpeedexConfigEntryExtensionV2
+{
+    SpeedexStagnationParams stagnation;
+
+    union switch (int v)
+    {
+    case 0:
+        void;
+    }
+    ext;
+};
+
+struct SpeedexConfigEntryExtensionV1
+{
+    // prices the most recent batch cleared at, rewritten each ledger;
+    // seeds the next ledger's tatonnement
+    SpeedexClearingValuation lastValuations<>;
+
+    // without v2, stagnation is 100 rounds and 1 / 100
+    union switch (int v)
+    {
+    case 0:
+        void;
+    case 2:
+        SpeedexConfigEntryExtensionV2 v2;
+    }
+    ext;
+};
+
 struct SpeedexConfigEntry
 {
     Asset speedexAssets<>;  
+
+    union switch (int v)
+    {
+    case 0:
+        void;
+    case 1:
+        SpeedexConfigEntryExtensionV1 v1;
+    }
+    ext;
 };
 
 struct LedgerEntryExtensionV1
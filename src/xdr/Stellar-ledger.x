@@ -208,12 +208,6 @@ struct SpeedexLiquidityPoolClearingStatus
     int64 boughtAmount;
 };
 
-struct SpeedexClearingValuation
-{
-    Asset asset;
-    uint64 price;
-};
-
 struct SpeedexResults {
     SpeedexClearingValuation valuations<>;
     SpeedexOfferClearingStatus offerStatuses<>;